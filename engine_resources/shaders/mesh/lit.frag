@@ -30,7 +30,7 @@ uniform int lightNB;
 
 uniform vec3 camPos;
 
-uniform bool masked;
+// Variants : MASKED, RECEIVE_SHADOWS, NORMAL_MAP and RECONSTRUCT_NORMAL_Z are defined per material
 
 // Shadow maps
 
@@ -208,17 +208,27 @@ vec3 computeLightDisney(Light light, vec3 L, vec3 V, vec3 N, vec3 baseColor, flo
 void main() {
     vec4 baseColor = texture(albedo, texCoord);
 
-    if (masked && baseColor.a < 0.5)
+#ifdef MASKED
+    if (baseColor.a < 0.5)
         discard;
+#endif
 
     float metallicValue = texture(metallicMap, texCoord).r * metallic;
     float roughnessValue = texture(roughnessMap, texCoord).r * roughness;
 
+#ifdef NORMAL_MAP
     vec3 normalFromMap = texture(normalMap, texCoord).rgb;
     normalFromMap = normalFromMap * 2.0 - 1.0;
+#ifdef RECONSTRUCT_NORMAL_Z
+    // Two channel normal maps (BC5 when cooked) only store xy, z is rebuilt from the unit length
+    normalFromMap.z = sqrt(max(1.0 - dot(normalFromMap.xy, normalFromMap.xy), 0.0));
+#endif
 
     mat3 TBN = mat3(T, B, N);
     vec3 worldNormal = normalize(TBN * normalFromMap);
+#else
+    vec3 worldNormal = normalize(N);
+#endif
 
     vec3 V = normalize(camPos - worldPos);
     vec3 result = vec3(0.0);
@@ -234,10 +244,12 @@ void main() {
 
         if (l.type == 0) { // Directional
             L = normalize(-l.direction);
+#ifdef RECEIVE_SHADOWS
             if (l.castShadow) {
                 int cascadeIdx = selectCascade(dirIdx);
                 shadow = ShadowCalculationCSM(shadow_dirShadowMaps[cascadeIdx], shadow_dirLightSpaceMatrices[cascadeIdx], l.direction, worldPos, worldNormal);
             }
+#endif
         }
         else if (l.type == 1) { // Point
             vec3 toLight = l.position - worldPos;
@@ -247,10 +259,12 @@ void main() {
             attenuation = clamp(1.0 - (dist / l.radius), 0.0, 1.0);
             attenuation *= attenuation;
 
+#ifdef RECEIVE_SHADOWS
             if (l.castShadow){
                 shadow = ShadowPointArray(pointIdx, l.position, worldPos, shadow_pointLightFarPlanes[pointIdx]);
                 pointIdx++;
             }
+#endif
         }
         else if (l.type == 2) { // Spot
             
@@ -271,13 +285,21 @@ void main() {
             attenuation *= attenuation;
             attenuation *= spotEffect;
 
+#ifdef RECEIVE_SHADOWS
             if (l.castShadow) {
                 shadow = ShadowCalculation(shadow_spotShadowMaps[spotIdx], l.direction, shadow_spotLightSpaceMatrices[spotIdx], worldNormal);
                 spotIdx++;
             }
+#endif
 
         }
 
+#ifndef RECEIVE_SHADOWS
+        // Nothing occludes the shadow casting lights of materials that don't receive shadows
+        if (l.castShadow)
+            shadow = 0.0;
+#endif
+
         result += computeLightDisney(l, L, V, worldNormal, baseColor.rgb, roughnessValue, metallicValue, shadow, attenuation);
     }
 
@@ -12,21 +12,25 @@ uniform sampler2D diffuse;
 uniform bool useCustomColor;
 uniform vec4 customColor;
 
-uniform bool masked;
+// Variants : MASKED is defined per material
 
 void main(){
     if(useTexture){
         vec4 baseColor = texture(diffuse, texCoord);
         
-        if (masked && baseColor.a < 0.5)
+#ifdef MASKED
+        if (baseColor.a < 0.5)
             discard;
+#endif
 
         fragColor = baseColor;
     }
     else if(useCustomColor){
         
-        if (masked && customColor.a < 0.5)
+#ifdef MASKED
+        if (customColor.a < 0.5)
             discard;
+#endif
 
         fragColor = customColor;
     }
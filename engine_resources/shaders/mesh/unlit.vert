@@ -4,26 +4,74 @@ layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec4 aColor;
 layout (location = 3) in vec2 aTexCoord;
-layout (location = 4) in vec2 aTangent;
+layout (location = 4) in vec3 aTangent;
+layout (location = 5) in uint aDrawID;
 
 uniform mat4 model;
 uniform mat4 projection;
 uniform mat4 view;
 
+uniform vec3 posScale = vec3(1.0);
+uniform vec3 posOffset = vec3(0.0);
+uniform vec4 meshColor = vec4(1.0);
+
+// Per draw data of the multi-draw indirect path, indexed by the instance draw ID
+struct DrawData {
+    mat4 model;
+    vec4 posScale;
+    vec4 posOffset;
+    vec4 color;
+    uvec4 misc;     // x : material index
+};
+
+layout(std430, binding = 1) readonly buffer DrawDataBuffer {
+    DrawData draws[];
+};
+
 out vec2 texCoord;
 out vec4 color;
 out vec3 worldPos;
 out vec3 worldNormal;
 
+// Octahedral decoding of the compact vertex normals and tangents
+vec3 OctDecode(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+
 void main()
 {
-    texCoord = aTexCoord;
+    mat4 modelMatrix = model;
+    vec3 scale = posScale;
+    vec3 offset = posOffset;
+    vec4 baseColor = meshColor;
+
+#ifdef DRAW_DATA
+    DrawData data = draws[aDrawID];
+    modelMatrix = data.model;
+    scale = data.posScale.xyz;
+    offset = data.posOffset.xyz;
+    baseColor = data.color;
+#endif
+
+#ifdef COMPACT_VERTEX
+    vec3 normal = OctDecode(aNormal.xy);
+    color = baseColor;
+#else
+    vec3 normal = aNormal;
     color = aColor;
+#endif
+
+    texCoord = aTexCoord;
     
-    vec4 world = model * vec4(aPos, 1.0);
+    vec4 world = modelMatrix * vec4(aPos * scale + offset, 1.0);
     worldPos = world.xyz;
 
-    worldNormal = normalize(mat3(model) * aNormal);
+    worldNormal = normalize(mat3(modelMatrix) * normal);
 
     gl_Position = projection * view * world;
 }
\ No newline at end of file
@@ -3,7 +3,9 @@
 layout(location = 0) in vec3 aPos;
 
 uniform mat4 model;
+uniform vec3 posScale = vec3(1.0);
+uniform vec3 posOffset = vec3(0.0);
 
 void main() {
-    gl_Position = model * vec4(aPos, 1.0);
+    gl_Position = model * vec4(aPos * posScale + posOffset, 1.0);
 }
\ No newline at end of file
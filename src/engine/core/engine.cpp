@@ -5,6 +5,7 @@
 #include <thread>
 
 #include "engine/core/resources/resources_manager.hpp"
+#include "engine/core/jobs/job_system.hpp"
 
 
 using namespace std::chrono;
@@ -26,8 +27,24 @@ namespace Epoch::Engine::Core{
         FileManager::Init(settings.rootPath);
         PhysicsSystem::Init(settings.gravity);
         AudioManager::GetInstance().Init(100.0f);
-        Renderer::GetInstance().Init(window);
+        RendererSettings rendererSettings;
+        rendererSettings.multiDrawIndirect = settings.multiDrawIndirect;
+        rendererSettings.textureStreaming.enabled = settings.streamTextures;
+        rendererSettings.textureStreaming.memoryBudget = settings.textureBudgetMB * 1024 * 1024;
+        rendererSettings.uploads.textureBytesPerFrame = settings.uploadBudgetMB * 1024 * 1024;
+        rendererSettings.uploads.bufferBytesPerFrame = settings.uploadBudgetMB * 1024 * 1024;
+        rendererSettings.shaderCacheDirectory = settings.shaderCacheDirectory;
+        Renderer::GetInstance().Init(window, rendererSettings);
+        Jobs::JobSystem::GetInstance().Init(settings.workerThreads);
+        Resources::ResourcesManager::GetInstance().meshImportSettings.compactVertices = settings.compactMeshes;
+        Resources::ResourcesManager::GetInstance().parallelImport = settings.parallelImport;
+        Resources::ResourcesManager::GetInstance().budgets.meshBytes = settings.meshMemoryMB * 1024 * 1024;
+        Resources::ResourcesManager::GetInstance().budgets.textureBytes = settings.textureMemoryMB * 1024 * 1024;
+        Resources::ResourcesManager::GetInstance().lazyLoading = settings.lazyLoading;
         Resources::ResourcesManager::GetInstance().LoadResources(Filesystem::Path("project_resources"), Filesystem::Path("engine_resources"));
+        Resources::ResourcesManager::GetInstance().Preload(settings.preloadLevels);
+        if (settings.hotReload)
+            Resources::ResourcesManager::GetInstance().WatchForChanges({ Filesystem::Path("engine_resources"), Filesystem::Path("project_resources") });
         Renderer::GetInstance().InitFramebuffers();
         GetInputManager().Init(window);
         EventDispatcher::GetInstance();
@@ -114,7 +131,9 @@ namespace Epoch::Engine::Core{
         AudioManager::GetInstance().Shutdown();
         PhysicsSystem::Shutdown();
         LevelManager::GetInstance().UnloadAllLevels();
+        Resources::ResourcesManager::GetInstance().Clear();
         Renderer::GetInstance().Shutdown();
+        Jobs::JobSystem::GetInstance().Shutdown();
         DestroyWindow();
     }
 
@@ -126,12 +145,24 @@ namespace Epoch::Engine::Core{
 
         glfwPollEvents();
 
+        // GL side of the background jobs (streamed textures...)
+        Jobs::JobSystem::GetInstance().ProcessMainThreadTasks();
+
+        // Edited shaders, materials, textures and models, before their next draw
+        Resources::ResourcesManager::GetInstance().ReloadChangedFiles();
+
         Renderer::GetInstance().Render();
         AudioManager::GetInstance().Tick();
         GetInputManager().Tick();
 
         LevelManager::GetInstance().Tick();
 
+        // Resources released by unloaded levels, checked once per second
+        if (glfwGetTime() - lastResourceSweep > 1.0) {
+            lastResourceSweep = glfwGetTime();
+            Resources::ResourcesManager::GetInstance().UnloadUnused();
+        }
+
         glfwSwapBuffers(window);
 
         if(GetInputManager().WasKeyPressed(KEY_ESCAPE))
@@ -21,6 +21,25 @@ namespace Epoch::Engine::Core {
         //FILESYSTEM
         std::string rootPath = "";
 
+        //RENDERING
+        bool multiDrawIndirect = false;
+        bool streamTextures = true;
+        size_t textureBudgetMB = 512;
+        size_t uploadBudgetMB = 16;     // Texture bytes, and buffer bytes, copied to the GPU per frame
+        std::string shaderCacheDirectory = "shader_cache";     // Empty compiles every shader on each start
+
+        //RESOURCES
+        bool compactMeshes = false;
+        bool parallelImport = true;
+        size_t meshMemoryMB = 0;        // Unused meshes and textures are unloaded past these budgets, 0 keeps everything loaded
+        size_t textureMemoryMB = 0;
+        bool hotReload = false;         // Reload the changed resource files while running
+        bool lazyLoading = false;       // Only index the resources at startup, they load on first use
+        std::vector<std::string> preloadLevels;     // Loaded at startup with everything they reference, in parallel
+
+        //JOBS
+        unsigned int workerThreads = 0;     // 0 uses every hardware thread but the main one
+
         //PHYSICS
         glm::vec3 gravity = glm::vec3(0, -9.81f, 0);
     };
@@ -44,5 +63,7 @@ namespace Epoch::Engine::Core {
 
         GLFWwindow* window;
 
+        double lastResourceSweep = 0.0;
+
     };
 }
\ No newline at end of file
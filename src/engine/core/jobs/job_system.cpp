@@ -0,0 +1,206 @@
+#include "job_system.hpp"
+
+#include "engine/debugging/debugger.hpp"
+
+#include <chrono>
+
+namespace Epoch::Engine::Core::Jobs{
+
+    struct JobState {
+        std::function<void()> work;
+        std::atomic<int> pendingDependencies = 1;   // Starts with a guard released once the job is fully scheduled
+        std::mutex mutex;
+        bool done = false;
+        std::vector<std::shared_ptr<JobState>> dependents;
+    };
+
+    bool JobHandle::IsDone() const
+    {
+        if (!state)
+            return true;
+        std::lock_guard<std::mutex> lock(state->mutex);
+        return state->done;
+    }
+
+    /// @brief Starts the worker threads
+    /// @param workerCount The number of workers, 0 uses every hardware thread but the main one
+    void JobSystem::Init(unsigned int workerCount)
+    {
+        if (running)
+            return;
+
+        if (workerCount == 0) {
+            unsigned int hardwareThreads = std::thread::hardware_concurrency();
+            workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+        }
+
+        mainThreadID = std::this_thread::get_id();
+        running = true;
+
+        for (unsigned int i = 0; i < workerCount; i++)
+            workers.emplace_back(&JobSystem::WorkerLoop, this);
+
+        DEBUG_INFO("Job system started with " + std::to_string(workerCount) + " workers");
+    }
+
+    /// @brief Finishes the queued jobs and joins the workers
+    void JobSystem::Shutdown()
+    {
+        if (!running)
+            return;
+
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            running = false;
+        }
+        queueCondition.notify_all();
+
+        for (std::thread& worker : workers)
+            worker.join();
+        workers.clear();
+
+        // Jobs scheduled after the workers stopped are run here
+        while (RunOneJob()) {}
+        ProcessMainThreadTasks();
+    }
+
+    /// @brief Schedules a job on the workers
+    /// @param job The work to run, it must not call GL
+    /// @param dependencies Jobs that have to complete before this one starts
+    /// @return A handle to wait on the job or to pass as a dependency
+    JobHandle JobSystem::Schedule(std::function<void()> job, const std::vector<JobHandle> &dependencies)
+    {
+        JobHandle handle;
+        handle.state = std::make_shared<JobState>();
+        handle.state->work = std::move(job);
+
+        for (const JobHandle& dependency : dependencies) {
+            if (!dependency.state)
+                continue;
+
+            std::lock_guard<std::mutex> lock(dependency.state->mutex);
+            if (!dependency.state->done) {
+                handle.state->pendingDependencies++;
+                dependency.state->dependents.push_back(handle.state);
+            }
+        }
+
+        if (--handle.state->pendingDependencies == 0)
+            Enqueue(handle.state);
+
+        return handle;
+    }
+
+    /// @brief Blocks until a job is done. The calling thread runs queued jobs meanwhile, and main thread tasks when it is the main thread
+    void JobSystem::Wait(const JobHandle &handle)
+    {
+        while (!handle.IsDone()) {
+            if (IsMainThread() && ProcessMainThreadTasks() > 0)
+                continue;
+            if (RunOneJob())
+                continue;
+
+            std::unique_lock<std::mutex> lock(waitMutex);
+            waitCondition.wait_for(lock, std::chrono::milliseconds(1));
+        }
+    }
+
+    void JobSystem::WaitAll(const std::vector<JobHandle> &handles)
+    {
+        for (const JobHandle& handle : handles)
+            Wait(handle);
+    }
+
+    /// @brief Queues a task (typically a GL upload) executed by the next ProcessMainThreadTasks or main thread Wait
+    void JobSystem::RunOnMainThread(std::function<void()> task)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mainThreadMutex);
+            mainThreadTasks.push_back(std::move(task));
+        }
+        waitCondition.notify_all();
+    }
+
+    /// @brief Runs every queued main thread task, must be called from the main thread
+    /// @return The number of tasks executed
+    size_t JobSystem::ProcessMainThreadTasks()
+    {
+        size_t executed = 0;
+
+        while (true) {
+            std::function<void()> task;
+            {
+                std::lock_guard<std::mutex> lock(mainThreadMutex);
+                if (mainThreadTasks.empty())
+                    break;
+                task = std::move(mainThreadTasks.front());
+                mainThreadTasks.pop_front();
+            }
+            task();
+            executed++;
+        }
+
+        return executed;
+    }
+
+    void JobSystem::WorkerLoop()
+    {
+        while (true) {
+            std::shared_ptr<JobState> job;
+            {
+                std::unique_lock<std::mutex> lock(queueMutex);
+                queueCondition.wait(lock, [this]() { return !running || !readyJobs.empty(); });
+                if (readyJobs.empty())
+                    return;
+                job = std::move(readyJobs.front());
+                readyJobs.pop_front();
+            }
+
+            job->work();
+            Complete(job);
+        }
+    }
+
+    bool JobSystem::RunOneJob()
+    {
+        std::shared_ptr<JobState> job;
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            if (readyJobs.empty())
+                return false;
+            job = std::move(readyJobs.front());
+            readyJobs.pop_front();
+        }
+
+        job->work();
+        Complete(job);
+        return true;
+    }
+
+    void JobSystem::Enqueue(std::shared_ptr<JobState> job)
+    {
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            readyJobs.push_back(std::move(job));
+        }
+        queueCondition.notify_one();
+    }
+
+    /// @brief Marks a job as done and releases the jobs waiting on it
+    void JobSystem::Complete(const std::shared_ptr<JobState> &job)
+    {
+        std::vector<std::shared_ptr<JobState>> dependents;
+        {
+            std::lock_guard<std::mutex> lock(job->mutex);
+            job->done = true;
+            job->work = nullptr;
+            dependents.swap(job->dependents);
+        }
+
+        for (std::shared_ptr<JobState>& dependent : dependents)
+            if (--dependent->pendingDependencies == 0)
+                Enqueue(std::move(dependent));
+
+        waitCondition.notify_all();
+    }
+}
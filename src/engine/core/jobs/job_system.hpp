@@ -0,0 +1,77 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+namespace Epoch::Engine::Core::Jobs{
+
+    struct JobState;
+
+    // Reference to a scheduled job, used to wait on it or to make other jobs depend on it
+    class JobHandle {
+        public:
+            bool IsValid() const { return state != nullptr; }
+            bool IsDone() const;
+
+        private:
+            std::shared_ptr<JobState> state;
+            friend class JobSystem;
+    };
+
+    // Worker thread pool running independent CPU work (file reads, decoding, mesh processing).
+    // GL calls must stay on the main thread, workers hand them over with RunOnMainThread
+    class JobSystem{
+        public:
+            static JobSystem& GetInstance() {
+                static JobSystem instance;
+                return instance;
+            }
+
+            void Init(unsigned int workerCount = 0);
+            void Shutdown();
+
+            JobHandle Schedule(std::function<void()> job, const std::vector<JobHandle>& dependencies = {});
+
+            void Wait(const JobHandle& handle);
+            void WaitAll(const std::vector<JobHandle>& handles);
+
+            void RunOnMainThread(std::function<void()> task);
+            size_t ProcessMainThreadTasks();
+
+            bool IsMainThread() const { return std::this_thread::get_id() == mainThreadID; }
+
+            unsigned int GetWorkerCount() const { return static_cast<unsigned int>(workers.size()); }
+
+        private:
+            JobSystem() = default;
+            ~JobSystem() = default;
+            JobSystem(const JobSystem&) = delete;
+            JobSystem& operator=(const JobSystem&) = delete;
+
+            void WorkerLoop();
+            bool RunOneJob();
+            void Enqueue(std::shared_ptr<JobState> job);
+            void Complete(const std::shared_ptr<JobState>& job);
+
+            std::vector<std::thread> workers;
+            std::thread::id mainThreadID = std::this_thread::get_id();
+            bool running = false;
+
+            std::deque<std::shared_ptr<JobState>> readyJobs;
+            std::mutex queueMutex;
+            std::condition_variable queueCondition;
+
+            std::deque<std::function<void()>> mainThreadTasks;
+            std::mutex mainThreadMutex;
+
+            // Signaled when a job completes or a main thread task is queued
+            std::mutex waitMutex;
+            std::condition_variable waitCondition;
+    };
+}
@@ -0,0 +1,158 @@
+#include "asset_manifest.hpp"
+
+#include "engine/debugging/debugger.hpp"
+
+#include <nlohmann/json.hpp>
+
+#include <filesystem>
+
+namespace Epoch::Engine::Core::Resources{
+
+    using namespace Filesystem;
+
+    /// @brief Adds the resources of a directory, names already listed (from a previous directory) are kept
+    void AssetManifest::Scan(const Path &baseDir)
+    {
+        for (FileInfo infos : FileManager::ListDirectory(baseDir, {Type::T_IMAGE, Type::T_SHADER, Type::T_MODEL, Type::T_MATERIAL, Type::T_LEVEL}, false, true)) {
+            AssetEntry entry;
+            entry.path = infos.path;
+            entry.size = infos.size > 0 ? static_cast<size_t>(infos.size) : 0;
+
+            switch (infos.path.GetExtensionType()) {
+                case Type::T_IMAGE:
+                    entry.type = ResourceType::Texture;
+                    entry.name = infos.path.RelativeTo(baseDir).full;
+                    break;
+
+                case Type::T_SHADER: {
+                    // One entry per program, listed from whichever stage comes first
+                    entry.type = ResourceType::Shader;
+                    entry.name = infos.path.RelativeTo(baseDir).WithoutExtension();
+                    if (Find(entry.type, entry.name))
+                        continue;
+
+                    std::string stem = (std::filesystem::path(infos.path.GetParent()) / infos.name).string();
+                    Path vertPath(stem + ".vert"), fragPath(stem + ".frag"), geomPath(stem + ".geom");
+                    if (!vertPath.Exists() || !fragPath.Exists()) {
+                        DEBUG_ERROR("Shader loading failed. Missing .vert or .frag file in directory.");
+                        continue;
+                    }
+
+                    entry.path = vertPath;
+                    entry.size = vertPath.GetFileSize() + fragPath.GetFileSize() + (geomPath.Exists() ? geomPath.GetFileSize() : 0);
+                    break;
+                }
+
+                case Type::T_MODEL:
+                    entry.type = ResourceType::Model;
+                    entry.name = infos.path.RelativeTo(baseDir).full;
+                    break;
+
+                case Type::T_MATERIAL: {
+                    entry.type = ResourceType::Material;
+                    entry.name = infos.path.RelativeTo(baseDir).WithoutExtension();
+
+                    nlohmann::json data = nlohmann::json::parse(infos.path.ReadFile(), nullptr, false);
+                    if (data.is_discarded())
+                        break;
+
+                    if (data.contains("shader") && data["shader"].is_string())
+                        entry.dependencies.push_back({ ResourceType::Shader, data["shader"].get<std::string>() });
+
+                    if (data.contains("uniforms"))
+                        for (const auto& uniform : data["uniforms"])
+                            for (auto it = uniform.begin(); it != uniform.end(); ++it)
+                                if (it.value().is_string())
+                                    entry.dependencies.push_back({ ResourceType::Texture, it.value().get<std::string>() });
+                    break;
+                }
+
+                case Type::T_LEVEL: {
+                    entry.type = ResourceType::Level;
+                    entry.name = infos.path.RelativeTo(baseDir).full;
+
+                    nlohmann::json data = nlohmann::json::parse(infos.path.ReadFile(), nullptr, false);
+                    if (data.is_discarded())
+                        break;
+
+                    if (data.contains("meshes"))
+                        for (const auto& [key, mesh] : data["meshes"].items())
+                            if (mesh.is_string())
+                                entry.dependencies.push_back({ ResourceType::Model, GetMeshModel(mesh.get<std::string>()) });
+
+                    // Fallback of the model components
+                    entry.dependencies.push_back({ ResourceType::Material, "materials\\default" });
+                    if (data.contains("materials"))
+                        for (const auto& [key, material] : data["materials"].items())
+                            if (material.is_string())
+                                entry.dependencies.push_back({ ResourceType::Material, material.get<std::string>() });
+                    break;
+                }
+
+                default:
+                    continue;
+            }
+
+            Add(std::move(entry));
+        }
+    }
+
+    void AssetManifest::Add(AssetEntry entry)
+    {
+        ResourceKey key{ entry.type, entry.name };
+        if (indices.find(key) != indices.end())
+            return;
+
+        indices[key] = entries.size();
+        entries.push_back(std::move(entry));
+    }
+
+    void AssetManifest::Clear()
+    {
+        entries.clear();
+        indices.clear();
+    }
+
+    const AssetEntry *AssetManifest::Find(ResourceType type, const std::string &name) const
+    {
+        auto it = indices.find({ type, name });
+        return it != indices.end() ? &entries[it->second] : nullptr;
+    }
+
+    std::vector<const AssetEntry *> AssetManifest::GetLoadOrder(ResourceType type, const std::string &name) const
+    {
+        std::vector<const AssetEntry*> order;
+        std::map<ResourceKey, bool> visited;
+        GatherLoadOrder({ type, name }, order, visited);
+        return order;
+    }
+
+    void AssetManifest::GatherLoadOrder(const ResourceKey &key, std::vector<const AssetEntry *> &order, std::map<ResourceKey, bool> &visited) const
+    {
+        if (visited[key])
+            return;
+        visited[key] = true;
+
+        const AssetEntry* entry = Find(key.first, key.second);
+        if (!entry)
+            return;
+
+        for (const ResourceKey& dependency : entry->dependencies)
+            GatherLoadOrder(dependency, order, visited);
+        order.push_back(entry);
+    }
+
+    size_t AssetManifest::GetTotalSize() const
+    {
+        size_t size = 0;
+        for (const AssetEntry& entry : entries)
+            size += entry.size;
+        return size;
+    }
+
+    std::string AssetManifest::GetMeshModel(const std::string &meshName)
+    {
+        size_t separator = meshName.find(':');
+        return separator == std::string::npos ? meshName : meshName.substr(0, separator);
+    }
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "engine/filesystem/filesystem.hpp"
+
+#include <string>
+#include <vector>
+#include <map>
+
+namespace Epoch::Engine::Core::Resources{
+
+    enum class ResourceType {
+        Mesh,
+        Model,
+        Texture,
+        Shader,
+        Material,
+        Level,
+        Count
+    };
+
+    using ResourceKey = std::pair<ResourceType, std::string>;
+
+    struct AssetEntry {
+        ResourceType type = ResourceType::Count;
+        std::string name;                           // Name used by the Get* functions
+        Filesystem::Path path;                      // The .vert file for shaders
+        size_t size = 0;                            // Bytes on disk, every stage for shaders
+        std::vector<ResourceKey> dependencies;      // Resources looked up while loading it (materials and levels)
+    };
+
+    // Every resource of a set of directories, listed without loading them. Only materials and levels are read, for their dependencies
+    class AssetManifest {
+        public:
+            void Scan(const Filesystem::Path& baseDir);
+            void Clear();
+
+            const AssetEntry* Find(ResourceType type, const std::string& name) const;
+
+            /// @brief Lists an asset and everything it needs, dependencies first
+            std::vector<const AssetEntry*> GetLoadOrder(ResourceType type, const std::string& name) const;
+
+            const std::vector<AssetEntry>& GetEntries() const { return entries; }
+            size_t GetTotalSize() const;
+
+            /// @brief Name of the model owning a mesh name, "file:node" for the meshes of a scene
+            static std::string GetMeshModel(const std::string& meshName);
+
+        private:
+            void Add(AssetEntry entry);
+            void GatherLoadOrder(const ResourceKey& key, std::vector<const AssetEntry*>& order, std::map<ResourceKey, bool>& visited) const;
+
+            std::vector<AssetEntry> entries;
+            std::map<ResourceKey, size_t> indices;
+    };
+}
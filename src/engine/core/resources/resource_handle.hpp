@@ -0,0 +1,41 @@
+#pragma once
+
+#include "engine/core/resources/asset_manifest.hpp"
+
+#include <cstdint>
+
+namespace Epoch::Engine::Rendering{
+    class Mesh;
+    struct ModelAsset;
+    class Texture;
+    class Shader;
+    class Material;
+}
+
+namespace Epoch::Engine::Levels{
+    class Level;
+}
+
+namespace Epoch::Engine::Core::Resources{
+
+    template<typename T> struct ResourceTypeOf;
+    template<> struct ResourceTypeOf<Rendering::Mesh> { static constexpr ResourceType value = ResourceType::Mesh; };
+    template<> struct ResourceTypeOf<Rendering::ModelAsset> { static constexpr ResourceType value = ResourceType::Model; };
+    template<> struct ResourceTypeOf<Rendering::Texture> { static constexpr ResourceType value = ResourceType::Texture; };
+    template<> struct ResourceTypeOf<Rendering::Shader> { static constexpr ResourceType value = ResourceType::Shader; };
+    template<> struct ResourceTypeOf<Rendering::Material> { static constexpr ResourceType value = ResourceType::Material; };
+    template<> struct ResourceTypeOf<Levels::Level> { static constexpr ResourceType value = ResourceType::Level; };
+
+    // Index of a named resource in the manager's slot array. A handle keeps pointing to the same name
+    // when the resource is reloaded, unloaded or cleared, resolving it loads the resource back if needed
+    template<typename T>
+    struct Handle {
+        static constexpr ResourceType type = ResourceTypeOf<T>::value;
+
+        uint32_t index = UINT32_MAX;
+
+        bool IsValid() const { return index != UINT32_MAX; }
+        bool operator==(Handle other) const { return index == other.index; }
+        bool operator!=(Handle other) const { return index != other.index; }
+    };
+}
@@ -4,87 +4,178 @@
 
 #include "engine/serialization/level/level_serializer.hpp"
 
+#include "engine/core/jobs/job_system.hpp"
+
+#include "engine/rendering/texture/texture_streamer.hpp"
+#include "engine/rendering/texture/texture_cooker.hpp"
+
+#include "engine/levels/level_manager.hpp"
+
+#include "engine/ecs/components/rendering/model_component.hpp"
+
+#include <chrono>
+
 namespace Epoch::Engine::Core::Resources{
 
     using namespace Filesystem;
 
+    /// @brief Loads every resource of a directory, see LoadEntries
     void ResourcesManager::LoadResourcesInDir(const Filesystem::Path &baseDir){
-        
-        for(Filesystem::FileInfo infos : Filesystem::FileManager::ListDirectory(baseDir, {Type::T_IMAGE, Type::T_SHADER}, false, true)){
-            switch(infos.path.GetExtensionType()){
-                case Type::T_IMAGE:{
-                    std::string textureName = infos.path.RelativeTo(baseDir).full;
+
+        // Names already listed by a previous directory are skipped by the scan, as they were by the loading
+        size_t first = manifest.GetEntries().size();
+        manifest.Scan(baseDir);
+
+        std::vector<const AssetEntry*> entries;
+        for (size_t i = first; i < manifest.GetEntries().size(); i++)
+            entries.push_back(&manifest.GetEntries()[i]);
+
+        LoadEntries(entries);
+    }
+
+    /// @brief Loads a list of manifest entries. Textures, shaders and models are read and decoded on the job system
+    /// workers, their GL uploads run on this thread. Materials wait for the textures and shaders, levels for everything else.
+    /// Streamed textures finish decoding in the background, their upload happens during the first frames
+    void ResourcesManager::LoadEntries(const std::vector<const AssetEntry*> &entries){
+
+        Jobs::JobSystem& jobs = Jobs::JobSystem::GetInstance();
+
+        // Without parallel import the work runs inline, the uploads are still flushed at the stage barriers
+        auto run = [&](std::function<void()> work) {
+            if (parallelImport)
+                return jobs.Schedule(std::move(work));
+            work();
+            return Jobs::JobHandle();
+        };
+
+        std::vector<Jobs::JobHandle> materialDependencies;
+        std::vector<Jobs::JobHandle> modelJobs;
+
+        for(const AssetEntry* entry : entries){
+            switch(entry->type){
+                case ResourceType::Texture:{
+                    std::string textureName = entry->name;
                     if (textures.find(textureName) != textures.end()) {
                         break;
                     }
-                    LoadTexture(textureName, infos.path);
-                    DEBUG_LOG("Loaded texture : "+textureName);
-                    break;
-                }
-                case Type::T_SHADER: {
-                    if(infos.path.GetParentPath().IsDirectory()){
+                    Filesystem::Path path = entry->path;
 
-                        std::string shaderName = infos.path.RelativeTo(baseDir).WithoutExtension();
+                    // Streamed and cooked textures are registered as placeholders right away, materials don't wait for them
+                    bool streamed = Rendering::TextureStreamer::GetInstance().GetSettings().enabled;
+                    bool cooked = Rendering::TextureCooker::IsUpToDate(path);
+                    if (streamed || cooked) {
+                        std::shared_ptr<Rendering::Texture> texture = Rendering::Texture::CreatePlaceholder(path);
+                        textures.emplace(textureName, texture);
+                        Track(ResourceType::Texture, textureName, path);
 
-                        if (shaders.find(shaderName) != shaders.end()) {
-                            break;
-                        }
-
-                        Filesystem::Path vertPath = Filesystem::Path(
-                                                        (std::filesystem::path(infos.path.GetParent()) / (infos.name + ".vert")).string()
-                                                    );
-                        Filesystem::Path fragPath = Filesystem::Path(
-                                                        (std::filesystem::path(infos.path.GetParent()) / (infos.name + ".frag")).string()
-                                                    );
-                        Filesystem::Path geomPath = Filesystem::Path(
-                                                        (std::filesystem::path(infos.path.GetParent()) / (infos.name + ".geom")).string()
-                                                    );
-
-                        
-                        if(vertPath.Exists() && fragPath.Exists()){
-                           DEBUG_INFO("Loading shader : " + shaderName);
-
-                            LoadShader(shaderName, vertPath, fragPath, geomPath.Exists() ? geomPath : Filesystem::Path(""));
-                        }   
-                        else{
-                            DEBUG_ERROR("Shader loading failed. Missing .vert or .frag file in directory.");
-                        }
+                        run([&jobs, textureName, path, texture, streamed, cooked]() {
+                            // Cooked mips are mapped as is, no decoding nor mip generation
+                            std::shared_ptr<Rendering::TextureMipChain> chain = cooked ? Rendering::TextureCooker::Load(Rendering::TextureCooker::GetCookedPath(path)) : nullptr;
+                            if (!chain) {
+                                Rendering::TextureData data;
+                                if (Rendering::Texture::Decode(path, data))
+                                    chain = Rendering::Texture::BuildMipChain(data);
+                            }
+                            if (!chain) {
+                                DEBUG_ERROR("Texture " + textureName + " keeps its placeholder, couldn't read : " + path.full);
+                                return;
+                            }
+
+                            // The resident levels go straight into the upload ring, the main thread only issues their copies
+                            int firstMip = streamed ? Rendering::TextureStreamer::GetInstance().GetTailMip(*chain) : 0;
+                            std::vector<Rendering::StagingAllocation> staged = Rendering::Texture::StageMips(*chain, firstMip);
+
+                            jobs.RunOnMainThread([textureName, texture, chain, streamed, firstMip, staged]() {
+                                texture->SetMipChain(chain, firstMip, staged);
+                                if (streamed)
+                                    Rendering::TextureStreamer::GetInstance().Register(texture);
+                                DEBUG_LOG("Loaded texture : "+textureName);
+                            });
+                        });
+                        break;
                     }
+
+                    materialDependencies.push_back(run([this, &jobs, textureName, path]() {
+                        std::shared_ptr<Rendering::TextureData> data = std::make_shared<Rendering::TextureData>();
+                        Rendering::Texture::Decode(path, *data);
+
+                        jobs.RunOnMainThread([this, textureName, path, data]() {
+                            LoadTexture(textureName, path, data);
+                            DEBUG_LOG("Loaded texture : "+textureName);
+                        });
+                    }));
                     break;
                 }
-            }
-        }
+                case ResourceType::Shader: {
+                    std::string shaderName = entry->name;
 
-        for(Filesystem::FileInfo infos : Filesystem::FileManager::ListDirectory(baseDir, {Type::T_MATERIAL, Type::T_MODEL}, false, true)){
-            switch(infos.path.GetExtensionType()){
-                case Type::T_MODEL:{
-                    std::string meshName = infos.path.RelativeTo(baseDir).full;
-                    if (meshes.find(meshName) != meshes.end()) {
+                    if (shaders.find(shaderName) != shaders.end()) {
                         break;
                     }
-                    DEBUG_LOG("Loading model : "+meshName);
-                    LoadModel(meshName, infos.path);
+
+                    // The manifest only lists programs with both a .vert and a .frag
+                    Filesystem::Path vertPath = entry->path;
+                    Filesystem::Path fragPath = Filesystem::Path(entry->path.WithoutExtension() + ".frag");
+                    Filesystem::Path geomPath = Filesystem::Path(entry->path.WithoutExtension() + ".geom");
+                    Filesystem::Path gsPath = geomPath.Exists() ? geomPath : Filesystem::Path("");
+
+                    materialDependencies.push_back(run([this, &jobs, shaderName, vertPath, fragPath, gsPath]() {
+                        std::shared_ptr<Rendering::ShaderSources> sources = std::make_shared<Rendering::ShaderSources>(Rendering::Shader::ReadSources(vertPath, fragPath, gsPath));
+
+                        jobs.RunOnMainThread([this, shaderName, sources]() {
+                            DEBUG_INFO("Loading shader : " + shaderName);
+                            LoadShader(shaderName, *sources);
+                        });
+                    }));
                     break;
                 }
-                case Type::T_MATERIAL:{
-                    std::string matName = infos.path.RelativeTo(baseDir).WithoutExtension();
-                    if (materials.find(matName) != materials.end()) {
+                case ResourceType::Model:{
+                    std::string meshName = entry->name;
+                    if (models.find(meshName) != models.end()) {
                         break;
                     }
-                    DEBUG_LOG("Loading material : "+matName);
-                    LoadMaterial(matName, infos.path);
+                    DEBUG_LOG("Loading model : "+meshName);
+                    Filesystem::Path path = entry->path;
+                    Rendering::MeshImportSettings settings = meshImportSettings;
+                    settings.deferUpload = true;
+                    Track(ResourceType::Model, meshName, path);
+                    modelJobs.push_back(run([this, &jobs, meshName, path, settings]() {
+                        std::shared_ptr<Rendering::ModelAsset> model = ImportModel(path, settings);
+                        if (!model)
+                            return;
+
+                        jobs.RunOnMainThread([this, meshName, model]() {
+                            RegisterModel(meshName, model);
+                        });
+                    }));
                     break;
                 }
+                default:
+                    break;
             }
         }
+
+        // Materials look their shader and textures up by name, models keep decoding meanwhile
+        jobs.WaitAll(materialDependencies);
+        jobs.ProcessMainThreadTasks();
+
+        for(const AssetEntry* entry : entries){
+            if (entry->type != ResourceType::Material || materials.find(entry->name) != materials.end()) {
+                continue;
+            }
+            DEBUG_LOG("Loading material : "+entry->name);
+            LoadMaterial(entry->name, entry->path);
+        }
+
+        jobs.WaitAll(modelJobs);
+        jobs.ProcessMainThreadTasks();
     
-        for(Filesystem::FileInfo infos : Filesystem::FileManager::ListDirectory(baseDir, {Type::T_LEVEL}, false, true)){
-            std::string levelName = infos.path.RelativeTo(baseDir).full;
-            if (levels.find(levelName) != levels.end()) {
-                break;
+        for(const AssetEntry* entry : entries){
+            if (entry->type != ResourceType::Level || levels.find(entry->name) != levels.end()) {
+                continue;
             }
-            DEBUG_INFO("Loading level : " + levelName);
-            LoadLevel(levelName, infos.path);
+            DEBUG_INFO("Loading level : " + entry->name);
+            LoadLevel(entry->name, entry->path);
         }
     
     }
@@ -101,13 +192,89 @@ namespace Epoch::Engine::Core::Resources{
             DEBUG_FATAL("Engine directory for resources does not exist or is not a directory.");
         }
 
+        auto start = std::chrono::steady_clock::now();
+
+        if (lazyLoading) {
+            manifest.Scan(engineDir);
+            manifest.Scan(projectDir);
+
+            // Known by name, loaded on their first Get or by Preload
+            for (const AssetEntry& entry : manifest.GetEntries())
+                Track(entry.type, entry.name, entry.path);
+
+            auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+            DEBUG_LOG("Indexed " + std::to_string(manifest.GetEntries().size()) + " resources (" + std::to_string(manifest.GetTotalSize() / (1024 * 1024))
+                      + " MB) in " + std::to_string(elapsed.count()) + " ms, they load on first use");
+            return;
+        }
+
         LoadResourcesInDir(engineDir);
         LoadResourcesInDir(projectDir);
 
-        DEBUG_LOG("Loaded all resources correctly !");
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+        DEBUG_LOG("Loaded all resources correctly in " + std::to_string(elapsed.count()) + " ms !");
+    }
+
+    /// @brief Loads a level and every resource it references that isn't loaded yet, decoding them in parallel
+    void ResourcesManager::Preload(const std::string &levelName)
+    {
+        if (!manifest.Find(ResourceType::Level, levelName)) {
+            DEBUG_WARNING("Level '" + levelName + "' isn't in the resource manifest, it can't be preloaded");
+            return;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+
+        std::vector<const AssetEntry*> missing;
+        for (const AssetEntry* entry : manifest.GetLoadOrder(ResourceType::Level, levelName))
+            if (!IsLoaded(entry->type, entry->name))
+                missing.push_back(entry);
+
+        LoadEntries(missing);
+
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+        DEBUG_LOG("Preloaded " + levelName + " (" + std::to_string(missing.size()) + " resources) in " + std::to_string(elapsed.count()) + " ms");
+    }
+
+    void ResourcesManager::Preload(const std::vector<std::string> &levelNames)
+    {
+        for (const std::string& levelName : levelNames)
+            Preload(levelName);
+    }
+
+    bool ResourcesManager::IsLoaded(ResourceType type, const std::string &name) const
+    {
+        switch (type) {
+            case ResourceType::Mesh:     return meshes.find(name) != meshes.end();
+            case ResourceType::Model:    return models.find(name) != models.end();
+            case ResourceType::Texture:  return textures.find(name) != textures.end();
+            case ResourceType::Shader:   return shaders.find(name) != shaders.end();
+            case ResourceType::Material: return materials.find(name) != materials.end();
+            case ResourceType::Level:    return levels.find(name) != levels.end();
+            default:                     return false;
+        }
     }
     
-    std::shared_ptr<Rendering::Mesh> ResourcesManager::LoadModel(const std::string &name, const Filesystem::Path &path)
+    glm::mat4 ToGlmMatrix(const ufbx_matrix &m, double unitMeters)
+    {
+        glm::mat4 result(1.0f);
+        for (int column = 0; column < 3; column++) {
+            result[column] = glm::vec4(m.cols[column].x, m.cols[column].y, m.cols[column].z, 0.0f);
+        }
+        // Mesh vertices are converted to meters, so are the translations
+        result[3] = glm::vec4(m.cols[3].x * unitMeters, m.cols[3].y * unitMeters, m.cols[3].z * unitMeters, 1.0f);
+        return result;
+    }
+
+    std::shared_ptr<Rendering::ModelAsset> ResourcesManager::LoadModel(const std::string &name, const Filesystem::Path &path)
+    {
+        Track(ResourceType::Model, name, path);
+        return RegisterModel(name, ImportModel(path, meshImportSettings));
+    }
+
+    /// @brief Parses a model file and builds its meshes and node hierarchy, without registering it
+    /// @param settings The mesh import settings, deferUpload keeps the geometry on the CPU so this can run on a worker thread
+    std::shared_ptr<Rendering::ModelAsset> ResourcesManager::ImportModel(const Filesystem::Path &path, Rendering::MeshImportSettings settings)
     {
         ufbx_load_opts opts = { 0 }; // Optional, pass NULL for defaults
         ufbx_error error; // Optional, pass NULL if you don't care about errors
@@ -120,27 +287,107 @@ namespace Epoch::Engine::Core::Resources{
             return nullptr;
         }
 
-        if (scene->meshes.count > 1) {
+        if (scene->meshes.count == 0) {
             ufbx_free_scene(scene);
-            DEBUG_ERROR("Multiple meshes per fbx file isn't supported yet.");
+            DEBUG_ERROR("No mesh found in " + path.full);
             return nullptr;
         }
 
-        ufbx_mesh* ufbx_mesh = scene->meshes.data[0];
+        std::shared_ptr<Rendering::ModelAsset> model = std::make_shared<Rendering::ModelAsset>();
+
+        // Every mesh is imported once, even if several nodes instantiate it
+        for (size_t i = 0; i < scene->meshes.count; i++) {
+            model->meshes.push_back(std::make_shared<Rendering::Mesh>(scene->meshes.data[i], scene->settings.unit_meters, scene->materials, COL_RGBA(0.99f,0.06f,0.75f,1.0f), settings));
+        }
+
+        // The root node itself is skipped, its children become the roots of the model
+        std::unordered_map<uint32_t, int> nodeIndices;
+        std::unordered_map<std::string, int> nameCounts;
+
+        for (size_t i = 0; i < scene->nodes.count; i++) {
+            ufbx_node* node = scene->nodes.data[i];
+            if (node->is_root)
+                continue;
+
+            Rendering::ModelNode modelNode;
+            modelNode.name = node->name.length > 0 ? std::string(node->name.data, node->name.length) : "node" + std::to_string(i);
+            if (nameCounts[modelNode.name]++ > 0)
+                modelNode.name += "_" + std::to_string(nameCounts[modelNode.name] - 1);
 
-        std::shared_ptr<Rendering::Mesh> mesh = std::make_shared<Rendering::Mesh>(ufbx_mesh, scene->settings.unit_meters, scene->materials);
-        meshes.emplace(name, mesh);
+            modelNode.localTransform = ToGlmMatrix(node->node_to_parent, scene->settings.unit_meters);
+            modelNode.mesh = node->mesh ? static_cast<int>(node->mesh->typed_id) : -1;
+
+            nodeIndices[node->typed_id] = static_cast<int>(model->nodes.size());
+            model->nodes.push_back(modelNode);
+        }
+
+        for (size_t i = 0; i < scene->nodes.count; i++) {
+            ufbx_node* node = scene->nodes.data[i];
+            if (node->is_root || !node->parent || node->parent->is_root)
+                continue;
+
+            model->nodes[nodeIndices[node->typed_id]].parent = nodeIndices[node->parent->typed_id];
+        }
 
         ufbx_free_scene(scene);
 
-        return mesh;
+        return model;
 
     }
 
+    /// @brief Uploads the meshes of an imported model and registers it and its meshes
+    std::shared_ptr<Rendering::ModelAsset> ResourcesManager::RegisterModel(const std::string &name, std::shared_ptr<Rendering::ModelAsset> model)
+    {
+        if (!model)
+            return nullptr;
+
+        for (const std::shared_ptr<Rendering::Mesh>& mesh : model->meshes)
+            mesh->Upload();
+
+        RegisterMeshes(name, *model);
+        models.emplace(name, model);
+        Touch(ResourceType::Model, name);
+
+        return model;
+    }
+
+    void ResourcesManager::RegisterMeshes(const std::string &name, const Rendering::ModelAsset &model)
+    {
+        std::vector<std::string>& aliases = modelMeshes[name];
+        aliases.clear();
+
+        // Single mesh files keep their file name, scene meshes are addressed as "file:node"
+        auto registerMesh = [&](const std::string& alias, const std::shared_ptr<Rendering::Mesh>& mesh) {
+            StringId::Intern(alias);
+            meshes.emplace(alias, mesh);
+            meshModels[alias] = name;
+            aliases.push_back(alias);
+            dependents[{ ResourceType::Model, name }].insert({ ResourceType::Mesh, alias });
+        };
+
+        if (model.meshes.size() == 1) {
+            registerMesh(name, model.meshes[0]);
+        }
+        else {
+            for (const Rendering::ModelNode& node : model.nodes)
+                if (node.mesh >= 0)
+                    registerMesh(name + ":" + node.name, model.meshes[node.mesh]);
+        }
+    }
+
     std::shared_ptr<Rendering::Texture> ResourcesManager::LoadTexture(const std::string &name, const Filesystem::Path &path)
     {
         std::shared_ptr<Rendering::Texture> texture = std::make_shared<Rendering::Texture>(path);
         textures.emplace(name, texture);
+        Track(ResourceType::Texture, name, path);
+        return texture;
+    }
+
+    std::shared_ptr<Rendering::Texture> ResourcesManager::LoadTexture(const std::string &name, const Filesystem::Path &path, std::shared_ptr<const Rendering::TextureData> data)
+    {
+        std::shared_ptr<Rendering::Texture> texture = std::make_shared<Rendering::Texture>(path, std::move(data));
+        textures.emplace(name, texture);
+        Track(ResourceType::Texture, name, path);
         return texture;
     }
 
@@ -148,6 +395,21 @@ namespace Epoch::Engine::Core::Resources{
     {
         std::shared_ptr<Rendering::Shader> shader = std::make_shared<Rendering::Shader>(vsPath, fsPath, gsPath);
         shaders.emplace(name, shader);
+        StringId::Intern(name);
+        for (const Filesystem::Path& stage : { vsPath, fsPath, gsPath })
+            if (!stage.full.empty())
+                WatchFile(ResourceType::Shader, name, stage);
+        return shader;
+    }
+
+    std::shared_ptr<Rendering::Shader> ResourcesManager::LoadShader(const std::string &name, const Rendering::ShaderSources &sources)
+    {
+        std::shared_ptr<Rendering::Shader> shader = std::make_shared<Rendering::Shader>(sources);
+        shaders.emplace(name, shader);
+        StringId::Intern(name);
+        for (const std::string& stage : { sources.vertexFilePath, sources.fragmentFilePath, sources.geometryFilePath })
+            if (!stage.empty())
+                WatchFile(ResourceType::Shader, name, Filesystem::Path(stage));
         return shader;
     }
 
@@ -157,7 +419,11 @@ namespace Epoch::Engine::Core::Resources{
         if(!mat){
             DEBUG_ERROR("Error during material import.");
         }
+        else{
+            LinkMaterial(name, *mat);
+        }
         materials.emplace(name, mat);
+        Track(ResourceType::Material, name, path);
         return mat;
     }
 
@@ -170,6 +436,770 @@ namespace Epoch::Engine::Core::Resources{
         if (!inserted) {
             DEBUG_WARNING("Level '" + name + "' already loaded.");
         }
+        Track(ResourceType::Level, name, path);
         return level;
     }
+
+    std::shared_ptr<Rendering::Mesh> ResourcesManager::GetMesh(const std::string &name)
+    {
+        auto owner = meshModels.find(name);
+
+        auto it = meshes.find(name);
+        if (it == meshes.end()) {
+            // Unloaded along with its model, or its model was never loaded
+            std::string model = owner != meshModels.end() ? owner->second : AssetManifest::GetMeshModel(name);
+            if (!GetModel(model))
+                return nullptr;
+            it = meshes.find(name);
+            if (it == meshes.end())
+                return nullptr;
+            owner = meshModels.find(name);
+        }
+
+        if (owner != meshModels.end())
+            Touch(ResourceType::Model, owner->second);
+        return it->second;
+    }
+
+    std::shared_ptr<Rendering::ModelAsset> ResourcesManager::GetModel(const std::string &name)
+    {
+        auto it = models.find(name);
+        if (it != models.end()) {
+            Touch(ResourceType::Model, name);
+            return it->second;
+        }
+
+        auto source = sources[static_cast<int>(ResourceType::Model)].find(name);
+        if (source != sources[static_cast<int>(ResourceType::Model)].end()) {
+            DEBUG_LOG("Reloading model : " + name);
+            return LoadModel(name, source->second);
+        }
+        return nullptr;
+    }
+
+    std::shared_ptr<Rendering::Material> ResourcesManager::GetMaterial(const std::string &name)
+    {
+        auto it = materials.find(name);
+        if (it != materials.end()) {
+            Touch(ResourceType::Material, name);
+            return it->second;
+        }
+
+        auto source = sources[static_cast<int>(ResourceType::Material)].find(name);
+        if (source != sources[static_cast<int>(ResourceType::Material)].end()) {
+            DEBUG_LOG("Reloading material : " + name);
+            return LoadMaterial(name, source->second);
+        }
+        return nullptr;
+    }
+
+    std::shared_ptr<Rendering::Shader> ResourcesManager::GetShader(const std::string &name)
+    {
+        auto it = shaders.find(name);
+        if (it != shaders.end())
+            return it->second;
+
+        // Lazy loading, the source of a shader is its .vert file
+        auto source = sources[static_cast<int>(ResourceType::Shader)].find(name);
+        if (source != sources[static_cast<int>(ResourceType::Shader)].end()) {
+            DEBUG_LOG("Loading shader : " + name);
+            Filesystem::Path geomPath(source->second.WithoutExtension() + ".geom");
+            return LoadShader(name, source->second, Filesystem::Path(source->second.WithoutExtension() + ".frag"), geomPath.Exists() ? geomPath : Filesystem::Path(""));
+        }
+        return nullptr;
+    }
+
+    std::shared_ptr<Rendering::Texture> ResourcesManager::GetTexture(const std::string &name)
+    {
+        auto it = textures.find(name);
+        if (it != textures.end()) {
+            Touch(ResourceType::Texture, name);
+            return it->second;
+        }
+
+        // Same path as the first load, streamed and cooked textures come back as placeholders
+        auto source = sources[static_cast<int>(ResourceType::Texture)].find(name);
+        if (source != sources[static_cast<int>(ResourceType::Texture)].end()) {
+            DEBUG_LOG("Reloading texture : " + name);
+            AssetEntry entry;
+            entry.type = ResourceType::Texture;
+            entry.name = name;
+            entry.path = source->second;
+            LoadEntries({ &entry });
+
+            it = textures.find(name);
+            return it != textures.end() ? it->second : nullptr;
+        }
+        return nullptr;
+    }
+
+    std::shared_ptr<Levels::Level> ResourcesManager::GetLevel(const std::string &name)
+    {
+        if (auto it = levels.find(name); it != levels.end()) {
+            Touch(ResourceType::Level, name);
+            return it->second;
+        }
+
+        // Everything the level references decodes in parallel before it is built
+        if (manifest.Find(ResourceType::Level, name)) {
+            Preload(name);
+            if (auto it = levels.find(name); it != levels.end())
+                return it->second;
+        }
+
+        auto source = sources[static_cast<int>(ResourceType::Level)].find(name);
+        if (source != sources[static_cast<int>(ResourceType::Level)].end()) {
+            DEBUG_LOG("Reloading level : " + name);
+            return LoadLevel(name, source->second);
+        }
+        return nullptr;
+    }
+
+    void ResourcesManager::Track(ResourceType type, const std::string &name, const Filesystem::Path &source)
+    {
+        StringId::Intern(name);
+        sources[static_cast<int>(type)][name] = source;
+        if (IsLoaded(type, name))
+            Touch(type, name);
+        WatchFile(type, name, source);
+    }
+
+    void ResourcesManager::WatchFile(ResourceType type, const std::string &name, const Filesystem::Path &path)
+    {
+        std::vector<ResourceKey>& keys = fileResources[path.GetAbsolutePath()];
+        ResourceKey key{ type, name };
+        if (std::find(keys.begin(), keys.end(), key) == keys.end())
+            keys.push_back(key);
+    }
+
+    void ResourcesManager::Touch(ResourceType type, const std::string &name)
+    {
+        RecencyList& list = recency[static_cast<int>(type)];
+        list.Touch(list.GetNode(name));
+    }
+
+    uint32_t ResourcesManager::RecencyList::GetNode(const std::string &name)
+    {
+        auto [it, inserted] = indices.emplace(name, static_cast<uint32_t>(nodes.size()));
+        if (inserted)
+            nodes.push_back(Node{ name });
+        return it->second;
+    }
+
+    /// @brief Moves a node to the most recent end, linking it if needed
+    void ResourcesManager::RecencyList::Touch(uint32_t node)
+    {
+        if (node == newest)
+            return;
+
+        Remove(node);
+
+        nodes[node].older = newest;
+        nodes[node].newer = UINT32_MAX;
+        nodes[node].linked = true;
+        if (newest != UINT32_MAX)
+            nodes[newest].newer = node;
+        else
+            oldest = node;
+        newest = node;
+    }
+
+    void ResourcesManager::RecencyList::Remove(uint32_t node)
+    {
+        Node& entry = nodes[node];
+        if (!entry.linked)
+            return;
+
+        if (entry.older != UINT32_MAX)
+            nodes[entry.older].newer = entry.newer;
+        else
+            oldest = entry.newer;
+
+        if (entry.newer != UINT32_MAX)
+            nodes[entry.newer].older = entry.older;
+        else
+            newest = entry.older;
+
+        entry.older = entry.newer = UINT32_MAX;
+        entry.linked = false;
+    }
+
+    void ResourcesManager::RecencyList::Clear()
+    {
+        for (Node& node : nodes) {
+            node.older = node.newer = UINT32_MAX;
+            node.linked = false;
+        }
+        oldest = newest = UINT32_MAX;
+    }
+
+    /// @brief Gives the slot of a name, created on the first lookup. Only interned names get one : everything
+    /// loaded or tracked by the manager, and the names given to GetHandle as strings
+    /// @return The slot index, UINT32_MAX for an unknown name
+    uint32_t ResourcesManager::FindSlot(ResourceType type, StringId name)
+    {
+        std::unordered_map<StringId, uint32_t>& indices = slotIndices[static_cast<int>(type)];
+        if (auto it = indices.find(name); it != indices.end())
+            return it->second;
+
+        const std::string& str = name.GetString();
+        if (str.empty()) {
+            DEBUG_WARNING("No resource name was registered for the string id " + std::to_string(name.GetValue()));
+            return UINT32_MAX;
+        }
+
+        std::vector<HandleSlot>& typeSlots = slots[static_cast<int>(type)];
+        uint32_t index = static_cast<uint32_t>(typeSlots.size());
+        typeSlots.push_back({ str, {} });
+        indices.emplace(name, index);
+        return index;
+    }
+
+    /// @brief Resolves a handle. A live resource is returned without hashing its name or allocating, its use is recorded
+    /// through the recency node cached in the slot. An unloaded one goes through the named Get, which loads it back, and the slot is refreshed
+    std::shared_ptr<void> ResourcesManager::Resolve(ResourceType type, uint32_t index)
+    {
+        std::vector<HandleSlot>& typeSlots = slots[static_cast<int>(type)];
+        if (index >= typeSlots.size())
+            return nullptr;
+
+        // Meshes are unloaded with their model
+        RecencyList& list = recency[static_cast<int>(type == ResourceType::Mesh ? ResourceType::Model : type)];
+
+        HandleSlot& slot = typeSlots[index];
+        if (std::shared_ptr<void> resource = slot.resource.lock()) {
+            if (slot.recencyNode != UINT32_MAX && list.nodes[slot.recencyNode].linked)
+                list.Touch(slot.recencyNode);
+            return resource;
+        }
+
+        std::shared_ptr<void> resource;
+        switch (type) {
+            case ResourceType::Mesh:        resource = GetMesh(slot.name); break;
+            case ResourceType::Model:       resource = GetModel(slot.name); break;
+            case ResourceType::Texture:     resource = GetTexture(slot.name); break;
+            case ResourceType::Shader:      resource = GetShader(slot.name); break;
+            case ResourceType::Material:    resource = GetMaterial(slot.name); break;
+            case ResourceType::Level:       resource = GetLevel(slot.name); break;
+            default: break;
+        }
+        slot.resource = resource;
+
+        if (resource && type == ResourceType::Mesh) {
+            auto owner = meshModels.find(slot.name);
+            slot.recencyNode = owner != meshModels.end() ? list.GetNode(owner->second) : UINT32_MAX;
+        }
+        else if (resource && type != ResourceType::Shader) {
+            slot.recencyNode = list.GetNode(slot.name);
+        }
+        return resource;
+    }
+
+    const std::string& ResourcesManager::GetName(ResourceType type, uint32_t handleIndex) const
+    {
+        static const std::string empty;
+        const std::vector<HandleSlot>& typeSlots = slots[static_cast<int>(type)];
+        return handleIndex < typeSlots.size() ? typeSlots[handleIndex].name : empty;
+    }
+
+    /// @brief Checks if something else than the manager owns a resource. Meshes are owned by their model
+    /// and by every name they are registered under, levels are referenced while loaded
+    bool ResourcesManager::IsReferenced(ResourceType type, const std::string &name) const
+    {
+        switch (type) {
+            case ResourceType::Mesh: {
+                auto it = meshes.find(name);
+                if (it == meshes.end())
+                    return false;
+
+                auto owner = meshModels.find(name);
+                auto aliases = owner != meshModels.end() ? modelMeshes.find(owner->second) : modelMeshes.end();
+                if (aliases == modelMeshes.end())
+                    return it->second.use_count() > 2;
+
+                long owners = 1;
+                for (const std::string& alias : aliases->second)
+                    if (auto mesh = meshes.find(alias); mesh != meshes.end() && mesh->second == it->second)
+                        owners++;
+                return it->second.use_count() > owners;
+            }
+            case ResourceType::Model: {
+                auto it = models.find(name);
+                if (it == models.end())
+                    return false;
+                if (it->second.use_count() > 1)
+                    return true;
+
+                // Each mesh is owned by the model and by its names
+                std::unordered_map<const Rendering::Mesh*, long> owners;
+                if (auto aliases = modelMeshes.find(name); aliases != modelMeshes.end())
+                    for (const std::string& alias : aliases->second)
+                        if (auto mesh = meshes.find(alias); mesh != meshes.end())
+                            owners[mesh->second.get()]++;
+
+                for (const std::shared_ptr<Rendering::Mesh>& mesh : it->second->meshes)
+                    if (mesh.use_count() > 1 + owners[mesh.get()])
+                        return true;
+                return false;
+            }
+            case ResourceType::Texture: {
+                auto it = textures.find(name);
+                return it != textures.end() && it->second.use_count() > 1;
+            }
+            case ResourceType::Shader: {
+                auto it = shaders.find(name);
+                return it != shaders.end() && it->second.use_count() > 1;
+            }
+            case ResourceType::Material: {
+                auto it = materials.find(name);
+                return it != materials.end() && it->second.use_count() > 1;
+            }
+            case ResourceType::Level: {
+                auto it = levels.find(name);
+                return it != levels.end() && it->second && (it->second->loaded || it->second.use_count() > 1);
+            }
+            default:
+                return false;
+        }
+    }
+
+    ResourceUsage ResourcesManager::GetMemoryUsage(ResourceType type) const
+    {
+        ResourceUsage usage;
+
+        // A resource registered under several names (the meshes shared by FBX nodes) is counted once
+        std::unordered_set<const void*> counted;
+        auto count = [&](const auto& map, auto bytes) {
+            for (const auto& [name, resource] : map) {
+                usage.count++;
+                if (IsReferenced(type, name))
+                    usage.referenced++;
+                if (resource && counted.insert(resource.get()).second)
+                    usage.bytes += bytes(*resource);
+            }
+        };
+
+        switch (type) {
+            case ResourceType::Mesh:
+                count(meshes, [](const Rendering::Mesh& mesh) { return mesh.GetMemoryBytes(); });
+                break;
+            case ResourceType::Model:
+                count(models, [](const Rendering::ModelAsset& model) {
+                    size_t bytes = 0;
+                    for (const std::shared_ptr<Rendering::Mesh>& mesh : model.meshes)
+                        bytes += mesh->GetMemoryBytes();
+                    return bytes;
+                });
+                break;
+            case ResourceType::Texture:
+                count(textures, [](const Rendering::Texture& texture) { return texture.GetMemoryBytes(); });
+                break;
+            case ResourceType::Shader:
+                count(shaders, [](const Rendering::Shader&) { return size_t(0); });
+                break;
+            case ResourceType::Material:
+                count(materials, [](const Rendering::Material&) { return size_t(0); });
+                break;
+            case ResourceType::Level:
+                count(levels, [](const Levels::Level&) { return size_t(0); });
+                break;
+            default:
+                break;
+        }
+
+        return usage;
+    }
+
+    /// @brief Lists the loaded resources of a type that nothing else references, from the least recently used, in one pass
+    std::vector<std::string> ResourcesManager::GetUnloadOrder(ResourceType type) const
+    {
+        std::vector<std::string> order;
+        if (type == ResourceType::Mesh || type == ResourceType::Shader)
+            return order;
+
+        const RecencyList& list = recency[static_cast<int>(type)];
+        for (uint32_t node = list.oldest; node != UINT32_MAX; node = list.nodes[node].newer) {
+            const std::string& name = list.nodes[node].name;
+            if (IsLoaded(type, name) && !IsReferenced(type, name))
+                order.push_back(name);
+        }
+        return order;
+    }
+
+    /// @brief Unloads a resource, it comes back from its source on the next Get
+    /// @return The memory released, for models and textures
+    size_t ResourcesManager::Unload(ResourceType type, const std::string &name)
+    {
+        size_t freedBytes = 0;
+
+        switch (type) {
+            case ResourceType::Model: {
+                auto it = models.find(name);
+                if (it == models.end())
+                    return 0;
+                for (const std::shared_ptr<Rendering::Mesh>& mesh : it->second->meshes)
+                    freedBytes += mesh->GetMemoryBytes();
+                DEBUG_LOG("Unloading model : " + name);
+                EvictModel(name);
+                break;
+            }
+            case ResourceType::Texture: {
+                auto it = textures.find(name);
+                if (it == textures.end())
+                    return 0;
+                freedBytes = it->second->GetMemoryBytes();
+                DEBUG_LOG("Unloading texture : " + name);
+                textures.erase(it);
+                break;
+            }
+            case ResourceType::Material:
+                DEBUG_LOG("Unloading material : " + name);
+                materials.erase(name);
+                break;
+            case ResourceType::Level: {
+                auto it = levels.find(name);
+                if (it == levels.end())
+                    return 0;
+                DEBUG_LOG("Unloading level : " + name);
+                // The actors hold on to their meshes and materials
+                if (it->second)
+                    it->second->Clear();
+                levels.erase(it);
+                break;
+            }
+            default:
+                // Shaders are small and slow to compile, meshes go with their model
+                return 0;
+        }
+
+        RecencyList& list = recency[static_cast<int>(type)];
+        list.Remove(list.GetNode(name));
+        return freedBytes;
+    }
+
+    void ResourcesManager::EvictModel(const std::string &name)
+    {
+        if (auto aliases = modelMeshes.find(name); aliases != modelMeshes.end()) {
+            for (const std::string& alias : aliases->second)
+                meshes.erase(alias);
+            modelMeshes.erase(aliases);
+        }
+        models.erase(name);
+    }
+
+    /// @brief Records the shader and textures of a material, it is rebuilt when one of them reloads
+    void ResourcesManager::LinkMaterial(const std::string &name, Rendering::Material &material)
+    {
+        ResourceKey key{ ResourceType::Material, name };
+        for (auto& [source, users] : dependents)
+            users.erase(key);
+
+        for (const auto& [shaderName, shader] : shaders)
+            if (shader == material.shader)
+                dependents[{ ResourceType::Shader, shaderName }].insert(key);
+
+        for (const auto& [parameter, value] : *material.GetParameters()) {
+            if (!std::holds_alternative<std::shared_ptr<Rendering::Texture>>(value))
+                continue;
+            const std::shared_ptr<Rendering::Texture>& texture = std::get<std::shared_ptr<Rendering::Texture>>(value);
+            for (const auto& [textureName, loaded] : textures)
+                if (texture && loaded == texture)
+                    dependents[{ ResourceType::Texture, textureName }].insert(key);
+        }
+    }
+
+    /// @brief Starts watching resource directories, the changes are applied by ReloadChangedFiles
+    void ResourcesManager::WatchForChanges(const std::vector<Filesystem::Path> &directories)
+    {
+        watcher = std::make_unique<Filesystem::FileWatcher>();
+        for (const Filesystem::Path& directory : directories)
+            if (watcher->Watch(directory))
+                DEBUG_INFO("Watching for resource changes : " + directory.full);
+    }
+
+    /// @brief Reloads the resources whose files changed since the last call, must be called from the GL thread
+    void ResourcesManager::ReloadChangedFiles()
+    {
+        if (!watcher)
+            return;
+
+        for (const Filesystem::Path& path : watcher->Poll()) {
+            auto start = std::chrono::steady_clock::now();
+
+            if (ReloadFile(path)) {
+                auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+                DEBUG_INFO("Hot reloaded " + path.full + " in " + std::to_string(elapsed.count() / 1000.0f) + " ms");
+            }
+        }
+    }
+
+    /// @brief Reloads in place the resources read from a file, then the resources built from them.
+    /// Everyone holding them keeps the same objects. A file that fails to load keeps its previous version, and its dependents are left alone
+    /// @return True if anything was reloaded
+    bool ResourcesManager::ReloadFile(const Filesystem::Path &path)
+    {
+        auto file = fileResources.find(path.GetAbsolutePath());
+        if (file == fileResources.end())
+            return false;
+
+        std::unordered_set<const void*> changed;
+        std::set<ResourceKey> visited;
+        std::vector<ResourceKey> pending = file->second;
+        size_t reloaded = 0;
+
+        while (!pending.empty()) {
+            ResourceKey key = pending.back();
+            pending.pop_back();
+
+            if (!visited.insert(key).second || !Reload(key.first, key.second, changed))
+                continue;
+            reloaded++;
+
+            auto users = dependents.find(key);
+            if (users != dependents.end())
+                pending.insert(pending.end(), users->second.begin(), users->second.end());
+        }
+
+        ResubmitModels(changed);
+        return reloaded > 0;
+    }
+
+    /// @brief Reloads a single loaded resource in place. Unloaded resources are skipped, they are read again on their next Get
+    /// @param changed Receives the meshes and materials whose draw commands must be rebuilt
+    bool ResourcesManager::Reload(ResourceType type, const std::string &name, std::unordered_set<const void*> &changed)
+    {
+        auto source = sources[static_cast<int>(type)].find(name);
+
+        switch (type) {
+            case ResourceType::Texture: {
+                auto it = textures.find(name);
+                if (it == textures.end() || source == sources[static_cast<int>(type)].end())
+                    return false;
+
+                std::shared_ptr<Rendering::TextureData> data = std::make_shared<Rendering::TextureData>();
+                if (!Rendering::Texture::Decode(source->second, *data))
+                    return false;
+
+                if (it->second->IsStreamed()) {
+                    std::shared_ptr<Rendering::TextureMipChain> chain = Rendering::Texture::BuildMipChain(*data);
+                    Rendering::TextureStreamer& streamer = Rendering::TextureStreamer::GetInstance();
+                    bool streamed = streamer.GetSettings().enabled;
+
+                    it->second->Reload(chain, streamed ? streamer.GetTailMip(*chain) : 0);
+                    if (streamed)
+                        streamer.Register(it->second);
+                }
+                else {
+                    it->second->Reload(std::shared_ptr<const Rendering::TextureData>(data));
+                }
+
+                DEBUG_INFO("Reloaded texture : " + name);
+                return true;
+            }
+            case ResourceType::Shader: {
+                auto it = shaders.find(name);
+                if (it == shaders.end())
+                    return false;
+
+                if (!it->second->Reload()) {
+                    DEBUG_ERROR("Shader reload failed, keeping the previous program : " + name);
+                    return false;
+                }
+
+                DEBUG_INFO("Reloaded shader : " + name);
+                return true;
+            }
+            case ResourceType::Material: {
+                auto it = materials.find(name);
+                if (it == materials.end() || !it->second || source == sources[static_cast<int>(type)].end())
+                    return false;
+
+                // Picks up the uniforms of a reloaded shader, the parameters of the file are applied on top
+                std::shared_ptr<Rendering::Material> fresh = Serialization::MaterialSerializer::ImportMaterial(source->second);
+                if (!fresh)
+                    return false;
+
+                *it->second = *fresh;
+                LinkMaterial(name, *it->second);
+                changed.insert(it->second.get());
+
+                DEBUG_INFO("Reloaded material : " + name);
+                return true;
+            }
+            case ResourceType::Model:
+                return ReloadModel(name, changed);
+            case ResourceType::Mesh:
+                // Replaced by its model
+                return true;
+            default:
+                DEBUG_INFO("Changed level '" + name + "' is applied the next time it is loaded");
+                return false;
+        }
+    }
+
+    /// @brief Imports a model again and moves the new geometry into the meshes already registered under the same names
+    bool ResourcesManager::ReloadModel(const std::string &name, std::unordered_set<const void*> &changed)
+    {
+        auto it = models.find(name);
+        auto source = sources[static_cast<int>(ResourceType::Model)].find(name);
+        if (it == models.end() || source == sources[static_cast<int>(ResourceType::Model)].end())
+            return false;
+
+        std::shared_ptr<Rendering::ModelAsset> fresh = ImportModel(source->second, meshImportSettings);
+        if (!fresh)
+            return false;
+
+        std::vector<std::pair<std::string, int>> aliases;
+        if (fresh->meshes.size() == 1) {
+            aliases.push_back({ name, 0 });
+        }
+        else {
+            for (const Rendering::ModelNode& node : fresh->nodes)
+                if (node.mesh >= 0)
+                    aliases.push_back({ name + ":" + node.name, node.mesh });
+        }
+
+        // Components, levels and draw lists point to the registered meshes, they keep their address
+        std::vector<bool> kept(fresh->meshes.size(), false);
+        std::unordered_set<const Rendering::Mesh*> reused;
+
+        for (const auto& [alias, index] : aliases) {
+            auto previous = meshes.find(alias);
+            if (previous == meshes.end() || kept[index] || !reused.insert(previous->second.get()).second)
+                continue;
+
+            previous->second->Replace(*fresh->meshes[index]);
+            fresh->meshes[index] = previous->second;
+            kept[index] = true;
+            changed.insert(previous->second.get());
+        }
+
+        if (auto previous = modelMeshes.find(name); previous != modelMeshes.end()) {
+            for (const std::string& alias : previous->second) {
+                meshes.erase(alias);
+                meshModels.erase(alias);
+            }
+            modelMeshes.erase(previous);
+        }
+        dependents.erase({ ResourceType::Model, name });
+
+        *it->second = *fresh;
+        RegisterMeshes(name, *it->second);
+
+        DEBUG_INFO("Reloaded model : " + name);
+        return true;
+    }
+
+    /// @brief Rebuilds the draw commands of the model components of the loaded levels using a changed mesh or material
+    void ResourcesManager::ResubmitModels(const std::unordered_set<const void*> &changed)
+    {
+        if (changed.empty())
+            return;
+
+        Levels::LevelManager& levelManager = Levels::LevelManager::GetInstance();
+
+        for (int i = 0; i < levelManager.GetLoadedLevelCount(); i++) {
+            Levels::Level* level = levelManager.GetLevelAt(i);
+
+            for (const std::shared_ptr<ECS::Components::Model>& model : level->models) {
+                bool dirty = changed.count(model->GetMesh().get()) > 0;
+                for (const std::shared_ptr<Rendering::Material>& material : model->GetMaterials())
+                    dirty = dirty || changed.count(material.get()) > 0;
+
+                if (dirty)
+                    model->Resubmit();
+            }
+        }
+    }
+
+    /// @brief Unloads the least recently used resources nothing else references until the mesh and texture budgets are met.
+    /// When only referenced resources are left, unreferenced materials then levels are unloaded to release what they hold.
+    /// Unloaded resources come back from their source on the next Get
+    /// @param ignoreBudgets Unloads every unreferenced level, material, model and texture
+    /// @return The number of unloaded resources
+    size_t ResourcesManager::UnloadUnused(bool ignoreBudgets)
+    {
+        size_t evicted = 0;
+
+        if (ignoreBudgets) {
+            // Each type releases what the next one is referenced by
+            for (ResourceType type : { ResourceType::Level, ResourceType::Material, ResourceType::Model, ResourceType::Texture }) {
+                for (const std::string& name : GetUnloadOrder(type)) {
+                    Unload(type, name);
+                    evicted++;
+                }
+            }
+        }
+        else {
+            struct Budget {
+                ResourceType type;
+                ResourceType evictedType;
+                size_t limit;
+            };
+
+            for (const Budget& budget : { Budget{ ResourceType::Mesh, ResourceType::Model, budgets.meshBytes }, Budget{ ResourceType::Texture, ResourceType::Texture, budgets.textureBytes } }) {
+                if (budget.limit == 0)
+                    continue;
+
+                size_t used = GetMemoryUsage(budget.type).bytes;
+
+                while (used > budget.limit) {
+                    for (const std::string& name : GetUnloadOrder(budget.evictedType)) {
+                        if (used <= budget.limit)
+                            break;
+                        used -= std::min(Unload(budget.evictedType, name), used);
+                        evicted++;
+                    }
+                    if (used <= budget.limit)
+                        break;
+
+                    // Only referenced ones left, release the least recent material or level holding some and try again
+                    ResourceType holderType = ResourceType::Material;
+                    std::vector<std::string> holders;
+                    if (budget.type == ResourceType::Texture)
+                        holders = GetUnloadOrder(ResourceType::Material);
+                    if (holders.empty()) {
+                        holderType = ResourceType::Level;
+                        holders = GetUnloadOrder(ResourceType::Level);
+                    }
+                    if (holders.empty())
+                        break;
+
+                    Unload(holderType, holders.front());
+                    evicted++;
+                }
+            }
+        }
+
+        if (evicted > 0)
+            DEBUG_INFO("Unloaded " + std::to_string(evicted) + " unused resources");
+        return evicted;
+    }
+
+    /// @brief Drops every resource and forgets their sources
+    void ResourcesManager::Clear()
+    {
+        meshes.clear();
+        models.clear();
+        textures.clear();
+        shaders.clear();
+        materials.clear();
+        levels.clear();
+
+        for (int type = 0; type < static_cast<int>(ResourceType::Count); type++) {
+            sources[type].clear();
+            recency[type].Clear();
+        }
+        meshModels.clear();
+        modelMeshes.clear();
+
+        // Handles outlive the resources, they resolve again once their name is loaded back
+        for (std::vector<HandleSlot>& typeSlots : slots)
+            for (HandleSlot& slot : typeSlots)
+                slot.resource.reset();
+
+        fileResources.clear();
+        dependents.clear();
+        manifest.Clear();
+    }
 }
\ No newline at end of file
@@ -1,13 +1,33 @@
 #pragma once
 
 #include <unordered_map>
+#include <unordered_set>
+#include <map>
+#include <set>
 
 #include "engine/filesystem/filesystem.hpp"
+#include "engine/filesystem/file_watcher.hpp"
+#include "engine/core/resources/asset_manifest.hpp"
+#include "engine/core/resources/resource_handle.hpp"
+#include "engine/core/string_id.hpp"
 #include "engine/rendering/mesh/mesh.hpp"
+#include "engine/rendering/mesh/model_asset.hpp"
 #include "engine/levels/level.hpp"
 
 namespace Epoch::Engine::Core::Resources{
 
+    struct ResourceUsage {
+        size_t count = 0;
+        size_t referenced = 0;      // Also owned outside of the manager (levels, components, materials...)
+        size_t bytes = 0;           // CPU and GPU memory, only tracked for meshes and textures
+    };
+
+    // Bytes kept loaded before UnloadUnused evicts the least recently used unreferenced resources, 0 for no limit
+    struct ResourceBudgets {
+        size_t meshBytes = 0;
+        size_t textureBytes = 0;
+    };
+
     class ResourcesManager{
         public:
             static ResourcesManager& GetInstance() {
@@ -16,48 +36,57 @@ namespace Epoch::Engine::Core::Resources{
             }
             void LoadResourcesInDir(const Filesystem::Path &baseDir);
             void LoadResources(const Filesystem::Path &projectDir, const Filesystem::Path &engineDir);
-            std::shared_ptr<Rendering::Mesh> LoadModel(const std::string &name, const Filesystem::Path &path);
+            void LoadEntries(const std::vector<const AssetEntry*> &entries);
+            void Preload(const std::string &levelName);
+            void Preload(const std::vector<std::string> &levelNames);
+            bool IsLoaded(ResourceType type, const std::string &name) const;
+            const AssetManifest& GetManifest() const { return manifest; }
+            std::shared_ptr<Rendering::ModelAsset> LoadModel(const std::string &name, const Filesystem::Path &path);
+            std::shared_ptr<Rendering::ModelAsset> ImportModel(const Filesystem::Path &path, Rendering::MeshImportSettings settings);
+            std::shared_ptr<Rendering::ModelAsset> RegisterModel(const std::string &name, std::shared_ptr<Rendering::ModelAsset> model);
             std::shared_ptr<Rendering::Texture> LoadTexture(const std::string &name, const Filesystem::Path &path);
+            std::shared_ptr<Rendering::Texture> LoadTexture(const std::string &name, const Filesystem::Path &path, std::shared_ptr<const Rendering::TextureData> data);
             std::shared_ptr<Rendering::Shader> LoadShader(const std::string &name, const Filesystem::Path &vsPath, const Filesystem::Path &fsPath, const Filesystem::Path &gsPath);
+            std::shared_ptr<Rendering::Shader> LoadShader(const std::string &name, const Rendering::ShaderSources &sources);
             std::shared_ptr<Rendering::Material> LoadMaterial(const std::string &name, const Filesystem::Path &path);
             std::shared_ptr<Levels::Level> LoadLevel(const std::string &name, const Filesystem::Path& path);
 
-            std::shared_ptr<Rendering::Mesh> GetMesh(std::string name) { 
-                auto it = meshes.find(name);
-                if (it != meshes.end())
-                    return it->second;
-                return nullptr;
-            }
+            std::shared_ptr<Rendering::Mesh> GetMesh(const std::string& name);
+            std::shared_ptr<Rendering::ModelAsset> GetModel(const std::string& name);
+            std::shared_ptr<Rendering::Material> GetMaterial(const std::string& name);
+            std::shared_ptr<Rendering::Shader> GetShader(const std::string& name);
+            std::shared_ptr<Rendering::Texture> GetTexture(const std::string& name);
+            std::shared_ptr<Levels::Level> GetLevel(const std::string& name);
+
+            // Handles : the name is hashed once, resolving a handle afterwards is an array access
+            template<typename T>
+            Handle<T> GetHandle(StringId name) { return Handle<T>{ FindSlot(Handle<T>::type, name) }; }
+            template<typename T>
+            Handle<T> GetHandle(std::string_view name) { return Handle<T>{ FindSlot(Handle<T>::type, StringId::Intern(name)) }; }
+
+            template<typename T>
+            std::shared_ptr<T> Get(Handle<T> handle) { return std::static_pointer_cast<T>(Resolve(Handle<T>::type, handle.index)); }
+            template<typename T>
+            std::shared_ptr<T> Get(StringId name) { return Get(GetHandle<T>(name)); }
+
+            const std::string& GetName(ResourceType type, uint32_t handleIndex) const;
+
+            ResourceUsage GetMemoryUsage(ResourceType type) const;
+            bool IsReferenced(ResourceType type, const std::string& name) const;
+            size_t UnloadUnused(bool ignoreBudgets = false);
+            void Clear();
 
-            std::shared_ptr<Rendering::Material> GetMaterial(std::string name) { 
-                auto it = materials.find(name);
-                if (it != materials.end())
-                    return it->second;
-                return nullptr;
-            }
+            // Hot reload : a changed file is reloaded in place, then every resource built from it
+            void WatchForChanges(const std::vector<Filesystem::Path>& directories);
+            void ReloadChangedFiles();
+            bool ReloadFile(const Filesystem::Path& path);
 
-            std::shared_ptr<Rendering::Shader> GetShader(std::string name) { 
-                auto it = shaders.find(name);
-                if (it != shaders.end())
-                    return it->second;
-                return nullptr;
-            }
+            ResourceBudgets budgets;
 
-            std::shared_ptr<Rendering::Texture> GetTexture(std::string name) { 
-                auto it = textures.find(name);
-                if (it != textures.end())
-                    return it->second;
-                return nullptr;
-            }
+            Rendering::MeshImportSettings meshImportSettings;
 
-            std::shared_ptr<Levels::Level> GetLevel(const std::string& name) {
-                if (auto it = levels.find(name); it != levels.end())
-                    return it->second;
-                return nullptr;
-            }
-
-            //TODO static void UnloadUnused();
-            void Clear();
+            bool parallelImport = true;     // Decode textures, shaders and models on the job system workers
+            bool lazyLoading = false;       // LoadResources only builds the manifest, resources load on their first Get or with Preload
 
         private:
             ResourcesManager() = default;
@@ -66,10 +95,69 @@ namespace Epoch::Engine::Core::Resources{
             ResourcesManager& operator=(const ResourcesManager&) = delete;
 
             std::unordered_map<std::string, std::shared_ptr<Rendering::Mesh>> meshes;
+            std::unordered_map<std::string, std::shared_ptr<Rendering::ModelAsset>> models;
             std::unordered_map<std::string, std::shared_ptr<Rendering::Texture>> textures;
             std::unordered_map<std::string, std::shared_ptr<Rendering::Shader>> shaders;
             std::unordered_map<std::string, std::shared_ptr<Rendering::Material>> materials;
             std::unordered_map<std::string, std::shared_ptr<Levels::Level>> levels;
+
+            // Lifetime tracking : unloaded resources are loaded back from their source on the next Get
+            void Track(ResourceType type, const std::string& name, const Filesystem::Path& source);
+            void Touch(ResourceType type, const std::string& name);
+            std::vector<std::string> GetUnloadOrder(ResourceType type) const;
+            size_t Unload(ResourceType type, const std::string& name);
+            void EvictModel(const std::string& name);
+
+            void RegisterMeshes(const std::string& name, const Rendering::ModelAsset& model);
+
+            struct HandleSlot {
+                std::string name;
+                std::weak_ptr<void> resource;           // Expired once the resource is unloaded, the next Resolve loads it back
+                uint32_t recencyNode = UINT32_MAX;      // Touched by Resolve, the node of the owning model for meshes
+            };
+
+            uint32_t FindSlot(ResourceType type, StringId name);
+            std::shared_ptr<void> Resolve(ResourceType type, uint32_t index);
+
+            void WatchFile(ResourceType type, const std::string& name, const Filesystem::Path& path);
+            void LinkMaterial(const std::string& name, Rendering::Material& material);
+            bool Reload(ResourceType type, const std::string& name, std::unordered_set<const void*>& changed);
+            bool ReloadModel(const std::string& name, std::unordered_set<const void*>& changed);
+            void ResubmitModels(const std::unordered_set<const void*>& changed);
+
+            std::unordered_map<std::string, Filesystem::Path> sources[static_cast<int>(ResourceType::Count)];
+            // Loaded resources of a type, from the least to the most recently used
+            struct RecencyList {
+                struct Node {
+                    std::string name;
+                    uint32_t older = UINT32_MAX;
+                    uint32_t newer = UINT32_MAX;
+                    bool linked = false;
+                };
+
+                std::vector<Node> nodes;                            // Never shrinks, a name keeps its node
+                std::unordered_map<std::string, uint32_t> indices;
+                uint32_t oldest = UINT32_MAX;
+                uint32_t newest = UINT32_MAX;
+
+                uint32_t GetNode(const std::string& name);
+                void Touch(uint32_t node);
+                void Remove(uint32_t node);
+                void Clear();
+            };
+
+            RecencyList recency[static_cast<int>(ResourceType::Count)];
+            std::unordered_map<std::string, std::string> meshModels;                // Mesh name -> model name
+            std::unordered_map<std::string, std::vector<std::string>> modelMeshes;  // Model name -> mesh names, while loaded
+
+            std::vector<HandleSlot> slots[static_cast<int>(ResourceType::Count)];
+            std::unordered_map<StringId, uint32_t> slotIndices[static_cast<int>(ResourceType::Count)];
+
+            std::unordered_map<std::string, std::vector<ResourceKey>> fileResources;   // Absolute path -> resources read from it
+            std::map<ResourceKey, std::set<ResourceKey>> dependents;                    // Resource -> resources built from it
+            std::unique_ptr<Filesystem::FileWatcher> watcher;
+
+            AssetManifest manifest;
         };
 
         #if defined(BUILD_EDITOR)
@@ -0,0 +1,69 @@
+#include "string_id.hpp"
+
+#include "engine/debugging/debugger.hpp"
+
+#include <unordered_map>
+#include <shared_mutex>
+#include <mutex>
+
+namespace Epoch::Engine::Core{
+
+    namespace {
+        struct StringTable {
+            std::unordered_map<uint64_t, std::string> strings;
+            std::shared_mutex mutex;
+        };
+
+        StringTable& GetTable() {
+            static StringTable table;
+            return table;
+        }
+
+        bool SameName(std::string_view a, std::string_view b) {
+            if (a.size() != b.size())
+                return false;
+            for (size_t i = 0; i < a.size(); i++) {
+                char ca = a[i] == '/' ? '\\' : a[i];
+                char cb = b[i] == '/' ? '\\' : b[i];
+                if (ca != cb)
+                    return false;
+            }
+            return true;
+        }
+    }
+
+    /// @brief Hashes a name and records it. Names are interned from the loaders (worker threads included)
+    /// @param name The name, any separator
+    /// @return The id of the name
+    StringId StringId::Intern(std::string_view name)
+    {
+        StringId id(name);
+        StringTable& table = GetTable();
+
+        {
+            std::shared_lock lock(table.mutex);
+            auto it = table.strings.find(id.value);
+            if (it != table.strings.end()) {
+                if (!SameName(it->second, name))
+                    DEBUG_ERROR("String id collision between '" + it->second + "' and '" + std::string(name) + "'");
+                return id;
+            }
+        }
+
+        // The first spelling is kept as is, it is the one the resource maps are keyed with
+        std::unique_lock lock(table.mutex);
+        table.strings.emplace(id.value, std::string(name));
+        return id;
+    }
+
+    const std::string& StringId::GetString() const
+    {
+        static const std::string empty;
+
+        StringTable& table = GetTable();
+        std::shared_lock lock(table.mutex);
+        auto it = table.strings.find(value);
+        // Entries are never erased, the reference stays valid once the lock is released
+        return it != table.strings.end() ? it->second : empty;
+    }
+}
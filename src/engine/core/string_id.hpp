@@ -0,0 +1,58 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <functional>
+
+namespace Epoch::Engine::Core{
+
+    // 64 bits hash of a name, computed at compile time for literals. '/' and '\' hash the same,
+    // so "textures/a.png" and "textures\\a.png" are the same id
+    class StringId {
+        public:
+            constexpr StringId() = default;
+            constexpr explicit StringId(std::string_view name) : value(Hash(name)) {}
+
+            /// @brief Hashes a name and keeps a copy of its first spelling, so GetString can give it back
+            static StringId Intern(std::string_view name);
+
+            /// @brief The interned name, empty if it was never interned
+            const std::string& GetString() const;
+
+            constexpr uint64_t GetValue() const { return value; }
+            constexpr bool IsValid() const { return value != 0; }
+
+            constexpr bool operator==(StringId other) const { return value == other.value; }
+            constexpr bool operator!=(StringId other) const { return value != other.value; }
+            constexpr bool operator<(StringId other) const { return value < other.value; }
+
+            // FNV-1a
+            static constexpr uint64_t Hash(std::string_view name) {
+                uint64_t hash = 14695981039346656037ull;
+                for (char c : name) {
+                    hash ^= static_cast<uint8_t>(c == '/' ? '\\' : c);
+                    hash *= 1099511628211ull;
+                }
+                return hash;
+            }
+
+        private:
+            uint64_t value = 0;
+    };
+
+    namespace Literals{
+        constexpr StringId operator""_sid(const char* name, size_t length) {
+            return StringId(std::string_view(name, length));
+        }
+    }
+}
+
+namespace std{
+    template<>
+    struct hash<Epoch::Engine::Core::StringId> {
+        size_t operator()(Epoch::Engine::Core::StringId id) const noexcept {
+            return static_cast<size_t>(id.GetValue());
+        }
+    };
+}
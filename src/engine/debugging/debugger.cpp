@@ -46,6 +46,8 @@ namespace Epoch::Engine::Debugging{
         if (level < currentMinLevel)
             return;
 
+        std::lock_guard<std::mutex> lock(logMutex);
+
         std::string output = (useTimestamp ? GetTimestamp()+" " : "") + "[" + LevelToString(level) + "] (" + file + ":" + std::to_string(line) + ") " + message;
 
         std::cout << output << std::endl;
@@ -4,6 +4,7 @@
 #include <chrono>
 #include <iostream>
 #include <fstream>
+#include <mutex>
 
 namespace Epoch::Engine::Debugging{
     enum class Level {
@@ -32,6 +33,7 @@ namespace Epoch::Engine::Debugging{
         std::string GetTimestamp();
         Level currentMinLevel;
         std::ofstream logFile;
+        std::mutex logMutex;    // Resources are imported from worker threads
 
         bool useTimestamp;
 
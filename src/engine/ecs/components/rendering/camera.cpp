@@ -90,4 +90,21 @@ namespace Epoch::Engine::ECS::Components {
 			isOnOrForwardPlane(center, extents, camFrustum.farFace));
     }
 
+    /// @brief Builds the world space frustum of the camera, to be reused for several tests in a frame
+    Frustum Camera::GetFrustum() const
+    {
+        return createFrustumFromCamera(*this, float(width) / float(height), glm::radians(fov), nearPlane, farPlane);
+    }
+
+    /// @brief Checks a world space bounding sphere against a frustum returned by GetFrustum
+    bool Camera::IsSphereInFrustum(const Frustum &frustum, glm::vec3 center, float radius)
+    {
+        return (frustum.leftFace.getSignedDistanceToPlane(center) >= -radius &&
+            frustum.rightFace.getSignedDistanceToPlane(center) >= -radius &&
+            frustum.topFace.getSignedDistanceToPlane(center) >= -radius &&
+            frustum.bottomFace.getSignedDistanceToPlane(center) >= -radius &&
+            frustum.nearFace.getSignedDistanceToPlane(center) >= -radius &&
+            frustum.farFace.getSignedDistanceToPlane(center) >= -radius);
+    }
+
 }
\ No newline at end of file
@@ -59,6 +59,10 @@ namespace Epoch::Engine::ECS::Components {
 
             bool IsInFrustum(glm::vec3 boundsMin, glm::vec3 boundsMax);
 
+            Frustum GetFrustum() const;
+
+            static bool IsSphereInFrustum(const Frustum& frustum, glm::vec3 center, float radius);
+
             glm::mat4 GetMatrix()
             {
                 return cameraMatrix;
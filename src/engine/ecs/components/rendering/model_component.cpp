@@ -29,7 +29,10 @@ namespace Epoch::Engine::ECS::Components{
         {
             return;
         }
-        parent->level->meshes[parent->GetComponentIDInScene(local_id)] = { parent->transform->GetTransformMatrix(), mesh.get() };
+        // The entry is updated in place, it keeps the LOD of the previous shadow pass
+        Rendering::ShadowCaster& caster = parent->level->meshes[parent->GetComponentIDInScene(local_id)];
+        caster.model = parent->transform->GetTransformMatrix();
+        caster.mesh = mesh.get();
     }
 
     void Model::SetMaterials(std::vector<std::shared_ptr<Rendering::Material>>&& materials)
@@ -70,4 +73,15 @@ namespace Epoch::Engine::ECS::Components{
             Rendering::Renderer::GetInstance().RemoveCommands(cmds);
         }
     }
+
+    /// @brief Replaces the draw commands of the component, after its mesh or materials were reloaded in place
+    void Model::Resubmit()
+    {
+        if (!activated || !alreadySubmitted)
+            return;
+
+        RemoveFromDrawList();
+        alreadySubmitted = false;
+        Update();
+    }
 }
\ No newline at end of file
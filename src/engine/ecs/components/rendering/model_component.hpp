@@ -23,6 +23,7 @@ namespace Epoch::Engine::ECS::Components
 
             void Update();
             void RemoveFromDrawList();
+            void Resubmit();
         private:
 
             bool alreadySubmitted = false;
@@ -0,0 +1,622 @@
+#include "archive.hpp"
+#include "mapped_file.hpp"
+
+#include "engine/debugging/debugger.hpp"
+
+#include <cstring>
+#include <map>
+#include <set>
+#include <deque>
+#include <algorithm>
+#include <numeric>
+
+namespace Epoch::Engine::Filesystem{
+
+    namespace {
+        // Bounds checked reader over the mapping, fields are unaligned
+        struct Reader {
+            const uint8_t* data;
+            size_t size;
+            size_t position;
+
+            template<typename T>
+            bool Read(T& value) {
+                if (position + sizeof(T) > size)
+                    return false;
+                std::memcpy(&value, data + position, sizeof(T));
+                position += sizeof(T);
+                return true;
+            }
+
+            bool Read(std::string_view& value, size_t length) {
+                if (position + length > size)
+                    return false;
+                value = std::string_view(reinterpret_cast<const char*>(data + position), length);
+                position += length;
+                return true;
+            }
+        };
+
+        uint32_t GetBucketCount(size_t count) {
+            uint32_t buckets = 2;
+            while (buckets < count * 2)
+                buckets *= 2;
+            return buckets;
+        }
+
+        std::string_view GetDirectoryOf(std::string_view path) {
+            size_t slash = path.rfind('/');
+            return slash == std::string_view::npos ? std::string_view() : path.substr(0, slash);
+        }
+
+        template<typename T>
+        void Append(std::vector<uint8_t>& out, const T* values, size_t count) {
+            const uint8_t* bytes = reinterpret_cast<const uint8_t*>(values);
+            out.insert(out.end(), bytes, bytes + sizeof(T) * count);
+        }
+    }
+
+    // FNV-1a
+    uint64_t Archive::HashPath(std::string_view path)
+    {
+        uint64_t hash = 14695981039346656037ull;
+        for (char c : path) {
+            hash ^= static_cast<uint8_t>(c);
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    /// @brief Maps an archive and parses its index
+    /// @param path The path of the .caf file
+    /// @return The archive, or nullptr if it can't be opened or is malformed
+    std::shared_ptr<Archive> Archive::Open(const std::string &path)
+    {
+        std::shared_ptr<Archive> archive(new Archive());
+        archive->path = path;
+        archive->file = MappedFile::Open(Path(path));
+        if (!archive->file)
+            return nullptr;
+
+        if (!archive->ParseIndex()) {
+            DEBUG_ERROR("Invalid archive : " + path);
+            return nullptr;
+        }
+        return archive;
+    }
+
+    bool Archive::ParseIndex()
+    {
+        Reader reader{ file->GetData(), file->GetSize(), 0 };
+        if (reader.size < ARCHIVE_HEADER_SIZE || std::memcmp(reader.data, "COSEM", 5) != 0)
+            return false;
+        reader.position = 5;
+
+        // Version 1 addresses 32 bits, version 2 64 bits and gives the alignment of the payloads
+        uint32_t fileCount = 0;
+        uint64_t indexOffset = 0;
+        if (!reader.Read(version) || !reader.Read(fileCount))
+            return false;
+
+        if (version == 1) {
+            uint32_t offset = 0;
+            if (!reader.Read(offset))
+                return false;
+            indexOffset = offset;
+            payloadAlignment = 1;
+        }
+        else if (version == 2) {
+            uint64_t dataOffset = 0;
+            if (!reader.Read(indexOffset) || !reader.Read(dataOffset) || !reader.Read(payloadAlignment))
+                return false;
+            if (payloadAlignment == 0 || (payloadAlignment & (payloadAlignment - 1)) != 0)
+                return false;
+        }
+        else {
+            DEBUG_ERROR("Unsupported archive version " + std::to_string(version) + " : " + path);
+            return false;
+        }
+
+        // Every entry takes at least its fixed fields, so a corrupted count can't make the index huge
+        size_t sizeWidth = version == 1 ? sizeof(uint32_t) : sizeof(uint64_t);
+        size_t minimumEntrySize = sizeof(uint16_t) + 3 * sizeWidth + sizeof(uint8_t);
+        if (indexOffset > reader.size || fileCount > (reader.size - indexOffset) / minimumEntrySize)
+            return false;
+
+        reader.position = static_cast<size_t>(indexOffset);
+        entries.resize(fileCount);
+
+        auto readSize = [&reader, wide = version == 2](uint64_t& value) {
+            if (wide)
+                return reader.Read(value);
+            uint32_t narrow = 0;
+            bool valid = reader.Read(narrow);
+            value = narrow;
+            return valid;
+        };
+
+        for (ArchiveEntry& entry : entries) {
+            uint16_t pathLength = 0;
+            uint64_t originalSize = 0;
+            if (!reader.Read(pathLength) || !reader.Read(entry.path, pathLength)
+                || !readSize(entry.offset) || !readSize(entry.storedSize) || !readSize(originalSize) || !reader.Read(entry.flags))
+                return false;
+
+            if (entry.offset > reader.size || entry.storedSize > reader.size - entry.offset)
+                return false;
+
+            // Zero or one codec bit, chunked entries have one
+            if ((entry.flags & ARCHIVE_CODEC_MASK) != 0 && !entry.IsCompressed())
+                return false;
+            if (entry.IsChunked() && !entry.IsCompressed())
+                return false;
+
+            entry.originalSize = entry.IsCompressed() ? originalSize : entry.storedSize;
+        }
+
+        // Archives written by ArchiveWriter carry their lookup tables, the others get them built here
+        const uint8_t* data = file->GetData();
+        size_t size = file->GetSize();
+        if (size >= reader.position + ARCHIVE_FOOTER_SIZE && std::memcmp(data + size - 4, "CAFX", 4) == 0) {
+            uint64_t lookupOffset = 0;
+            uint32_t lookupSize = 0;
+            std::memcpy(&lookupOffset, data + size - ARCHIVE_FOOTER_SIZE, sizeof(lookupOffset));
+            std::memcpy(&lookupSize, data + size - ARCHIVE_FOOTER_SIZE + 8, sizeof(lookupSize));
+
+            // Each value is checked on its own so a corrupt offset cannot wrap the sum
+            size_t lookupEnd = size - ARCHIVE_FOOTER_SIZE;
+            if (lookupOffset % 8 == 0 && lookupOffset <= lookupEnd && lookupSize <= lookupEnd - lookupOffset
+                && AttachLookup(data + lookupOffset, lookupSize))
+                return true;
+            DEBUG_WARNING("Invalid lookup tables in archive, rebuilding them : " + path);
+        }
+
+        std::vector<std::string_view> paths;
+        std::vector<uint64_t> sizes;
+        paths.reserve(entries.size());
+        sizes.reserve(entries.size());
+        for (const ArchiveEntry& entry : entries) {
+            paths.push_back(entry.path);
+            sizes.push_back(entry.originalSize);
+        }
+
+        lookupStorage = BuildLookup(paths, sizes);
+        return AttachLookup(lookupStorage.data(), lookupStorage.size());
+    }
+
+    /// @brief Builds the hash tables and the directory tree of an archive
+    /// @param paths The path of every entry, in index order
+    /// @param sizes The original size of every entry, summed in the directories
+    /// @return The section, starting with an ArchiveLookupHeader
+    std::vector<uint8_t> Archive::BuildLookup(const std::vector<std::string_view> &paths, const std::vector<uint64_t> &sizes)
+    {
+        // Every directory, ancestors included, with its children sorted by name
+        std::map<std::string_view, std::set<std::string_view>> children;
+        children[std::string_view()];
+        for (std::string_view filePath : paths) {
+            std::string_view directory = GetDirectoryOf(filePath);
+            while (children.find(directory) == children.end()) {
+                std::string_view parent = GetDirectoryOf(directory);
+                children[directory];
+                children[parent].insert(directory);
+                directory = parent;
+            }
+        }
+
+        // Breadth first numbering keeps the children of a directory contiguous
+        std::vector<std::string_view> order;
+        std::map<std::string_view, uint32_t> indices;
+        std::vector<ArchiveDirectory> directories;
+        std::deque<std::string_view> queue{ std::string_view() };
+        while (!queue.empty()) {
+            std::string_view directory = queue.front();
+            queue.pop_front();
+            indices[directory] = static_cast<uint32_t>(order.size());
+            order.push_back(directory);
+            for (std::string_view child : children[directory])
+                queue.push_back(child);
+        }
+
+        std::string namesBlob;
+        directories.resize(order.size());
+        for (uint32_t i = 0; i < order.size(); i++) {
+            ArchiveDirectory& directory = directories[i];
+            directory = ArchiveDirectory{};
+            directory.parent = i == 0 ? UINT32_MAX : indices[GetDirectoryOf(order[i])];
+            directory.nameOffset = static_cast<uint32_t>(namesBlob.size());
+            directory.nameLength = static_cast<uint32_t>(order[i].size());
+            namesBlob += order[i];
+
+            const std::set<std::string_view>& subdirectories = children[order[i]];
+            directory.childCount = static_cast<uint32_t>(subdirectories.size());
+            directory.firstChild = subdirectories.empty() ? 0 : indices[*subdirectories.begin()];
+        }
+
+        // Files grouped by directory, sorted by path inside each group
+        std::vector<uint32_t> fileDirectories(paths.size());
+        for (uint32_t i = 0; i < paths.size(); i++) {
+            fileDirectories[i] = indices[GetDirectoryOf(paths[i])];
+            for (uint32_t d = fileDirectories[i]; d != UINT32_MAX; d = directories[d].parent)
+                directories[d].totalSize += sizes[i];
+        }
+
+        std::vector<uint32_t> directoryFiles(paths.size());
+        std::iota(directoryFiles.begin(), directoryFiles.end(), 0);
+        std::sort(directoryFiles.begin(), directoryFiles.end(), [&](uint32_t a, uint32_t b) {
+            if (fileDirectories[a] != fileDirectories[b])
+                return fileDirectories[a] < fileDirectories[b];
+            return paths[a] < paths[b];
+        });
+
+        for (uint32_t i = 0; i < directoryFiles.size(); i++) {
+            ArchiveDirectory& directory = directories[fileDirectories[directoryFiles[i]]];
+            if (directory.fileCount++ == 0)
+                directory.firstFile = i;
+        }
+
+        // Hash tables
+        auto buildBuckets = [](const std::vector<uint64_t>& hashes) {
+            std::vector<uint32_t> buckets(GetBucketCount(hashes.size()), 0);
+            uint32_t mask = static_cast<uint32_t>(buckets.size()) - 1;
+            for (uint32_t i = 0; i < hashes.size(); i++) {
+                uint32_t bucket = static_cast<uint32_t>(hashes[i]) & mask;
+                while (buckets[bucket] != 0)
+                    bucket = (bucket + 1) & mask;
+                buckets[bucket] = i + 1;
+            }
+            return buckets;
+        };
+
+        std::vector<uint64_t> fileHashes(paths.size());
+        for (size_t i = 0; i < paths.size(); i++)
+            fileHashes[i] = HashPath(paths[i]);
+
+        std::vector<uint64_t> directoryHashes(order.size());
+        for (size_t i = 0; i < order.size(); i++)
+            directoryHashes[i] = HashPath(order[i]);
+
+        std::vector<uint32_t> fileBuckets = buildBuckets(fileHashes);
+        std::vector<uint32_t> directoryBuckets = buildBuckets(directoryHashes);
+
+        ArchiveLookupHeader header;
+        std::memcpy(header.magic, "CIDX", 4);
+        header.fileCount = static_cast<uint32_t>(paths.size());
+        header.directoryCount = static_cast<uint32_t>(order.size());
+        header.fileBucketCount = static_cast<uint32_t>(fileBuckets.size());
+        header.directoryBucketCount = static_cast<uint32_t>(directoryBuckets.size());
+        header.namesSize = static_cast<uint32_t>(namesBlob.size());
+
+        std::vector<uint8_t> out;
+        Append(out, &header, 1);
+        Append(out, fileHashes.data(), fileHashes.size());
+        Append(out, directoryHashes.data(), directoryHashes.size());
+        Append(out, directories.data(), directories.size());
+        Append(out, fileBuckets.data(), fileBuckets.size());
+        Append(out, directoryBuckets.data(), directoryBuckets.size());
+        Append(out, directoryFiles.data(), directoryFiles.size());
+        Append(out, namesBlob.data(), namesBlob.size());
+        return out;
+    }
+
+    /// @brief Points the lookup tables at a section, after checking it matches the index
+    bool Archive::AttachLookup(const uint8_t* data, size_t size)
+    {
+        if (size < sizeof(ArchiveLookupHeader))
+            return false;
+
+        const ArchiveLookupHeader* header = reinterpret_cast<const ArchiveLookupHeader*>(data);
+        if (std::memcmp(header->magic, "CIDX", 4) != 0 || header->fileCount != entries.size() || header->directoryCount == 0
+            || (header->fileBucketCount & (header->fileBucketCount - 1)) != 0 || (header->directoryBucketCount & (header->directoryBucketCount - 1)) != 0
+            || header->fileBucketCount <= header->fileCount || header->directoryBucketCount <= header->directoryCount)
+            return false;
+
+        uint64_t expected = sizeof(ArchiveLookupHeader)
+            + sizeof(uint64_t) * (uint64_t(header->fileCount) + header->directoryCount)
+            + sizeof(ArchiveDirectory) * uint64_t(header->directoryCount)
+            + sizeof(uint32_t) * (uint64_t(header->fileBucketCount) + header->directoryBucketCount + header->fileCount)
+            + header->namesSize;
+        if (expected != size)
+            return false;
+
+        const uint8_t* cursor = data + sizeof(ArchiveLookupHeader);
+        auto take = [&cursor](auto*& array, size_t count) {
+            array = reinterpret_cast<std::remove_reference_t<decltype(array)>>(cursor);
+            cursor += sizeof(*array) * count;
+        };
+
+        take(fileHashes, header->fileCount);
+        take(directoryHashes, header->directoryCount);
+        take(directories, header->directoryCount);
+        take(fileBuckets, header->fileBucketCount);
+        take(directoryBuckets, header->directoryBucketCount);
+        take(directoryFiles, header->fileCount);
+        names = reinterpret_cast<const char*>(cursor);
+
+        // Children come after their parent and point back to it, so the recursive listings visit each directory once
+        for (uint32_t i = 0; i < header->directoryCount; i++) {
+            const ArchiveDirectory& directory = directories[i];
+            if (uint64_t(directory.firstChild) + directory.childCount > header->directoryCount
+                || (directory.childCount > 0 && directory.firstChild <= i)
+                || uint64_t(directory.firstFile) + directory.fileCount > header->fileCount
+                || uint64_t(directory.nameOffset) + directory.nameLength > header->namesSize)
+                return false;
+
+            for (uint32_t child = 0; child < directory.childCount; child++)
+                if (directories[directory.firstChild + child].parent != i)
+                    return false;
+        }
+        for (uint32_t i = 0; i < header->fileCount; i++)
+            if (directoryFiles[i] >= header->fileCount)
+                return false;
+
+        lookup = header;
+        return true;
+    }
+
+    const ArchiveEntry* Archive::Find(std::string_view path) const
+    {
+        uint64_t hash = HashPath(path);
+        uint32_t mask = lookup->fileBucketCount - 1;
+        uint32_t bucket = static_cast<uint32_t>(hash) & mask;
+
+        // Bounded, a corrupted table may have no empty bucket
+        for (uint32_t probe = 0; probe < lookup->fileBucketCount && fileBuckets[bucket] != 0; probe++, bucket = (bucket + 1) & mask) {
+            uint32_t index = fileBuckets[bucket] - 1;
+            if (index < entries.size() && fileHashes[index] == hash && entries[index].path == path)
+                return &entries[index];
+        }
+        return nullptr;
+    }
+
+    /// @return The index of a directory, UINT32_MAX if the archive has no such directory
+    uint32_t Archive::FindDirectory(std::string_view directory) const
+    {
+        while (!directory.empty() && directory.back() == '/')
+            directory.remove_suffix(1);
+
+        uint64_t hash = HashPath(directory);
+        uint32_t mask = lookup->directoryBucketCount - 1;
+        uint32_t bucket = static_cast<uint32_t>(hash) & mask;
+        for (uint32_t probe = 0; probe < lookup->directoryBucketCount && directoryBuckets[bucket] != 0; probe++, bucket = (bucket + 1) & mask) {
+            uint32_t index = directoryBuckets[bucket] - 1;
+            if (index < lookup->directoryCount && directoryHashes[index] == hash && GetDirectoryName(directories[index]) == directory)
+                return index;
+        }
+        return UINT32_MAX;
+    }
+
+    std::vector<const ArchiveEntry*> Archive::ListFiles(std::string_view directory, bool recursive) const
+    {
+        std::vector<const ArchiveEntry*> files;
+        uint32_t root = FindDirectory(directory);
+        if (root == UINT32_MAX)
+            return files;
+
+        std::vector<uint32_t> stack{ root };
+        while (!stack.empty()) {
+            const ArchiveDirectory& current = directories[stack.back()];
+            stack.pop_back();
+
+            for (uint32_t i = 0; i < current.fileCount; i++)
+                files.push_back(&entries[directoryFiles[current.firstFile + i]]);
+
+            if (recursive)
+                for (uint32_t i = 0; i < current.childCount; i++)
+                    stack.push_back(current.firstChild + i);
+        }
+        return files;
+    }
+
+    std::vector<std::string_view> Archive::ListDirectories(std::string_view directory, bool recursive) const
+    {
+        std::vector<std::string_view> result;
+        uint32_t root = FindDirectory(directory);
+        if (root == UINT32_MAX)
+            return result;
+
+        std::vector<uint32_t> stack{ root };
+        while (!stack.empty()) {
+            const ArchiveDirectory& current = directories[stack.back()];
+            stack.pop_back();
+
+            for (uint32_t i = 0; i < current.childCount; i++) {
+                result.push_back(GetDirectoryName(directories[current.firstChild + i]));
+                if (recursive)
+                    stack.push_back(current.firstChild + i);
+            }
+        }
+        return result;
+    }
+
+    /// @brief Locates the block table of a chunked entry, after checking it fits in the entry
+    bool Archive::GetBlockTable(const ArchiveEntry &entry, BlockTable &table) const
+    {
+        const uint8_t* payload = file->GetData() + entry.offset;
+        if (entry.storedSize < 2 * sizeof(uint32_t))
+            return false;
+
+        std::memcpy(&table.blockSize, payload, sizeof(uint32_t));
+        std::memcpy(&table.blockCount, payload + sizeof(uint32_t), sizeof(uint32_t));
+        if (table.blockSize == 0 || table.blockCount != (entry.originalSize + table.blockSize - 1) / table.blockSize)
+            return false;
+
+        uint64_t tableSize = 2 * sizeof(uint32_t) + uint64_t(table.blockCount) * sizeof(uint32_t);
+        if (tableSize > entry.storedSize)
+            return false;
+
+        table.ends = payload + 2 * sizeof(uint32_t);
+        table.blocks = payload + tableSize;
+
+        // Every end is read by DecompressBlock, not only the last one
+        uint64_t previousEnd = 0;
+        for (uint32_t block = 0; block < table.blockCount; block++) {
+            uint32_t end = 0;
+            std::memcpy(&end, table.ends + uint64_t(block) * sizeof(uint32_t), sizeof(uint32_t));
+            end &= ~ARCHIVE_BLOCK_STORED;
+            if (end < previousEnd || end > entry.storedSize - tableSize)
+                return false;
+            previousEnd = end;
+        }
+        return true;
+    }
+
+    bool Archive::DecompressBlock(const ArchiveEntry &entry, const BlockTable &table, uint32_t block, uint8_t* destination) const
+    {
+        uint32_t start = 0, end = 0;
+        if (block > 0)
+            std::memcpy(&start, table.ends + (block - 1) * sizeof(uint32_t), sizeof(uint32_t));
+        std::memcpy(&end, table.ends + block * sizeof(uint32_t), sizeof(uint32_t));
+
+        bool stored = end & ARCHIVE_BLOCK_STORED;
+        start &= ~ARCHIVE_BLOCK_STORED;
+        end &= ~ARCHIVE_BLOCK_STORED;
+
+        uint64_t blockStart = uint64_t(block) * table.blockSize;
+        size_t originalSize = static_cast<size_t>(std::min<uint64_t>(table.blockSize, entry.originalSize - blockStart));
+        if (end < start)
+            return false;
+
+        return DecompressArchiveData(stored ? ArchiveCodec::None : entry.GetCodec(), table.blocks + start, end - start, destination, originalSize);
+    }
+
+    bool Archive::Decompress(const ArchiveEntry &entry, uint8_t* destination) const
+    {
+        if (entry.IsChunked()) {
+            BlockTable table;
+            bool valid = GetBlockTable(entry, table);
+            for (uint32_t block = 0; valid && block < table.blockCount; block++)
+                valid = DecompressBlock(entry, table, block, destination + uint64_t(block) * table.blockSize);
+
+            if (!valid)
+                DEBUG_ERROR("Failed to decompress '" + std::string(entry.path) + "' from " + path);
+            return valid;
+        }
+
+        if (!DecompressArchiveData(entry.GetCodec(), file->GetData() + entry.offset, static_cast<size_t>(entry.storedSize), destination, static_cast<size_t>(entry.originalSize))) {
+            DEBUG_ERROR("Failed to decompress '" + std::string(entry.path) + "' from " + path);
+            return false;
+        }
+        return true;
+    }
+
+    bool Archive::Read(const ArchiveEntry &entry, ArchiveData &out) const
+    {
+        out.owner = shared_from_this();
+
+        if (!entry.IsCompressed()) {
+            out.data = file->GetData() + entry.offset;
+            out.size = static_cast<size_t>(entry.storedSize);
+            return true;
+        }
+
+        out.buffer.resize(static_cast<size_t>(entry.originalSize));
+        if (!Decompress(entry, out.buffer.data()))
+            return false;
+        out.data = out.buffer.data();
+        out.size = out.buffer.size();
+        return true;
+    }
+
+    bool Archive::Read(const ArchiveEntry &entry, std::string &out) const
+    {
+        if (!entry.IsCompressed()) {
+            out.assign(reinterpret_cast<const char*>(file->GetData() + entry.offset), static_cast<size_t>(entry.storedSize));
+            return true;
+        }
+
+        out.resize(static_cast<size_t>(entry.originalSize));
+        return Decompress(entry, reinterpret_cast<uint8_t*>(out.data()));
+    }
+
+    bool Archive::ReadRange(const ArchiveEntry &entry, uint64_t offset, size_t length, uint8_t* destination) const
+    {
+        if (offset > entry.originalSize || length > entry.originalSize - offset) {
+            DEBUG_ERROR("Out of bounds read in '" + std::string(entry.path) + "' from " + path);
+            return false;
+        }
+        if (length == 0)
+            return true;
+
+        if (!entry.IsCompressed()) {
+            std::memcpy(destination, file->GetData() + entry.offset + offset, length);
+            return true;
+        }
+
+        thread_local std::vector<uint8_t> scratch;
+
+        if (!entry.IsChunked()) {
+            scratch.resize(static_cast<size_t>(entry.originalSize));
+            if (!Decompress(entry, scratch.data()))
+                return false;
+            std::memcpy(destination, scratch.data() + offset, length);
+            return true;
+        }
+
+        BlockTable table;
+        if (!GetBlockTable(entry, table)) {
+            DEBUG_ERROR("Invalid block table in '" + std::string(entry.path) + "' from " + path);
+            return false;
+        }
+
+        uint64_t end = offset + length;
+        for (uint32_t block = static_cast<uint32_t>(offset / table.blockSize); uint64_t(block) * table.blockSize < end; block++) {
+            uint64_t blockStart = uint64_t(block) * table.blockSize;
+            uint64_t blockEnd = std::min<uint64_t>(blockStart + table.blockSize, entry.originalSize);
+            uint64_t copyStart = std::max(blockStart, offset);
+            uint64_t copyEnd = std::min(blockEnd, end);
+            uint8_t* target = destination + (copyStart - offset);
+
+            // Whole blocks decompress in place, the partial ones at the edges of the range go through the scratch buffer
+            bool ok;
+            if (copyStart == blockStart && copyEnd == blockEnd) {
+                ok = DecompressBlock(entry, table, block, target);
+            }
+            else {
+                scratch.resize(static_cast<size_t>(blockEnd - blockStart));
+                ok = DecompressBlock(entry, table, block, scratch.data());
+                if (ok)
+                    std::memcpy(target, scratch.data() + (copyStart - blockStart), static_cast<size_t>(copyEnd - copyStart));
+            }
+
+            if (!ok) {
+                DEBUG_ERROR("Failed to decompress block " + std::to_string(block) + " of '" + std::string(entry.path) + "' from " + path);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    size_t Archive::GetDirectorySize(std::string_view directory) const
+    {
+        uint32_t index = FindDirectory(directory);
+        return index != UINT32_MAX ? static_cast<size_t>(directories[index].totalSize) : 0;
+    }
+
+    /// @brief Gives the archive at a path, mapping it on the first call
+    /// @return The archive, or nullptr if it can't be opened
+    std::shared_ptr<Archive> ArchiveCache::Get(const std::string &archivePath)
+    {
+        std::lock_guard lock(mutex);
+
+        auto it = archives.find(archivePath);
+        if (it != archives.end())
+            return it->second;
+
+        std::shared_ptr<Archive> archive = Archive::Open(archivePath);
+        if (archive)
+            archives.emplace(archivePath, archive);
+        return archive;
+    }
+
+    void ArchiveCache::Evict(const std::string &archivePath)
+    {
+        std::lock_guard lock(mutex);
+        archives.erase(archivePath);
+    }
+
+    void ArchiveCache::Clear()
+    {
+        std::lock_guard lock(mutex);
+        archives.clear();
+    }
+}
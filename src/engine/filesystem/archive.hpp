@@ -0,0 +1,183 @@
+#pragma once
+
+#include "filesystem.hpp"
+#include "archive_codec.hpp"
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <cstdint>
+
+namespace Epoch::Engine::Filesystem{
+
+    class MappedFile;
+
+    // Layout of a .caf archive (little endian, unpadded fields) :
+    //   header : "COSEM", uint8 version, uint32 file count, then
+    //            v1 : uint32 index offset, uint32 data offset
+    //            v2 : uint64 index offset, uint64 data offset, uint32 payload alignment (a power of two)
+    //   index  : per file, uint16 path length, path, data offset (from the start of the archive),
+    //            stored size, original size, uint8 flags (see archive_codec.hpp). Offsets and sizes are uint32 in v1, uint64 in v2
+    //   data   : the payloads, back to back in v1, each starting on a multiple of the alignment in v2.
+    //            Identical payloads may be shared by several entries
+    //   lookup : optional, see ArchiveLookupHeader. Located by the footer, CosemUnPacker ignores it
+    //   footer : uint64 lookup offset, uint32 lookup size, "CAFX"
+    // CosemUnPacker only reads v1
+
+    constexpr uint8_t ARCHIVE_VERSION = 2;
+    constexpr size_t ARCHIVE_HEADER_SIZE = 18;          // v1
+    constexpr size_t ARCHIVE_HEADER_SIZE_V2 = 30;
+    constexpr size_t ARCHIVE_FOOTER_SIZE = 16;
+
+    // Precomputed lookup tables, 8 bytes aligned. The arrays follow the header in this order :
+    //   uint64 file hashes[fileCount], uint64 directory hashes[directoryCount], ArchiveDirectory[directoryCount],
+    //   uint32 file buckets[fileBucketCount], uint32 directory buckets[directoryBucketCount],
+    //   uint32 directory files[fileCount], char names[namesSize]
+    // Buckets hold an index + 1 (0 for empty) and are probed linearly from hash & (count - 1)
+    struct ArchiveLookupHeader {
+        char magic[4];                  // "CIDX"
+        uint32_t fileCount;
+        uint32_t directoryCount;
+        uint32_t fileBucketCount;       // Powers of two
+        uint32_t directoryBucketCount;
+        uint32_t namesSize;
+    };
+
+    // Directories are stored breadth first, so the children of a directory are contiguous, and so are its files
+    struct ArchiveDirectory {
+        uint64_t totalSize;             // Original size of every file below it
+        uint32_t parent;                // UINT32_MAX for the root
+        uint32_t firstChild;
+        uint32_t childCount;
+        uint32_t firstFile;             // In the directory files table
+        uint32_t fileCount;
+        uint32_t nameOffset;            // Full path in the names blob, "" for the root
+        uint32_t nameLength;
+        uint32_t padding;
+    };
+
+    struct ArchiveEntry {
+        std::string_view path;      // '/' separated, relative to the archive. Points into the mapping
+        uint64_t offset = 0;
+        uint64_t storedSize = 0;
+        uint64_t originalSize = 0;
+        uint8_t flags = 0;
+
+        ArchiveCodec GetCodec() const { return GetArchiveCodec(flags); }
+        bool IsCompressed() const { return GetCodec() != ArchiveCodec::None; }
+        bool IsChunked() const { return flags & ARCHIVE_FLAG_CHUNKED; }
+    };
+
+    // Contents of an entry. Stored entries point into the archive mapping, compressed ones into "buffer"
+    struct ArchiveData {
+        const uint8_t* data = nullptr;
+        size_t size = 0;
+        std::vector<uint8_t> buffer;
+        std::shared_ptr<const void> owner;     // Keeps the mapping alive
+
+        bool IsValid() const { return data != nullptr || size == 0; }
+    };
+
+    // Memory-mapped archive with its parsed index. Immutable once opened, so it can be read from any thread
+    class Archive : public std::enable_shared_from_this<Archive> {
+        public:
+            static std::shared_ptr<Archive> Open(const std::string& path);
+
+            /// @brief Builds the lookup section of a set of paths, see ArchiveLookupHeader
+            static std::vector<uint8_t> BuildLookup(const std::vector<std::string_view>& paths, const std::vector<uint64_t>& sizes);
+
+            static uint64_t HashPath(std::string_view path);
+
+            const ArchiveEntry* Find(std::string_view path) const;
+
+            /// @brief Gives the contents of an entry without copying it when it is stored uncompressed
+            bool Read(const ArchiveEntry& entry, ArchiveData& out) const;
+
+            /// @brief Copies the contents of an entry, decompressing it straight into the string
+            bool Read(const ArchiveEntry& entry, std::string& out) const;
+
+            /// @brief Copies part of an entry. Chunked entries only decompress the blocks overlapping the range,
+            /// other compressed entries are decompressed whole
+            bool ReadRange(const ArchiveEntry& entry, uint64_t offset, size_t length, uint8_t* destination) const;
+
+            bool IsDirectory(std::string_view directory) const { return FindDirectory(directory) != UINT32_MAX; }
+
+            /// @brief Sum of the original sizes of the entries under a directory, "" for the whole archive
+            size_t GetDirectorySize(std::string_view directory) const;
+
+            std::vector<const ArchiveEntry*> ListFiles(std::string_view directory, bool recursive = false) const;
+            std::vector<std::string_view> ListDirectories(std::string_view directory, bool recursive = false) const;
+
+            const std::vector<ArchiveEntry>& GetEntries() const { return entries; }
+            const std::string& GetPath() const { return path; }
+            uint8_t GetVersion() const { return version; }
+
+            /// @brief Every payload starts on a multiple of this in the file, and so in the mapping (1 for v1 archives)
+            uint32_t GetPayloadAlignment() const { return payloadAlignment; }
+            bool HasStoredLookup() const { return lookupStorage.empty(); }
+
+        private:
+            Archive() = default;
+
+            bool ParseIndex();
+            bool AttachLookup(const uint8_t* data, size_t size);
+
+            struct BlockTable {
+                uint32_t blockSize = 0;
+                uint32_t blockCount = 0;
+                const uint8_t* ends = nullptr;      // Unaligned
+                const uint8_t* blocks = nullptr;
+            };
+
+            bool Decompress(const ArchiveEntry& entry, uint8_t* destination) const;
+            bool GetBlockTable(const ArchiveEntry& entry, BlockTable& table) const;
+            bool DecompressBlock(const ArchiveEntry& entry, const BlockTable& table, uint32_t block, uint8_t* destination) const;
+
+            uint32_t FindDirectory(std::string_view directory) const;
+            std::string_view GetDirectoryName(const ArchiveDirectory& directory) const { return std::string_view(names + directory.nameOffset, directory.nameLength); }
+
+            std::string path;
+            std::shared_ptr<MappedFile> file;
+            uint8_t version = 0;
+            uint32_t payloadAlignment = 1;
+            std::vector<ArchiveEntry> entries;
+
+            // Point into the mapping, or into lookupStorage for archives written without the lookup section
+            const ArchiveLookupHeader* lookup = nullptr;
+            const uint64_t* fileHashes = nullptr;
+            const uint64_t* directoryHashes = nullptr;
+            const ArchiveDirectory* directories = nullptr;
+            const uint32_t* fileBuckets = nullptr;
+            const uint32_t* directoryBuckets = nullptr;
+            const uint32_t* directoryFiles = nullptr;
+            const char* names = nullptr;
+            std::vector<uint8_t> lookupStorage;
+    };
+
+    // Every archive opened by the process, mapped and indexed once
+    class ArchiveCache {
+        public:
+            static ArchiveCache& GetInstance() {
+                static ArchiveCache instance;
+                return instance;
+            }
+
+            std::shared_ptr<Archive> Get(const std::string& archivePath);
+
+            /// @brief Forgets an archive, to open it again after it was rebuilt. Readers keep their mapping
+            void Evict(const std::string& archivePath);
+            void Clear();
+
+        private:
+            ArchiveCache() = default;
+            ~ArchiveCache() = default;
+            ArchiveCache(const ArchiveCache&) = delete;
+            ArchiveCache& operator=(const ArchiveCache&) = delete;
+
+            std::unordered_map<std::string, std::shared_ptr<Archive>> archives;
+            std::mutex mutex;
+    };
+}
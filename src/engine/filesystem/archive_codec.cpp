@@ -0,0 +1,303 @@
+#include "archive_codec.hpp"
+
+#include "engine/debugging/debugger.hpp"
+
+#include <string>
+#include <cstring>
+#include <algorithm>
+
+#include <zlib.h>
+
+#if defined(EPOCH_BROTLI)
+    #include <brotli/encode.h>
+    #include <brotli/decode.h>
+#endif
+
+namespace Epoch::Engine::Filesystem{
+
+    namespace LZ4{
+
+        namespace {
+            constexpr size_t MIN_MATCH = 4;
+            constexpr size_t LAST_LITERALS = 5;     // The last bytes of a block are always literals
+            constexpr size_t MF_LIMIT = 12;         // No match starts in the last 12 bytes
+            constexpr size_t MAX_DISTANCE = 65535;
+            constexpr int HASH_LOG = 16;
+
+            uint32_t Read32(const uint8_t* p) {
+                uint32_t value;
+                std::memcpy(&value, p, sizeof(value));
+                return value;
+            }
+
+            uint32_t Hash(uint32_t sequence) {
+                return (sequence * 2654435761u) >> (32 - HASH_LOG);
+            }
+
+            // Copies 8 bytes at a time, writing up to 7 bytes past the end. Works on overlapping ranges 8 bytes apart
+            void WildCopy(uint8_t* destination, const uint8_t* source, size_t length) {
+                uint8_t* end = destination + length;
+                do {
+                    std::memcpy(destination, source, 8);
+                    destination += 8;
+                    source += 8;
+                } while (destination < end);
+            }
+
+            uint8_t* WriteLength(uint8_t* out, size_t length) {
+                for (; length >= 255; length -= 255)
+                    *out++ = 255;
+                *out++ = static_cast<uint8_t>(length);
+                return out;
+            }
+
+            uint8_t* WriteLiterals(uint8_t* out, uint8_t* token, const uint8_t* literals, size_t count) {
+                *token = static_cast<uint8_t>(std::min<size_t>(count, 15) << 4);
+                if (count >= 15)
+                    out = WriteLength(out, count - 15);
+                if (count > 0)
+                    std::memcpy(out, literals, count);
+                return out + count;
+            }
+        }
+
+        size_t CompressBound(size_t size)
+        {
+            return size + size / 255 + 16;
+        }
+
+        /// @brief Greedy single pass compression with a 64K entries hash table
+        /// @return The compressed size, 0 if "capacity" is under CompressBound(size)
+        size_t Compress(const uint8_t* source, size_t size, uint8_t* destination, size_t capacity)
+        {
+            if (capacity < CompressBound(size))
+                return 0;
+
+            uint8_t* out = destination;
+            size_t anchor = 0;
+
+            if (size > MF_LIMIT) {
+                std::vector<uint32_t> table(size_t(1) << HASH_LOG, 0);
+                const size_t matchLimit = size - LAST_LITERALS;
+                const size_t inputLimit = size - MF_LIMIT;
+
+                size_t position = 1;
+                while (position < inputLimit) {
+                    uint32_t sequence = Read32(source + position);
+                    uint32_t& slot = table[Hash(sequence)];
+                    size_t candidate = slot;
+                    slot = static_cast<uint32_t>(position);
+
+                    if (candidate >= position || position - candidate > MAX_DISTANCE || Read32(source + candidate) != sequence) {
+                        // Skip faster through data that does not compress
+                        position += 1 + ((position - anchor) >> 6);
+                        continue;
+                    }
+
+                    while (position > anchor && candidate > 0 && source[position - 1] == source[candidate - 1]) {
+                        position--;
+                        candidate--;
+                    }
+
+                    size_t length = MIN_MATCH;
+                    while (position + length < matchLimit && source[candidate + length] == source[position + length])
+                        length++;
+
+                    uint8_t* token = out++;
+                    out = WriteLiterals(out, token, source + anchor, position - anchor);
+
+                    uint16_t offset = static_cast<uint16_t>(position - candidate);
+                    std::memcpy(out, &offset, sizeof(offset));
+                    out += sizeof(offset);
+
+                    size_t matchLength = length - MIN_MATCH;
+                    *token |= static_cast<uint8_t>(std::min<size_t>(matchLength, 15));
+                    if (matchLength >= 15)
+                        out = WriteLength(out, matchLength - 15);
+
+                    position += length;
+                    anchor = position;
+
+                    if (position - 2 < inputLimit)
+                        table[Hash(Read32(source + position - 2))] = static_cast<uint32_t>(position - 2);
+                }
+            }
+
+            uint8_t* token = out++;
+            out = WriteLiterals(out, token, source + anchor, size - anchor);
+            return static_cast<size_t>(out - destination);
+        }
+
+        /// @brief Decodes a block, every read and write is bounds checked
+        /// @return False if the block is malformed or does not decode to exactly "originalSize" bytes
+        bool Decompress(const uint8_t* source, size_t size, uint8_t* destination, size_t originalSize)
+        {
+            size_t in = 0, out = 0;
+
+            auto readLength = [&](size_t& length) {
+                uint8_t byte;
+                do {
+                    if (in >= size)
+                        return false;
+                    byte = source[in++];
+                    length += byte;
+                } while (byte == 255);
+                return true;
+            };
+
+            while (true) {
+                if (in >= size)
+                    return false;
+                uint8_t token = source[in++];
+
+                size_t literals = token >> 4;
+                if (literals == 15 && !readLength(literals))
+                    return false;
+                if (literals > size - in || literals > originalSize - out)
+                    return false;
+                if (size - in >= literals + 16 && originalSize - out >= literals + 16)
+                    WildCopy(destination + out, source + in, literals);
+                else
+                    std::memcpy(destination + out, source + in, literals);
+                in += literals;
+                out += literals;
+
+                // The last sequence has no match
+                if (in == size)
+                    return out == originalSize;
+
+                if (size - in < 2)
+                    return false;
+                uint16_t offset;
+                std::memcpy(&offset, source + in, sizeof(offset));
+                in += sizeof(offset);
+                if (offset == 0 || offset > out)
+                    return false;
+
+                size_t length = token & 15;
+                if (length == 15 && !readLength(length))
+                    return false;
+                length += MIN_MATCH;
+                if (length > originalSize - out)
+                    return false;
+
+                uint8_t* match = destination + out - offset;
+                if (offset >= 8 && originalSize - out >= length + 8) {
+                    WildCopy(destination + out, match, length);
+                }
+                else if (offset >= length) {
+                    std::memcpy(destination + out, match, length);
+                }
+                else {
+                    // Overlapping copy repeats the last "offset" bytes
+                    for (size_t i = 0; i < length; i++)
+                        destination[out + i] = match[i];
+                }
+                out += length;
+            }
+        }
+    }
+
+    bool IsArchiveCodecAvailable([[maybe_unused]] ArchiveCodec codec)
+    {
+#if !defined(EPOCH_BROTLI)
+        if (codec == ArchiveCodec::Brotli)
+            return false;
+#endif
+        return true;
+    }
+
+    bool CompressArchiveData(ArchiveCodec codec, const uint8_t* data, size_t size, std::vector<uint8_t>& out)
+    {
+        switch (codec) {
+            case ArchiveCodec::None:
+                out.assign(data, data + size);
+                return true;
+            case ArchiveCodec::Zlib: {
+                uLongf length = compressBound(static_cast<uLong>(size));
+                out.resize(length);
+                if (compress2(out.data(), &length, data, static_cast<uLong>(size), Z_BEST_COMPRESSION) != Z_OK)
+                    return false;
+                out.resize(length);
+                return true;
+            }
+            case ArchiveCodec::LZ4: {
+                out.resize(LZ4::CompressBound(size));
+                size_t length = LZ4::Compress(data, size, out.data(), out.size());
+                out.resize(length);
+                return length > 0;
+            }
+            case ArchiveCodec::Brotli: {
+#if defined(EPOCH_BROTLI)
+                size_t length = BrotliEncoderMaxCompressedSize(size);
+                out.resize(length > 0 ? length : size + 1024);
+                length = out.size();
+                if (!BrotliEncoderCompress(BROTLI_MAX_QUALITY, BROTLI_DEFAULT_WINDOW, BROTLI_MODE_GENERIC, size, data, &length, out.data()))
+                    return false;
+                out.resize(length);
+                return true;
+#else
+                DEBUG_ERROR("Brotli is not available in this build");
+                return false;
+#endif
+            }
+        }
+        return false;
+    }
+
+    bool DecompressArchiveData(ArchiveCodec codec, const uint8_t* data, size_t size, uint8_t* destination, size_t originalSize)
+    {
+        switch (codec) {
+            case ArchiveCodec::None:
+                if (size != originalSize)
+                    return false;
+                std::memcpy(destination, data, size);
+                return true;
+            case ArchiveCodec::Zlib: {
+                uLongf length = static_cast<uLongf>(originalSize);
+                return uncompress(destination, &length, data, static_cast<uLong>(size)) == Z_OK && length == originalSize;
+            }
+            case ArchiveCodec::LZ4:
+                return LZ4::Decompress(data, size, destination, originalSize);
+            case ArchiveCodec::Brotli: {
+#if defined(EPOCH_BROTLI)
+                size_t length = originalSize;
+                return BrotliDecoderDecompress(size, data, &length, destination) == BROTLI_DECODER_RESULT_SUCCESS && length == originalSize;
+#else
+                DEBUG_ERROR("Brotli is not available in this build");
+                return false;
+#endif
+            }
+        }
+        return false;
+    }
+
+    ArchiveCodec SelectArchiveCodec(std::string_view path, size_t size)
+    {
+        // Headers and framing cost more than they save
+        if (size < 256)
+            return ArchiveCodec::None;
+
+        std::string extension;
+        size_t dot = path.rfind('.');
+        if (dot != std::string_view::npos && path.find('/', dot) == std::string_view::npos)
+            extension = std::string(path.substr(dot));
+        std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+
+        static const char* const compressedFormats[] = { ".png", ".jpg", ".jpeg", ".gif", ".mp3", ".ogg", ".caf" };
+        static const char* const textFormats[] = { ".vert", ".frag", ".geom", ".json", ".mat", ".material", ".lvl", ".level",
+                                                   ".txt", ".md", ".ini", ".cfg", ".cpp", ".hpp", ".fnt" };
+
+        for (const char* format : compressedFormats)
+            if (extension == format)
+                return ArchiveCodec::None;
+
+        // Not Brotli, only the UNIX builds link a decoder and archives are shared between platforms
+        for (const char* format : textFormats)
+            if (extension == format)
+                return ArchiveCodec::Zlib;
+
+        // Meshes, cooked textures, shader binaries, sounds... are read on the loading path
+        return ArchiveCodec::LZ4;
+    }
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace Epoch::Engine::Filesystem{
+
+    // Entry flags, a single codec bit is set for compressed entries. CosemUnPacker only decodes unchunked zlib
+    constexpr uint8_t ARCHIVE_FLAG_COMPRESSED = 0x01;     // zlib stream, kept for the older archives
+    constexpr uint8_t ARCHIVE_FLAG_LZ4 = 0x02;            // LZ4 block, fastest to decode
+    constexpr uint8_t ARCHIVE_FLAG_BROTLI = 0x04;         // Brotli stream, best ratio
+    constexpr uint8_t ARCHIVE_CODEC_MASK = ARCHIVE_FLAG_COMPRESSED | ARCHIVE_FLAG_LZ4 | ARCHIVE_FLAG_BROTLI;
+    constexpr uint8_t ARCHIVE_FLAG_CHUNKED = 0x08;        // With a codec bit, the payload is split in independently compressed blocks
+
+    // Payload of a chunked entry :
+    //   uint32 block size (original bytes, the last block may be shorter), uint32 block count,
+    //   uint32 block ends[block count] (from the first block, bit 31 set for blocks stored uncompressed), blocks
+    constexpr uint32_t ARCHIVE_BLOCK_STORED = 0x80000000u;
+
+    enum class ArchiveCodec : uint8_t {
+        None = 0,
+        Zlib = ARCHIVE_FLAG_COMPRESSED,
+        LZ4 = ARCHIVE_FLAG_LZ4,
+        Brotli = ARCHIVE_FLAG_BROTLI
+    };
+
+    /// @brief The codec of a set of entry flags, None if several codec bits are set
+    inline ArchiveCodec GetArchiveCodec(uint8_t flags) {
+        switch (flags & ARCHIVE_CODEC_MASK) {
+            case ARCHIVE_FLAG_COMPRESSED: return ArchiveCodec::Zlib;
+            case ARCHIVE_FLAG_LZ4: return ArchiveCodec::LZ4;
+            case ARCHIVE_FLAG_BROTLI: return ArchiveCodec::Brotli;
+            default: return ArchiveCodec::None;
+        }
+    }
+
+    /// @brief Brotli is only built on UNIX
+    bool IsArchiveCodecAvailable(ArchiveCodec codec);
+
+    /// @brief Compresses a buffer, at the highest ratio of the codec (packing is done offline)
+    bool CompressArchiveData(ArchiveCodec codec, const uint8_t* data, size_t size, std::vector<uint8_t>& out);
+
+    /// @brief Decompresses a buffer whose original size is known
+    bool DecompressArchiveData(ArchiveCodec codec, const uint8_t* data, size_t size, uint8_t* destination, size_t originalSize);
+
+    /// @brief Picks the codec of a file from its type, among the ones every build decodes : LZ4 for binary data loaded often
+    /// (meshes, textures, shader binaries), zlib for text (shaders, levels, materials), nothing for formats that are already compressed.
+    /// Brotli is only used when asked for with ARCHIVE_FLAG_BROTLI
+    ArchiveCodec SelectArchiveCodec(std::string_view path, size_t size);
+
+    // LZ4 block format (no frame), compatible with LZ4_compress_default and LZ4_decompress_safe
+    namespace LZ4{
+        size_t CompressBound(size_t size);
+        size_t Compress(const uint8_t* source, size_t size, uint8_t* destination, size_t capacity);
+        bool Decompress(const uint8_t* source, size_t size, uint8_t* destination, size_t originalSize);
+    }
+}
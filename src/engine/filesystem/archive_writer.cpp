@@ -0,0 +1,421 @@
+#include "archive_writer.hpp"
+
+#include "engine/debugging/debugger.hpp"
+#include "engine/core/jobs/job_system.hpp"
+
+#include <fstream>
+#include <cstring>
+#include <algorithm>
+#include <chrono>
+#include <unordered_map>
+
+namespace Epoch::Engine::Filesystem{
+
+    namespace {
+        template<typename T>
+        void WriteValue(std::ostream& out, const T& value) {
+            out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+        }
+
+        template<typename T>
+        void AppendValue(std::vector<uint8_t>& out, const T& value) {
+            const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+            out.insert(out.end(), bytes, bytes + sizeof(T));
+        }
+
+        uint64_t AlignUp(uint64_t value, uint64_t alignment) {
+            return (value + alignment - 1) & ~(alignment - 1);
+        }
+
+        constexpr size_t COPY_PIECE_SIZE = 1024 * 1024;
+
+        // Hashes 8 bytes at a time, the result of a buffer hashed in pieces of a multiple of 8 bytes is the same as in one go.
+        // Only used to find candidate duplicates, they are compared before being shared
+        uint64_t HashContent(const uint8_t* data, size_t size, uint64_t hash = 14695981039346656037ull)
+        {
+            size_t i = 0;
+            for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+                uint64_t word;
+                std::memcpy(&word, data + i, sizeof(word));
+                hash = (hash ^ word) * 0x9E3779B97F4A7C15ull;
+                hash ^= hash >> 29;
+            }
+            for (; i < size; i++)
+                hash = (hash ^ data[i]) * 1099511628211ull;
+            return hash;
+        }
+
+        // Compresses each block on its own, see ARCHIVE_FLAG_CHUNKED. Blocks that don't shrink are stored
+        bool CompressChunked(ArchiveCodec codec, const std::vector<uint8_t>& data, uint32_t blockSize, std::vector<uint8_t>& out)
+        {
+            uint32_t blockCount = static_cast<uint32_t>((data.size() + blockSize - 1) / blockSize);
+
+            out.clear();
+            AppendValue(out, blockSize);
+            AppendValue(out, blockCount);
+            size_t tableOffset = out.size();
+            out.resize(tableOffset + blockCount * sizeof(uint32_t));
+
+            std::vector<uint8_t> compressed;
+            uint64_t blocksSize = 0;
+            for (uint32_t block = 0; block < blockCount; block++) {
+                const uint8_t* source = data.data() + size_t(block) * blockSize;
+                size_t size = std::min<size_t>(blockSize, data.size() - size_t(block) * blockSize);
+
+                bool stored = !CompressArchiveData(codec, source, size, compressed) || compressed.size() >= size;
+                if (stored)
+                    out.insert(out.end(), source, source + size);
+                else
+                    out.insert(out.end(), compressed.begin(), compressed.end());
+
+                blocksSize += stored ? size : compressed.size();
+                if (blocksSize >= ARCHIVE_BLOCK_STORED)
+                    return false;
+
+                uint32_t end = static_cast<uint32_t>(blocksSize) | (stored ? ARCHIVE_BLOCK_STORED : 0);
+                std::memcpy(out.data() + tableOffset + block * sizeof(uint32_t), &end, sizeof(end));
+            }
+            return true;
+        }
+    }
+
+    void ArchiveWriter::AddFile(const std::string &virtualPath, const Path &source, uint8_t flags)
+    {
+        files.push_back({ virtualPath, source, {}, flags });
+    }
+
+    void ArchiveWriter::AddFile(const std::string &virtualPath, std::vector<uint8_t> data, uint8_t flags)
+    {
+        files.push_back({ virtualPath, Path(), std::move(data), flags });
+    }
+
+    void ArchiveWriter::AddDirectory(const Path &directory, uint8_t flags)
+    {
+        std::vector<std::filesystem::path> found;
+        for (const auto& entry : std::filesystem::recursive_directory_iterator(directory.full, std::filesystem::directory_options::skip_permission_denied))
+            if (entry.is_regular_file())
+                found.push_back(entry.path());
+
+        // Iteration order depends on the filesystem, sorting keeps archives identical between machines
+        std::sort(found.begin(), found.end());
+
+        for (const std::filesystem::path& file : found)
+            AddFile(std::filesystem::relative(file, directory.full).generic_string(), Path(file.string()), flags);
+    }
+
+    void ArchiveWriter::SetVersion(uint8_t formatVersion)
+    {
+        if (formatVersion != 1 && formatVersion != 2) {
+            DEBUG_WARNING("Unsupported archive version " + std::to_string(formatVersion) + ", keeping " + std::to_string(version));
+            return;
+        }
+        version = formatVersion;
+    }
+
+    void ArchiveWriter::SetAlignment(uint32_t bytes)
+    {
+        if (bytes == 0 || (bytes & (bytes - 1)) != 0) {
+            DEBUG_WARNING("Archive alignment must be a power of two, keeping " + std::to_string(alignment));
+            return;
+        }
+        alignment = bytes;
+    }
+
+    /// @brief Reads and compresses a file, run on the job system. Stored files on disk are only measured, Write copies them
+    void ArchiveWriter::Pack(PendingFile &file, PackedFile &packed) const
+    {
+        bool onDisk = !file.source.full.empty();
+
+        uint64_t size = file.data.size();
+        if (onDisk) {
+            std::error_code error;
+            size = std::filesystem::file_size(file.source.full, error);
+            if (error) {
+                DEBUG_ERROR("Can't read file to pack : " + file.source.full);
+                return;
+            }
+        }
+
+        ArchiveCodec codec = file.flags == ARCHIVE_PACK_AUTO ? SelectArchiveCodec(file.path, static_cast<size_t>(size)) : GetArchiveCodec(file.flags);
+        if (file.flags != ARCHIVE_PACK_AUTO && file.flags != static_cast<uint8_t>(codec))
+            DEBUG_WARNING("Unsupported archive flags ignored for : " + file.path);
+        if (!IsArchiveCodecAvailable(codec))
+            codec = ArchiveCodec::Zlib;
+
+        // CosemUnPacker only decodes unchunked zlib
+        if (version == 1 && codec != ArchiveCodec::None && codec != ArchiveCodec::Zlib) {
+            if (file.flags != ARCHIVE_PACK_AUTO)
+                DEBUG_WARNING("Version 1 archives only hold zlib entries, compressing with it : " + file.path);
+            codec = ArchiveCodec::Zlib;
+        }
+
+        packed.originalSize = size;
+        if (onDisk && codec == ArchiveCodec::None) {
+            std::ifstream in(file.source.full, std::ios::binary);
+            std::vector<char> piece(COPY_PIECE_SIZE);
+            packed.hash = 14695981039346656037ull;
+            while (in) {
+                in.read(piece.data(), piece.size());
+                packed.hash = HashContent(reinterpret_cast<const uint8_t*>(piece.data()), static_cast<size_t>(in.gcount()), packed.hash);
+            }
+            packed.streamed = true;
+            packed.valid = true;
+            return;
+        }
+
+        std::vector<uint8_t> data;
+        if (onDisk) {
+            std::ifstream in(file.source.full, std::ios::binary);
+            data.resize(static_cast<size_t>(size));
+            in.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size()));
+            if (!in || static_cast<uint64_t>(in.gcount()) != size) {
+                DEBUG_ERROR("Can't read file to pack : " + file.source.full);
+                return;
+            }
+        }
+        else {
+            data = std::move(file.data);
+        }
+
+        // Stored as is when compression saves under 3%, decoding would cost more than reading the difference
+        std::vector<uint8_t> compressed;
+        bool chunked = version != 1 && codec != ArchiveCodec::None && chunkSize > 0 && data.size() > chunkSize;
+        if (codec != ArchiveCodec::None) {
+            bool compressedOk = chunked ? CompressChunked(codec, data, chunkSize, compressed) : CompressArchiveData(codec, data.data(), data.size(), compressed);
+            if (!compressedOk || compressed.size() > data.size() - data.size() / 32)
+                codec = ArchiveCodec::None;
+        }
+
+        packed.flags = static_cast<uint8_t>(codec);
+        if (codec != ArchiveCodec::None && chunked)
+            packed.flags |= ARCHIVE_FLAG_CHUNKED;
+        packed.payload = codec != ArchiveCodec::None ? std::move(compressed) : std::move(data);
+        packed.hash = HashContent(packed.payload.data(), packed.payload.size());
+        packed.valid = true;
+    }
+
+    /// @brief Writes every added file. Files are packed in parallel on the job system, a bounded number ahead of the one
+    /// being written, and written in the order they were added so the archive does not depend on the scheduling
+    /// @param archivePath The .caf file to create, overwritten if it exists
+    /// @return False if a file can't be read, or a v1 archive exceeds the 4 GB it can address
+    bool ArchiveWriter::Write(const std::string &archivePath)
+    {
+        auto startTime = std::chrono::steady_clock::now();
+
+        // Read back to compare duplicate candidates
+        std::fstream out(archivePath, std::ios::binary | std::ios::in | std::ios::out | std::ios::trunc);
+        if (!out) {
+            DEBUG_ERROR("Can't create archive : " + archivePath);
+            return false;
+        }
+
+        uint32_t payloadAlignment = version == 1 ? 1 : alignment;
+        size_t sizeWidth = version == 1 ? sizeof(uint32_t) : sizeof(uint64_t);
+
+        uint64_t indexSize = 0;
+        for (const PendingFile& file : files) {
+            if (file.path.size() > UINT16_MAX) {
+                DEBUG_ERROR("Archive path too long : " + file.path);
+                return false;
+            }
+            indexSize += sizeof(uint16_t) + file.path.size() + 3 * sizeWidth + sizeof(uint8_t);
+        }
+
+        uint64_t dataOffset = AlignUp((version == 1 ? ARCHIVE_HEADER_SIZE : ARCHIVE_HEADER_SIZE_V2) + indexSize, payloadAlignment);
+        std::vector<char> reserved(static_cast<size_t>(dataOffset), 0);
+        out.write(reserved.data(), reserved.size());
+
+        struct WrittenFile {
+            uint64_t offset;
+            uint64_t storedSize;
+            uint64_t originalSize;
+            uint8_t flags;
+        };
+        std::vector<WrittenFile> written(files.size());
+        uint64_t position = dataOffset;
+        uint64_t codecBytes[ARCHIVE_CODEC_MASK + 1] = {};      // Original bytes per codec, indexed by flag
+        uint64_t totalOriginal = 0;
+
+        Core::Jobs::JobSystem& jobSystem = Core::Jobs::JobSystem::GetInstance();
+        size_t window = jobs > 0 ? jobs : jobSystem.GetWorkerCount() + 1;
+
+        std::vector<PackedFile> packed(files.size());
+        std::vector<Core::Jobs::JobHandle> handles;
+        handles.reserve(files.size());
+
+        // Jobs reference the files and their results, they have to finish before leaving
+        auto fail = [&]() {
+            jobSystem.WaitAll(handles);
+            return false;
+        };
+
+        std::vector<char> copyBuffer(COPY_PIECE_SIZE), archiveBuffer(COPY_PIECE_SIZE);
+        std::vector<char> padding(payloadAlignment, 0);
+        std::unordered_map<uint64_t, size_t> payloads;     // Payload hash -> first file written with it
+        size_t duplicates = 0;
+        uint64_t savedBytes = 0;
+
+        // Compares a payload with one already in the archive, then puts the write position back at the end
+        auto isWritten = [&](const PendingFile& file, const PackedFile& result, const WrittenFile& earlier) {
+            std::ifstream source;
+            if (result.streamed)
+                source.open(file.source.full, std::ios::binary);
+
+            bool same = true;
+            for (uint64_t offset = 0; same && offset < earlier.storedSize; offset += COPY_PIECE_SIZE) {
+                size_t size = static_cast<size_t>(std::min<uint64_t>(COPY_PIECE_SIZE, earlier.storedSize - offset));
+                out.seekg(static_cast<std::streamoff>(earlier.offset + offset));
+                out.read(archiveBuffer.data(), size);
+
+                const char* current = reinterpret_cast<const char*>(result.payload.data()) + offset;
+                if (result.streamed) {
+                    source.read(copyBuffer.data(), size);
+                    current = copyBuffer.data();
+                    same = static_cast<size_t>(source.gcount()) == size;
+                }
+                same = same && out && std::memcmp(archiveBuffer.data(), current, size) == 0;
+            }
+
+            out.clear();
+            out.seekp(static_cast<std::streamoff>(position));
+            return same;
+        };
+
+        for (size_t i = 0; i < files.size(); i++) {
+            while (handles.size() < files.size() && handles.size() < i + window) {
+                size_t next = handles.size();
+                handles.push_back(jobSystem.Schedule([this, &packed, next]() { Pack(files[next], packed[next]); }));
+            }
+            jobSystem.Wait(handles[i]);
+
+            const PendingFile& file = files[i];
+            PackedFile& result = packed[i];
+            if (!result.valid)
+                return fail();
+
+            uint64_t storedSize = result.streamed ? result.originalSize : result.payload.size();
+
+            auto [found, inserted] = payloads.try_emplace(result.hash, i);
+            if (!inserted) {
+                const WrittenFile& earlier = written[found->second];
+                if (earlier.storedSize == storedSize && earlier.originalSize == result.originalSize && earlier.flags == result.flags
+                    && isWritten(file, result, earlier)) {
+                    written[i] = earlier;
+                    codecBytes[result.flags & ARCHIVE_CODEC_MASK] += result.originalSize;
+                    totalOriginal += result.originalSize;
+                    duplicates++;
+                    savedBytes += storedSize;
+                    std::vector<uint8_t>().swap(result.payload);
+
+                    if (verbose)
+                        DEBUG_LOG("Packed " + file.path + " (" + std::to_string(result.originalSize) + " bytes, same as " + files[found->second].path + ")");
+                    continue;
+                }
+            }
+
+            uint64_t alignedPosition = AlignUp(position, payloadAlignment);
+            out.write(padding.data(), static_cast<std::streamsize>(alignedPosition - position));
+            position = alignedPosition;
+
+            if (result.streamed) {
+                // Copied in pieces, stored files can be large
+                std::ifstream in(file.source.full, std::ios::binary);
+                storedSize = 0;
+                while (in) {
+                    in.read(copyBuffer.data(), copyBuffer.size());
+                    out.write(copyBuffer.data(), in.gcount());
+                    storedSize += static_cast<uint64_t>(in.gcount());
+                }
+                if (storedSize != result.originalSize) {
+                    DEBUG_ERROR("File changed while packing : " + file.source.full);
+                    return fail();
+                }
+            }
+            else {
+                out.write(reinterpret_cast<const char*>(result.payload.data()), result.payload.size());
+            }
+
+            written[i] = { position, storedSize, result.originalSize, result.flags };
+            position += storedSize;
+            codecBytes[result.flags & ARCHIVE_CODEC_MASK] += result.originalSize;
+            totalOriginal += result.originalSize;
+            std::vector<uint8_t>().swap(result.payload);
+
+            if (version == 1 && position > UINT32_MAX) {
+                DEBUG_ERROR("Archive exceeds 4 GB, use the v2 format : " + archivePath);
+                return fail();
+            }
+
+            if (verbose)
+                DEBUG_LOG("Packed " + file.path + " (" + std::to_string(result.originalSize) + " -> " + std::to_string(storedSize) + " bytes)");
+        }
+
+        // Lookup tables, 8 bytes aligned so the reader can use them in place
+        std::vector<std::string_view> paths;
+        std::vector<uint64_t> sizes;
+        for (size_t i = 0; i < files.size(); i++) {
+            paths.push_back(files[i].path);
+            sizes.push_back(written[i].originalSize);
+        }
+        std::vector<uint8_t> lookup = Archive::BuildLookup(paths, sizes);
+
+        uint64_t lookupOffset = AlignUp(position, 8);
+        const char zeros[8] = {};
+        out.write(zeros, static_cast<std::streamsize>(lookupOffset - position));
+        out.write(reinterpret_cast<const char*>(lookup.data()), lookup.size());
+
+        WriteValue(out, lookupOffset);
+        WriteValue(out, static_cast<uint32_t>(lookup.size()));
+        out.write("CAFX", 4);
+
+        // Header and index, now that every payload is placed
+        out.seekp(0);
+        out.write("COSEM", 5);
+        WriteValue(out, version);
+        WriteValue(out, static_cast<uint32_t>(files.size()));
+        if (version == 1) {
+            WriteValue(out, static_cast<uint32_t>(ARCHIVE_HEADER_SIZE));
+            WriteValue(out, static_cast<uint32_t>(dataOffset));
+        }
+        else {
+            WriteValue(out, static_cast<uint64_t>(ARCHIVE_HEADER_SIZE_V2));
+            WriteValue(out, dataOffset);
+            WriteValue(out, payloadAlignment);
+        }
+
+        for (size_t i = 0; i < files.size(); i++) {
+            WriteValue(out, static_cast<uint16_t>(files[i].path.size()));
+            out.write(files[i].path.data(), files[i].path.size());
+            if (version == 1) {
+                WriteValue(out, static_cast<uint32_t>(written[i].offset));
+                WriteValue(out, static_cast<uint32_t>(written[i].storedSize));
+                WriteValue(out, static_cast<uint32_t>(written[i].originalSize));
+            }
+            else {
+                WriteValue(out, written[i].offset);
+                WriteValue(out, written[i].storedSize);
+                WriteValue(out, written[i].originalSize);
+            }
+            WriteValue(out, written[i].flags);
+        }
+
+        if (!out) {
+            DEBUG_ERROR("Failed to write archive : " + archivePath);
+            return false;
+        }
+
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime);
+        uint64_t archiveSize = lookupOffset + lookup.size() + ARCHIVE_FOOTER_SIZE;
+        uint64_t throughput = totalOriginal * 1000 / (1024 * 1024) / std::max<uint64_t>(elapsed.count(), 1);
+
+        DEBUG_LOG("Packed " + std::to_string(files.size()) + " files into " + archivePath + " (" + std::to_string(totalOriginal) + " -> "
+            + std::to_string(archiveSize) + " bytes) in " + std::to_string(elapsed.count()) + " ms, " + std::to_string(throughput)
+            + " MB/s with " + std::to_string(window) + " jobs");
+        if (duplicates > 0)
+            DEBUG_LOG(std::to_string(duplicates) + " duplicate files stored once, " + std::to_string(savedBytes) + " bytes saved");
+        if (verbose)
+            DEBUG_LOG("Original bytes per codec : stored " + std::to_string(codecBytes[0]) + ", zlib " + std::to_string(codecBytes[ARCHIVE_FLAG_COMPRESSED])
+                + ", lz4 " + std::to_string(codecBytes[ARCHIVE_FLAG_LZ4]) + ", brotli " + std::to_string(codecBytes[ARCHIVE_FLAG_BROTLI]));
+        return true;
+    }
+}
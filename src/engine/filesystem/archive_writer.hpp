@@ -0,0 +1,74 @@
+#pragma once
+
+#include "archive.hpp"
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace Epoch::Engine::Filesystem{
+
+    // Writer only : the codec of the file is picked by SelectArchiveCodec
+    constexpr uint8_t ARCHIVE_PACK_AUTO = 0x80;
+
+    // Payload alignments of v2 archives. Cache lines suit SIMD decoders, pages let uploads use the mapping directly
+    constexpr uint32_t ARCHIVE_ALIGN_CACHE_LINE = 64;
+    constexpr uint32_t ARCHIVE_ALIGN_PAGE = 4096;
+
+    // Writes .caf archives followed by the lookup tables used by Archive. Identical payloads are written once, their index entries share the offset
+    class ArchiveWriter {
+        public:
+            /// @brief Adds a file read from disk when the archive is written
+            /// @param flags A single codec flag, 0 to store the file, or ARCHIVE_PACK_AUTO
+            void AddFile(const std::string& virtualPath, const Path& source, uint8_t flags = ARCHIVE_PACK_AUTO);
+            void AddFile(const std::string& virtualPath, std::vector<uint8_t> data, uint8_t flags = ARCHIVE_PACK_AUTO);
+
+            /// @brief Adds every file below a directory, named relative to it with '/' separators
+            void AddDirectory(const Path& directory, uint8_t flags = ARCHIVE_PACK_AUTO);
+
+            bool Write(const std::string& archivePath);
+
+            void SetVerbose(bool activate) { verbose = activate; }
+
+            /// @brief Version 2 by default, 1 for archives read by CosemUnPacker (4 GB at most, unaligned payloads,
+            /// every compressed file in a single zlib stream whatever its flags and the chunk size)
+            void SetVersion(uint8_t formatVersion);
+
+            /// @brief Alignment of the payloads in v2 archives, a power of two
+            void SetAlignment(uint32_t bytes);
+
+            /// @brief Number of files read and compressed at once on the job system, 0 for one per worker.
+            /// Bounds the memory used by the payloads waiting to be written
+            void SetJobs(unsigned int count) { jobs = count; }
+
+            /// @brief Compressed files larger than this are split in blocks decompressed independently, 0 to never split
+            void SetChunkSize(uint32_t size) { chunkSize = size; }
+
+        private:
+            struct PendingFile {
+                std::string path;
+                Path source;                // Empty for files added from memory
+                std::vector<uint8_t> data;
+                uint8_t flags = 0;
+            };
+
+            // Result of a packing job, written and released in the order of the files
+            struct PackedFile {
+                std::vector<uint8_t> payload;
+                uint64_t originalSize = 0;
+                uint8_t flags = 0;
+                uint64_t hash = 0;          // Of the payload, to find the duplicates
+                bool streamed = false;      // Stored file copied from disk by the writing thread, payload is empty
+                bool valid = false;
+            };
+
+            void Pack(PendingFile& file, PackedFile& packed) const;
+
+            std::vector<PendingFile> files;
+            bool verbose = false;
+            uint8_t version = ARCHIVE_VERSION;
+            uint32_t alignment = ARCHIVE_ALIGN_CACHE_LINE;
+            unsigned int jobs = 0;
+            uint32_t chunkSize = 64 * 1024;     // Small enough for a streamed read to decode little more than it needs
+    };
+}
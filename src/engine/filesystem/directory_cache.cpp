@@ -0,0 +1,242 @@
+#include "directory_cache.hpp"
+
+#include "engine/debugging/debugger.hpp"
+
+#include <algorithm>
+
+namespace Epoch::Engine::Filesystem{
+
+    namespace {
+        bool IsSeparator(char c) {
+            return c == '/' || c == std::filesystem::path::preferred_separator;
+        }
+
+        // Lexical, both paths are absolute and normalized
+        bool IsInside(const std::string& directory, const std::string& path) {
+            if (path.compare(0, directory.size(), directory) != 0)
+                return false;
+            return path.size() == directory.size() || IsSeparator(directory.back()) || IsSeparator(path[directory.size()]);
+        }
+    }
+
+    /// @brief Invalidates the trees containing the paths the watcher reported
+    void DirectoryCache::PollWatcher()
+    {
+        for (const Path& changed : watcher->Poll()) {
+            std::string absolutePath = changed.GetAbsolutePath();
+            for (std::unique_ptr<Tree>& tree : trees)
+                if (IsInside(tree->absoluteRoot, absolutePath))
+                    tree->valid = false;
+        }
+        MarkUnwatched();
+    }
+
+    /// @brief Falls back to timed rescans for the trees containing a directory the watcher could not watch
+    void DirectoryCache::MarkUnwatched()
+    {
+        for (const std::string& directory : watcher->TakeUnwatched())
+            for (std::unique_ptr<Tree>& tree : trees)
+                if (IsInside(tree->absoluteRoot, directory))
+                    tree->watched = false;
+    }
+
+    /// @return The tree containing a path, up to date, nullptr if no cached directory contains it
+    DirectoryCache::Tree* DirectoryCache::FindTree(const std::string &absolutePath)
+    {
+        PollWatcher();
+
+        for (std::unique_ptr<Tree>& tree : trees) {
+            if (!IsInside(tree->absoluteRoot, absolutePath))
+                continue;
+            return Refresh(*tree) ? tree.get() : nullptr;
+        }
+        return nullptr;
+    }
+
+    /// @brief Walks a tree again if the watcher reported a change below it, or if it is not watched and its last walk is old
+    /// @return False if its root is gone, the tree is then dropped
+    bool DirectoryCache::Refresh(Tree &tree)
+    {
+        if (!tree.watched && std::chrono::steady_clock::now() - tree.buildTime >= RESCAN_INTERVAL)
+            tree.valid = false;
+
+        if (tree.valid || Build(tree))
+            return true;
+
+        trees.erase(std::remove_if(trees.begin(), trees.end(), [&tree](const std::unique_ptr<Tree>& other) { return other.get() == &tree; }), trees.end());
+        return false;
+    }
+
+    /// @brief Walks a directory, one stat per entry for its size and write time
+    bool DirectoryCache::Build(Tree &tree)
+    {
+        tree.nodes.clear();
+        tree.indices.clear();
+
+        std::error_code error;
+        if (!std::filesystem::is_directory(tree.root.full, error))
+            return false;
+
+        Node root;
+        root.path = tree.root;
+        root.name = tree.root.GetFilename(false);
+        root.type = tree.root.GetExtensionType();
+        root.isDirectory = true;
+        root.writeTime = std::filesystem::last_write_time(tree.root.full, error);
+        tree.nodes.push_back(root);
+
+        std::vector<std::filesystem::directory_entry> entries;
+        for (uint32_t i = 0; i < tree.nodes.size(); i++) {
+            if (!tree.nodes[i].isDirectory || tree.nodes[i].isSymlink)
+                continue;
+
+            entries.clear();
+            for (auto it = std::filesystem::directory_iterator(tree.nodes[i].path.full, std::filesystem::directory_options::skip_permission_denied, error);
+                 !error && it != std::filesystem::directory_iterator(); it.increment(error))
+                entries.push_back(*it);
+            error.clear();
+
+            // Iteration order depends on the filesystem
+            std::sort(entries.begin(), entries.end(), [](const auto& a, const auto& b) { return a.path().filename() < b.path().filename(); });
+
+            uint32_t firstChild = static_cast<uint32_t>(tree.nodes.size());
+            for (const std::filesystem::directory_entry& entry : entries) {
+                bool isDirectory = entry.is_directory(error);
+                bool isFile = !isDirectory && entry.is_regular_file(error);
+                if (!isDirectory && !isFile)
+                    continue;
+
+                Node child;
+                child.path = Path(entry.path().string());
+                child.name = child.path.GetFilename(false);
+                child.type = child.path.GetExtensionType();
+                child.isDirectory = isDirectory;
+                child.isSymlink = isDirectory && entry.is_symlink(error);
+                child.size = isFile ? entry.file_size(error) : 0;
+                child.writeTime = entry.last_write_time(error);
+                child.parent = i;
+                tree.nodes.push_back(std::move(child));
+            }
+
+            tree.nodes[i].firstChild = firstChild;
+            tree.nodes[i].childCount = static_cast<uint32_t>(tree.nodes.size()) - firstChild;
+        }
+
+        // Children come after their parent, so sizes add up in reverse
+        for (size_t i = tree.nodes.size(); i-- > 1;)
+            tree.nodes[tree.nodes[i].parent].size += tree.nodes[i].size;
+
+        tree.indices.reserve(tree.nodes.size());
+        for (uint32_t i = 0; i < tree.nodes.size(); i++)
+            tree.indices.emplace(tree.nodes[i].path.GetAbsolutePath(), i);
+
+        tree.buildTime = std::chrono::steady_clock::now();
+        tree.valid = true;
+        return true;
+    }
+
+    FileInfo DirectoryCache::ToFileInfo(const Node &node)
+    {
+        FileInfo infos;
+        infos.path = node.path;
+        infos.name = node.name;
+        infos.type = node.type;
+        infos.isDirectory = node.isDirectory;
+        infos.size = static_cast<int>(node.size);
+        infos.writeTime = node.writeTime;
+        return infos;
+    }
+
+    /// @brief Lists the entries of a directory in the order of a recursive_directory_iterator, a directory before its contents
+    bool DirectoryCache::ListDirectory(const Path &directory, const std::vector<Type> &acceptedExtensions, bool includeDirs, bool recursive, std::vector<FileInfo> &out)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        std::string absolutePath = directory.GetAbsolutePath();
+        Tree* tree = FindTree(absolutePath);
+
+        if (!tree) {
+            auto created = std::make_unique<Tree>();
+            created->root = directory;
+            created->absoluteRoot = absolutePath;
+
+            // Watched before the walk, a change during it invalidates the result. The failures are taken here so they don't
+            // mark the trees below, which stay watched until replaced
+            created->watched = watcher->Watch(directory);
+            watcher->TakeUnwatched();
+            if (!created->watched)
+                DEBUG_WARNING("Directory not fully watched, it will be walked again on a timer : " + absolutePath);
+            if (!Build(*created))
+                return false;
+
+            // The trees below this directory are part of it now
+            trees.erase(std::remove_if(trees.begin(), trees.end(), [&absolutePath](const std::unique_ptr<Tree>& other) { return IsInside(absolutePath, other->absoluteRoot); }), trees.end());
+            trees.push_back(std::move(created));
+            tree = trees.back().get();
+        }
+
+        auto found = tree->indices.find(absolutePath);
+        if (found == tree->indices.end() || !tree->nodes[found->second].isDirectory)
+            return false;
+
+        std::vector<uint32_t> stack;
+        auto pushChildren = [&stack, tree](uint32_t index) {
+            const Node& node = tree->nodes[index];
+            for (uint32_t i = node.childCount; i-- > 0;)
+                stack.push_back(node.firstChild + i);
+        };
+
+        pushChildren(found->second);
+        while (!stack.empty()) {
+            uint32_t index = stack.back();
+            stack.pop_back();
+            const Node& node = tree->nodes[index];
+
+            if (node.isDirectory) {
+                if (includeDirs)
+                    out.push_back(ToFileInfo(node));
+                if (recursive && !node.isSymlink)
+                    pushChildren(index);
+            }
+            else if (acceptedExtensions.empty() || std::find(acceptedExtensions.begin(), acceptedExtensions.end(), node.type) != acceptedExtensions.end()) {
+                out.push_back(ToFileInfo(node));
+            }
+        }
+        return true;
+    }
+
+    bool DirectoryCache::GetFileInfos(const Path &path, FileInfo &out)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        std::string absolutePath = path.GetAbsolutePath();
+        Tree* tree = FindTree(absolutePath);
+        if (!tree)
+            return false;
+
+        auto found = tree->indices.find(absolutePath);
+        if (found == tree->indices.end())
+            return false;
+
+        out = ToFileInfo(tree->nodes[found->second]);
+        out.path = path;
+        return true;
+    }
+
+    void DirectoryCache::Invalidate(const Path &path)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        std::string absolutePath = path.GetAbsolutePath();
+        for (std::unique_ptr<Tree>& tree : trees)
+            if (IsInside(tree->absoluteRoot, absolutePath))
+                tree->valid = false;
+    }
+
+    void DirectoryCache::Clear()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        trees.clear();
+        watcher = std::make_unique<FileWatcher>(true);
+    }
+}
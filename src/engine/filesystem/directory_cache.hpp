@@ -0,0 +1,80 @@
+#pragma once
+
+#include "filesystem.hpp"
+#include "file_watcher.hpp"
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <chrono>
+#include <cstdint>
+
+namespace Epoch::Engine::Filesystem{
+
+    // Metadata of the directories listed on disk, walked once and kept until something below them changes.
+    // One FileWatcher covers every cached directory, polled without blocking when the cache is queried. Directories it
+    // could not fully watch are walked again at most every RESCAN_INTERVAL instead
+    class DirectoryCache {
+        public:
+            static DirectoryCache& GetInstance() {
+                static DirectoryCache instance;
+                return instance;
+            }
+
+            /// @brief Lists a directory from the cache, walking it first if no cached directory contains it
+            /// @return False if the path is not a directory
+            bool ListDirectory(const Path& directory, const std::vector<Type>& acceptedExtensions, bool includeDirs, bool recursive, std::vector<FileInfo>& out);
+
+            /// @brief Metadata of a path below a cached directory, without touching the filesystem
+            /// @return False if no cached directory contains the path or it does not exist
+            bool GetFileInfos(const Path& path, FileInfo& out);
+
+            /// @brief Walks the directory containing a path again on its next query
+            void Invalidate(const Path& path);
+            void Clear();
+
+        private:
+            DirectoryCache() : watcher(std::make_unique<FileWatcher>(true)) {}
+            ~DirectoryCache() = default;
+            DirectoryCache(const DirectoryCache&) = delete;
+            DirectoryCache& operator=(const DirectoryCache&) = delete;
+
+            struct Node {
+                Path path;
+                std::string name;               // Without extension, as in FileInfo
+                Type type = Type::T_TEXT;
+                bool isDirectory = false;
+                bool isSymlink = false;         // Symlinked directories are listed but not walked
+                uint64_t size = 0;              // Sum of the files below for directories
+                std::filesystem::file_time_type writeTime;
+                uint32_t parent = UINT32_MAX;
+                uint32_t firstChild = 0;
+                uint32_t childCount = 0;
+            };
+
+            struct Tree {
+                Path root;
+                std::string absoluteRoot;
+                std::vector<Node> nodes;        // Breadth first, the children of a directory are contiguous and sorted by name
+                std::unordered_map<std::string, uint32_t> indices;     // Absolute path -> node
+                std::chrono::steady_clock::time_point buildTime;
+                bool watched = true;            // False if some directory below could not be watched
+                bool valid = false;
+            };
+
+            static constexpr std::chrono::milliseconds RESCAN_INTERVAL{500};
+
+            void PollWatcher();
+            void MarkUnwatched();
+            Tree* FindTree(const std::string& absolutePath);
+            bool Refresh(Tree& tree);
+            static bool Build(Tree& tree);
+            static FileInfo ToFileInfo(const Node& node);
+
+            std::vector<std::unique_ptr<Tree>> trees;
+            std::unique_ptr<FileWatcher> watcher;
+            std::mutex mutex;
+    };
+}
@@ -0,0 +1,239 @@
+#include "file_watcher.hpp"
+
+#include "engine/debugging/debugger.hpp"
+
+#include <unordered_set>
+#include <algorithm>
+
+#if defined(__linux__)
+    #include <sys/inotify.h>
+    #include <unistd.h>
+    #include <fcntl.h>
+    #include <cerrno>
+#endif
+
+namespace Epoch::Engine::Filesystem{
+
+    /// @brief Adds a root, dropping the roots below it, their directories are walked with it
+    void FileWatcher::AddRoot(const std::string &directory)
+    {
+        roots.erase(std::remove_if(roots.begin(), roots.end(), [&directory](const std::string& root) {
+            return root.compare(0, directory.size(), directory) == 0
+                && (root.size() == directory.size() || root[directory.size()] == '/' || root[directory.size()] == std::filesystem::path::preferred_separator);
+        }), roots.end());
+        roots.push_back(directory);
+    }
+
+    std::vector<std::string> FileWatcher::TakeUnwatched()
+    {
+        std::vector<std::string> taken;
+        taken.swap(unwatched);
+        return taken;
+    }
+
+#if defined(__linux__)
+
+    // Atomic saves write a temporary file then rename it, IN_MOVED_TO catches those
+    constexpr uint32_t FILE_EVENTS = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE;
+    constexpr uint32_t REMOVAL_EVENTS = IN_DELETE | IN_MOVED_FROM | IN_ATTRIB | IN_DELETE_SELF | IN_MOVE_SELF;
+
+    FileWatcher::FileWatcher(bool reportRemovals) : reportRemovals(reportRemovals)
+    {
+        inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (inotifyFd < 0)
+            DEBUG_ERROR("Can't create the inotify instance (errno " + std::to_string(errno) + ")");
+    }
+
+    FileWatcher::~FileWatcher()
+    {
+        if (inotifyFd >= 0)
+            close(inotifyFd);
+    }
+
+    bool FileWatcher::Watch(const Path &directory)
+    {
+        if (inotifyFd < 0 || directory.IsPacked() || !directory.IsDirectory())
+            return false;
+
+        std::string root = directory.GetAbsolutePath();
+        AddRoot(root);
+
+        size_t failed = unwatched.size();
+        AddTree(root, nullptr);
+        return unwatched.size() == failed;
+    }
+
+    /// @brief Watches a directory and every directory below it
+    /// @param found Receives what is already inside (files, and directories when removals are reported), nullptr to skip it
+    void FileWatcher::AddTree(const std::string &directory, std::vector<std::string>* found)
+    {
+        AddDirectory(directory);
+
+        std::error_code error;
+        for (auto it = std::filesystem::recursive_directory_iterator(directory, error); !error && it != std::filesystem::recursive_directory_iterator(); it.increment(error)) {
+            bool isDirectory = it->is_directory();
+            if (isDirectory)
+                AddDirectory(it->path().string());
+            if (found && (it->is_regular_file() || (reportRemovals && isDirectory)))
+                found->push_back(it->path().string());
+        }
+    }
+
+    void FileWatcher::AddDirectory(const std::string &directory)
+    {
+        int wd = inotify_add_watch(inotifyFd, directory.c_str(), reportRemovals ? FILE_EVENTS | REMOVAL_EVENTS : FILE_EVENTS);
+        if (wd < 0) {
+            DEBUG_WARNING("Can't watch directory (errno " + std::to_string(errno) + ") : " + directory);
+            unwatched.push_back(directory);
+            return;
+        }
+        directories[wd] = directory;
+    }
+
+    std::vector<Path> FileWatcher::Poll()
+    {
+        std::vector<Path> changed;
+        if (inotifyFd < 0)
+            return changed;
+
+        std::unordered_set<std::string> seen;
+        alignas(inotify_event) char buffer[4096];
+
+        while (true) {
+            ssize_t length = read(inotifyFd, buffer, sizeof(buffer));
+            if (length <= 0)
+                break;
+
+            for (ssize_t offset = 0; offset < length;) {
+                const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+                offset += sizeof(inotify_event) + event->len;
+
+                // Events were dropped, report the roots so caches rebuild and watch the directories created meanwhile
+                if (event->mask & IN_Q_OVERFLOW) {
+                    DEBUG_WARNING("File watcher event queue overflowed, some changes were lost");
+                    for (const std::string& root : roots) {
+                        AddTree(root, nullptr);
+                        if (seen.insert(root).second)
+                            changed.push_back(Path(root));
+                    }
+                    continue;
+                }
+
+                auto directory = directories.find(event->wd);
+                if (directory == directories.end())
+                    continue;
+
+                // Event on the watched directory itself, IN_IGNORED once its watch is gone
+                if (event->len == 0) {
+                    std::string path = directory->second;
+                    if (event->mask & IN_IGNORED)
+                        directories.erase(directory);
+                    if (reportRemovals && (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED)) && seen.insert(path).second)
+                        changed.push_back(Path(path));
+                    continue;
+                }
+
+                std::string path = (std::filesystem::path(directory->second) / event->name).string();
+
+                // New subdirectories are watched too, with everything below them. What they already hold (a moved in tree,
+                // "mkdir -p") was written before the watch existed and is reported now, later files once written
+                if (event->mask & IN_ISDIR) {
+                    if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+                        std::vector<std::string> found;
+                        AddTree(path, &found);
+                        for (const std::string& file : found)
+                            if (seen.insert(file).second)
+                                changed.push_back(Path(file));
+                    }
+                    if (!reportRemovals)
+                        continue;
+                }
+
+                // Created files are reported by the IN_CLOSE_WRITE that follows
+                else if (event->mask & IN_CREATE)
+                    continue;
+
+                if (seen.insert(path).second)
+                    changed.push_back(Path(path));
+            }
+        }
+
+        return changed;
+    }
+
+#else
+
+    // Modification times are compared at most this often
+    constexpr std::chrono::milliseconds SCAN_INTERVAL(500);
+
+    FileWatcher::FileWatcher(bool reportRemovals) : reportRemovals(reportRemovals) {}
+    FileWatcher::~FileWatcher() = default;
+
+    bool FileWatcher::Watch(const Path &directory)
+    {
+        if (directory.IsPacked() || !directory.IsDirectory())
+            return false;
+
+        std::string root = directory.GetAbsolutePath();
+        AddRoot(root);
+        AddDirectory(root);
+        return true;
+    }
+
+    void FileWatcher::AddDirectory(const std::string &directory)
+    {
+        std::error_code error;
+        for (auto it = std::filesystem::recursive_directory_iterator(directory, error); !error && it != std::filesystem::recursive_directory_iterator(); it.increment(error)) {
+            if (it->is_regular_file() || (reportRemovals && it->is_directory()))
+                writeTimes[it->path().string()] = it->last_write_time(error);
+        }
+    }
+
+    std::vector<Path> FileWatcher::Poll()
+    {
+        std::vector<Path> changed;
+
+        auto now = std::chrono::steady_clock::now();
+        if (now - lastScan < SCAN_INTERVAL)
+            return changed;
+        lastScan = now;
+
+        std::unordered_set<std::string> seen;
+
+        for (const std::string& root : roots) {
+            std::error_code error;
+            for (auto it = std::filesystem::recursive_directory_iterator(root, error); !error && it != std::filesystem::recursive_directory_iterator(); it.increment(error)) {
+                // Directory times change when an entry is added or removed
+                if (!it->is_regular_file() && !(reportRemovals && it->is_directory()))
+                    continue;
+
+                std::string path = it->path().string();
+                if (reportRemovals)
+                    seen.insert(path);
+                auto writeTime = it->last_write_time(error);
+
+                auto known = writeTimes.find(path);
+                if (known == writeTimes.end() || known->second != writeTime) {
+                    writeTimes[path] = writeTime;
+                    changed.push_back(Path(path));
+                }
+            }
+        }
+
+        if (reportRemovals) {
+            for (auto it = writeTimes.begin(); it != writeTimes.end();) {
+                if (seen.count(it->first) == 0) {
+                    changed.push_back(Path(it->first));
+                    it = writeTimes.erase(it);
+                }
+                else {
+                    ++it;
+                }
+            }
+        }
+
+        return changed;
+    }
+
+#endif
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "filesystem.hpp"
+
+#include <unordered_map>
+#include <vector>
+#include <string>
+
+namespace Epoch::Engine::Filesystem{
+
+    // Reports the files written, created or moved in a set of directories (inotify on Linux, modification times elsewhere)
+    class FileWatcher {
+        public:
+            /// @param reportRemovals Also report removed files and created or removed directories, for callers caching the tree
+            /// rather than reloading file contents
+            explicit FileWatcher(bool reportRemovals = false);
+            ~FileWatcher();
+
+            FileWatcher(const FileWatcher&) = delete;
+            FileWatcher& operator=(const FileWatcher&) = delete;
+
+            /// @brief Watches a directory and its subdirectories
+            /// @return False if some of them could not be watched, their changes are then missed
+            bool Watch(const Path& directory);
+
+            /// @brief Returns the files changed since the last call, once each, without blocking
+            std::vector<Path> Poll();
+
+            /// @brief Returns the directories that could not be watched since the last call (the ones created after Watch)
+            std::vector<std::string> TakeUnwatched();
+
+        private:
+            void AddRoot(const std::string& directory);
+            void AddDirectory(const std::string& directory);
+
+            bool reportRemovals = false;
+            std::vector<std::string> roots;
+            std::vector<std::string> unwatched;
+
+#if defined(__linux__)
+            void AddTree(const std::string& directory, std::vector<std::string>* found);
+
+            int inotifyFd = -1;
+            std::unordered_map<int, std::string> directories;      // Watch descriptor -> directory
+#else
+            std::unordered_map<std::string, std::filesystem::file_time_type> writeTimes;
+            std::chrono::steady_clock::time_point lastScan;
+#endif
+    };
+}
@@ -1,11 +1,136 @@
 #include "filesystem.hpp"
 
-#include "packer/unpacker.hpp"
+#include "archive.hpp"
+#include "directory_cache.hpp"
 
 #include "engine/debugging/debugger.hpp"
 
+#include <shared_mutex>
+
 namespace Epoch::Engine::Filesystem{
 
+    // Never freed nor modified once interned, so Paths can keep a pointer to it from any thread
+    struct PathRecord {
+        std::string full;
+        std::string absolute;           // Resolved against the working directory, lexically
+        std::string parent;
+        std::string filename;
+        std::string stem;
+        std::string extension;          // Lowercase, with the dot
+        Type type = Type::T_TEXT;
+        bool packed = false;
+        std::string parentArchive;      // Up to ".caf" for packed paths
+        std::string insideArchive;      // '/' separated
+    };
+
+    namespace {
+        struct PathTable {
+            std::unordered_map<std::string, PathRecord> records;             // By normalized path, nodes don't move
+            std::unordered_map<std::string, const PathRecord*> spellings;    // Raw strings already normalized
+            std::shared_mutex mutex;
+        };
+
+        PathTable& GetPathTable() {
+            static PathTable table;
+            return table;
+        }
+
+        // Queried once, the engine doesn't change its working directory
+        const std::filesystem::path& GetWorkingDirectory() {
+            static const std::filesystem::path directory = []() {
+                std::error_code error;
+                std::filesystem::path current = std::filesystem::current_path(error);
+                return error ? std::filesystem::path() : current;
+            }();
+            return directory;
+        }
+
+        Type GetTypeOfExtension(std::string extension) {
+            static const std::unordered_map<std::string, Type> extensionMap = {
+                // Image formats
+                {".png", Type::T_IMAGE}, {".jpg", Type::T_IMAGE}, {".jpeg", Type::T_IMAGE},
+                {".bmp", Type::T_IMAGE}, {".gif", Type::T_IMAGE}, {".tga", Type::T_IMAGE},
+                // Sound formats
+                {".wav", Type::T_SOUND}, {".mp3", Type::T_SOUND}, {".ogg", Type::T_SOUND},
+                // Font formats
+                {".ttf", Type::T_FONT}, {".otf", Type::T_FONT}, {".fnt", Type::T_FONT},
+                // Shader formats
+                {".geom", Type::T_SHADER}, {".frag", Type::T_SHADER}, {".vert", Type::T_SHADER},
+                // Text formats
+                {".txt", Type::T_TEXT}, {".md", Type::T_TEXT},
+                // Script formats
+                {".cpp", Type::T_SCRIPT}, {".hpp", Type::T_SCRIPT},
+                // Model formats
+                {".fbx", Type::T_MODEL},
+                // Material formats
+                {".mat", Type::T_MATERIAL}, {".material", Type::T_MATERIAL},
+                // Level formats
+                {".level", Type::T_LEVEL}, {".lvl", Type::T_LEVEL},
+                // Config formats
+                {".json", Type::T_CONFIG}, {".ini", Type::T_CONFIG}, {".cfg", Type::T_CONFIG},
+                // Directory (fallback, not based on extension)
+                {"<directory>", Type::T_DIRECTORY}  // special case if needed
+            };
+
+            // Ensure extension starts with dot
+            if (extension.empty() || extension[0] != '.') {
+                extension = "." + extension;
+            }
+
+            auto it = extensionMap.find(extension);
+            if (it != extensionMap.end()) {
+                return it->second;
+            }
+
+            return Type::T_TEXT;
+        }
+
+        void ComputeDerivedParts(PathRecord& record) {
+            std::filesystem::path path(record.full);
+
+            if (!record.full.empty())
+                record.absolute = path.is_absolute() ? record.full : (GetWorkingDirectory() / path).lexically_normal().string();
+            record.parent = path.parent_path().string();
+            record.filename = path.filename().string();
+            record.stem = path.stem().string();
+            record.extension = path.extension().string();
+            std::transform(record.extension.begin(), record.extension.end(), record.extension.begin(), ::tolower);
+            record.type = GetTypeOfExtension(record.extension);
+
+            // Inside an archive when a component ends with ".caf" and is followed by another one
+            for (size_t pos = record.full.find(".caf"); pos != std::string::npos; pos = record.full.find(".caf", pos + 1)) {
+                size_t end = pos + 4;
+                if (end < record.full.size() && (record.full[end] == '/' || record.full[end] == std::filesystem::path::preferred_separator)) {
+                    record.packed = true;
+                    record.parentArchive = record.full.substr(0, end);
+                    record.insideArchive = std::filesystem::path(record.full.substr(end + 1)).generic_string();
+                    break;
+                }
+            }
+        }
+
+        const PathRecord* InternPath(const std::string& raw) {
+            PathTable& table = GetPathTable();
+            {
+                std::shared_lock<std::shared_mutex> lock(table.mutex);
+                auto spelling = table.spellings.find(raw);
+                if (spelling != table.spellings.end())
+                    return spelling->second;
+            }
+
+            std::string normalized = Path::Normalize(raw);
+
+            std::unique_lock<std::shared_mutex> lock(table.mutex);
+            auto [record, inserted] = table.records.try_emplace(normalized);
+            if (inserted) {
+                record->second.full = normalized;
+                ComputeDerivedParts(record->second);
+            }
+            table.spellings.emplace(raw, &record->second);
+            return &record->second;
+        }
+    }
+
     Path FileManager::root = Path("");
     Path FileManager::projectRoot = Path("");
 
@@ -25,50 +150,42 @@ namespace Epoch::Engine::Filesystem{
     {
         std::vector<FileInfo> files;
 
-        if (!std::filesystem::exists(path.full) || !std::filesystem::is_directory(path.full))
-            DEBUG_ERROR("Cannot list files inside non-existing directory");
-
-        auto processEntry = [&](const auto& entry) {
-            Path filePath(entry.path().string());
-            
-            if (entry.is_directory() && includeDirs)
-            {
-                FileInfo info = GetFileInfos(filePath);
-                files.push_back(info);
+        // Archives list a directory from their tree, without touching the other entries
+        if (path.IsPacked()) {
+            std::string archivePath = path.GetParentArchive();
+            std::string insidePath = path.GetPathInsideArchive();
+            std::shared_ptr<Archive> archive = ArchiveCache::GetInstance().Get(archivePath);
+            if (!archive || !archive->IsDirectory(insidePath)) {
+                DEBUG_ERROR("Cannot list files inside non-existing directory");
+                return files;
             }
-            else if (entry.is_regular_file())
-            {
+
+            if (includeDirs)
+                for (std::string_view directory : archive->ListDirectories(insidePath, recursive))
+                    files.push_back(GetFileInfos(Path(archivePath + "/" + std::string(directory))));
+
+            for (const ArchiveEntry* entry : archive->ListFiles(insidePath, recursive)) {
+                Path filePath(archivePath + "/" + std::string(entry->path));
                 auto extType = filePath.GetExtensionType();
                 if (acceptedExtensions.empty() ||
                     std::find(acceptedExtensions.begin(), acceptedExtensions.end(), extType) != acceptedExtensions.end()) {
                     files.push_back(GetFileInfos(filePath));
                 }
             }
-        };
-
-        if (recursive)
-        {
-            for (const auto& entry : std::filesystem::recursive_directory_iterator(path.full,
-                        std::filesystem::directory_options::skip_permission_denied))
-            {
-                processEntry(entry);
-            }
-        }
-        else
-        {
-            for (const auto& entry : std::filesystem::directory_iterator(path.full,
-                        std::filesystem::directory_options::skip_permission_denied))
-            {
-                processEntry(entry);
-            }
+            return files;
         }
 
+        if (!DirectoryCache::GetInstance().ListDirectory(path, acceptedExtensions, includeDirs, recursive, files))
+            DEBUG_ERROR("Cannot list files inside non-existing directory");
+
         return files;
     }
 
     FileInfo FileManager::GetFileInfos(const Path &path)
     {
         FileInfo infos;
+        if (!path.IsPacked() && DirectoryCache::GetInstance().GetFileInfos(path, infos))
+            return infos;
     
         infos.path = path.full;
         infos.name = path.GetFilename(false);
@@ -76,16 +193,24 @@ namespace Epoch::Engine::Filesystem{
         infos.size = path.GetFileSize();
         infos.type = path.GetExtensionType();
 
+        std::error_code error;
+        if (!path.IsPacked())
+            infos.writeTime = std::filesystem::last_write_time(path.full, error);
+
         return infos;
     }
 
     std::string Path::ReadFile() const
     {
         if(IsPacked()){
-            CosemUnPacker unpacker;
-            unpacker.OpenArchive(GetParentArchive());
-            std::vector<char> characters = unpacker.ExtractFileToMemory(GetPathInsideArchive());
-            return std::string(characters.begin(), characters.end());
+            std::string contents;
+            std::shared_ptr<Archive> archive = ArchiveCache::GetInstance().Get(GetParentArchive());
+            const ArchiveEntry* entry = archive ? archive->Find(GetPathInsideArchive()) : nullptr;
+            if (!entry)
+                DEBUG_ERROR("Can't find file in archive : " + full);
+            else
+                archive->Read(*entry, contents);
+            return contents;
         }
         else{
             std::ifstream file(full, std::ios::binary);
@@ -96,6 +221,34 @@ namespace Epoch::Engine::Filesystem{
         }
     }
 
+    std::string Path::ReadFileRange(size_t offset, size_t length) const
+    {
+        std::string contents;
+        if(IsPacked()){
+            std::shared_ptr<Archive> archive = ArchiveCache::GetInstance().Get(GetParentArchive());
+            const ArchiveEntry* entry = archive ? archive->Find(GetPathInsideArchive()) : nullptr;
+            if (!entry) {
+                DEBUG_ERROR("Can't find file in archive : " + full);
+                return contents;
+            }
+            contents.resize(length);
+            if (!archive->ReadRange(*entry, offset, length, reinterpret_cast<uint8_t*>(contents.data())))
+                contents.clear();
+        }
+        else{
+            std::ifstream file(full, std::ios::binary);
+            if (!file) {
+                DEBUG_ERROR("Can't read file at path : " + full);
+                return contents;
+            }
+            contents.resize(length);
+            file.seekg(static_cast<std::streamoff>(offset));
+            file.read(contents.data(), static_cast<std::streamsize>(length));
+            contents.resize(static_cast<size_t>(file.gcount()));
+        }
+        return contents;
+    }
+
     std::string Path::WithoutExtension() const
     {
         std::filesystem::path p(full);
@@ -109,7 +262,7 @@ namespace Epoch::Engine::Filesystem{
             return false;
         }
     
-        std::ofstream out(full, std::ios::trunc); // truncate = overwrite if file exists
+        std::ofstream out(full, std::ios::binary | std::ios::trunc); // truncate = overwrite if file exists
         if (!out.is_open()) return false;
     
         try {
@@ -118,6 +271,7 @@ namespace Epoch::Engine::Filesystem{
             return false;
         }
     
+        DirectoryCache::GetInstance().Invalidate(*this);
         return true;
     }
 
@@ -135,58 +289,19 @@ namespace Epoch::Engine::Filesystem{
         } catch (...) {
             return false;
         }
+        DirectoryCache::GetInstance().Invalidate(*this);
         return true;
     }
 
     Type Path::GetExtensionType() const
     {
-        std::string str = std::filesystem::path(GetAbsolutePath()).extension().string();
-
-        std::transform(str.begin(), str.end(), str.begin(), ::tolower);
-
-        static const std::unordered_map<std::string, Type> extensionMap = {
-            // Image formats
-            {".png", Type::T_IMAGE}, {".jpg", Type::T_IMAGE}, {".jpeg", Type::T_IMAGE},
-            {".bmp", Type::T_IMAGE}, {".gif", Type::T_IMAGE}, {".tga", Type::T_IMAGE},
-            // Sound formats
-            {".wav", Type::T_SOUND}, {".mp3", Type::T_SOUND}, {".ogg", Type::T_SOUND},
-            // Font formats
-            {".ttf", Type::T_FONT}, {".otf", Type::T_FONT}, {".fnt", Type::T_FONT},
-            // Shader formats
-            {".geom", Type::T_SHADER}, {".frag", Type::T_SHADER}, {".vert", Type::T_SHADER},
-            // Text formats
-            {".txt", Type::T_TEXT}, {".md", Type::T_TEXT},
-            // Script formats
-            {".cpp", Type::T_SCRIPT}, {".hpp", Type::T_SCRIPT},
-            // Model formats
-            {".fbx", Type::T_MODEL},
-            // Material formats
-            {".mat", Type::T_MATERIAL}, {".material", Type::T_MATERIAL},
-            // Level formats
-            {".level", Type::T_LEVEL}, {".lvl", Type::T_LEVEL},
-            // Config formats
-            {".json", Type::T_CONFIG}, {".ini", Type::T_CONFIG}, {".cfg", Type::T_CONFIG},
-            // Directory (fallback, not based on extension)
-            {"<directory>", Type::T_DIRECTORY}  // special case if needed
-        };
-
-        // Ensure extension starts with dot
-        if (str.empty() || str[0] != '.') {
-            str = "." + str;
-        }
-
-        auto it = extensionMap.find(str);
-        if (it != extensionMap.end()) {
-            return it->second;
-        }
-
-        return Type::T_TEXT;
+        return GetRecord().type;
     }
 
     bool FileManager::IsPathInside(const Path &parent, const Path &child)
     {
-        std::filesystem::path parentPath = std::filesystem::weakly_canonical(parent.GetAbsolutePath());
-        std::filesystem::path childPath = std::filesystem::weakly_canonical(child.GetAbsolutePath());
+        std::filesystem::path parentPath = parent.GetAbsolutePath();
+        std::filesystem::path childPath = child.GetAbsolutePath();
 
         // Check if childPath starts with parentPath
         auto parentIt = parentPath.begin();
@@ -233,69 +348,71 @@ namespace Epoch::Engine::Filesystem{
 
     Path::Path(const std::string &raw)
     {
-        full = Normalize(raw);
+        record = InternPath(raw);
+        full = record->full;
+    }
+
+    const PathRecord &Path::GetRecord() const
+    {
+        static const PathRecord* empty = InternPath("");
+        return record ? *record : *empty;
     }
 
     std::string Path::Normalize(const std::string &raw)
     {
-        return std::filesystem::weakly_canonical(raw).string();
+        if (raw.empty())
+            return raw;
+
+        std::string normalized = std::filesystem::path(raw).lexically_normal().string();
+
+        // "a/" and "a" are the same path, the root keeps its separator
+        while (normalized.size() > 1 && (normalized.back() == '/' || normalized.back() == std::filesystem::path::preferred_separator)
+            && normalized[normalized.size() - 2] != ':')
+            normalized.pop_back();
+        return normalized;
     }
 
     Path Path::RelativeTo(const Path &other) const
     {
-        try {
-            std::filesystem::path rel = std::filesystem::relative(full, other.full);
-            return Path(rel.string());
-        } catch (const std::filesystem::filesystem_error& e) {
+        std::filesystem::path rel = std::filesystem::path(GetAbsolutePath()).lexically_relative(other.GetAbsolutePath());
+        if (rel.empty())
             return *this;
-        }
+        return Path(rel.string());
     }
 
     std::string Path::GetExtensionString() const
     {
-        auto ext = std::filesystem::path(full).extension().string();
-        std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
-        return ext;
+        return GetRecord().extension;
     }
 
     std::string Path::GetAbsolutePath() const
     {
-        std::filesystem::path abs = std::filesystem::weakly_canonical(std::filesystem::absolute(full));
-        return abs.string();
+        return GetRecord().absolute;
     }
 
     std::string Path::GetFilename(bool withExtension) const
     {
-        auto p = std::filesystem::path(full);
-        return withExtension ? p.filename().string() : p.stem().string();
+        return withExtension ? GetRecord().filename : GetRecord().stem;
     }
 
     std::string Path::GetParent() const
     {
-        return std::filesystem::path(full).parent_path().string();
+        return GetRecord().parent;
     }
 
     int Path::GetFileSize() const
     {
         if (IsPacked()) {
-            CosemUnPacker unpacker;
-            unpacker.OpenArchive(GetParentArchive());
-            auto fileIndex = unpacker.GetFileIndex();
+            std::shared_ptr<Archive> archive = ArchiveCache::GetInstance().Get(GetParentArchive());
+            if (!archive)
+                return -1;
 
             std::string insidePath = GetPathInsideArchive();
+            if (const ArchiveEntry* entry = archive->Find(insidePath))
+                return static_cast<int>(entry->originalSize);
 
-            if (IsDirectory() && !insidePath.empty() && insidePath.back() != '/')
-                insidePath += '/';
-
-            int totalSize = 0;
-
-            for (const auto& entry : fileIndex) {
-                if (entry.path == insidePath || entry.path.compare(0, insidePath.size(), insidePath) == 0) {
-                    totalSize += entry.fileSize;
-                }
-            }
-
-            return static_cast<int>(totalSize);
+            // Not a file, sum the directory
+            return static_cast<int>(archive->GetDirectorySize(insidePath));
         } else {
             if (IsDirectory()) {
                 int totalSize = 0;
@@ -329,50 +446,48 @@ namespace Epoch::Engine::Filesystem{
             DEBUG_ERROR("Cannot get parent archive for a file that is not placed in an archive");
             return "";
         }
-        else{
-
-            size_t pos = full.find(".caf");
-            if (pos == std::string::npos) {
-                DEBUG_ERROR("Packed resource path does not contain '.caf', it is not placed in an archive");
-            }
-
-            return full.substr(0, pos + 4);
-        }
+        return GetRecord().parentArchive;
     }
 
     std::string Path::GetPathInsideArchive() const
     {
-        const std::string &fullPath = this->full;
-        size_t pos = fullPath.find(".caf");
-        if (pos == std::string::npos) {
+        if (!IsPacked()) {
             DEBUG_ERROR("File is not inside an archive");
+            return "";
         }
-
-        size_t start = pos + 5;
-        if (start >= fullPath.size()) return "";
-    
-        return fullPath.substr(start);
+        return GetRecord().insideArchive;
     }
 
     bool Path::IsPacked() const
     {
-        return full.find(".caf/") != std::string::npos;
+        return GetRecord().packed;
     }
 
     bool Path::Exists() const
     {
+        if (IsPacked()) {
+            std::shared_ptr<Archive> archive = ArchiveCache::GetInstance().Get(GetParentArchive());
+            std::string insidePath = GetPathInsideArchive();
+            return archive && (archive->Find(insidePath) || archive->IsDirectory(insidePath));
+        }
         return std::filesystem::exists(full);
     }
 
     bool Path::IsDirectory() const
     {
+        if (IsPacked()) {
+            std::shared_ptr<Archive> archive = ArchiveCache::GetInstance().Get(GetParentArchive());
+            return archive && archive->IsDirectory(GetPathInsideArchive());
+        }
         return std::filesystem::is_directory(full);
     }
 
     bool Path::IsSubPathOf(const Path &child, const Path &parent)
     {
-        auto childStr = std::filesystem::weakly_canonical(child.full).string();
-        auto parentStr = std::filesystem::weakly_canonical(parent.full).string();
+        auto childStr = child.GetAbsolutePath();
+        auto parentStr = parent.GetAbsolutePath();
+        if (parentStr.empty())
+            return false;
     
         // Ensure parent path ends with a slash to avoid partial match
         if (parentStr.back() != '/' && parentStr.back() != '\\')
@@ -30,16 +30,20 @@ namespace Epoch::Engine::Filesystem{
         T_DIRECTORY
     };
 
+    // Normalized string of a path with its derived parts, interned once per process. See filesystem.cpp
+    struct PathRecord;
+
     // --- Path infos ---
+    // Construction is lexical and doesn't touch the filesystem, only Exists, IsDirectory, GetFileSize and the reads do
     class Path {
 
         public:
-        std::string full;  // Full/normalized path
+        std::string full;  // Normalized path, read only (the derived parts are cached from it)
     
         Path() = default;
         Path(const std::string& raw);
     
-        // Normalize slashes, remove ../, etc.
+        // Removes ./ and ../ and duplicate separators, without resolving symlinks. Relative paths stay relative
         static std::string Normalize(const std::string& raw);
     
         Path RelativeTo(const Path& other) const;
@@ -48,6 +52,9 @@ namespace Epoch::Engine::Filesystem{
 
         std::string ReadFile() const;
 
+        // Reads "length" bytes from "offset", without loading the rest of the file
+        std::string ReadFileRange(size_t offset, size_t length) const;
+
         std::string WithoutExtension() const;
 
         bool WriteFile(const std::string &content) const;
@@ -77,6 +84,11 @@ namespace Epoch::Engine::Filesystem{
         bool IsDirectory() const;
 
         static bool IsSubPathOf(const Path& child, const Path& parent);
+
+        private:
+        const PathRecord* record = nullptr;     // Shared by every Path with the same normalized string
+
+        const PathRecord& GetRecord() const;
     };
 
     // --- Basic file info ---
@@ -86,6 +98,7 @@ namespace Epoch::Engine::Filesystem{
         Type type;
         bool isDirectory;
         int size;
+        std::filesystem::file_time_type writeTime;
     };
 
     class FileManager {
@@ -99,7 +112,7 @@ namespace Epoch::Engine::Filesystem{
             static void Init(std::string rootPath = "", std::string projectRootPath = "");
 
 
-            // File and directory browsing
+            // File and directory browsing, served by DirectoryCache outside of archives
             static FileInfo GetFileInfos(const Path& path);
             static std::vector<FileInfo> ListDirectory(const Path &path, std::vector<Type> acceptedExtensions, bool includeDirs = false, bool recursive = false);
 
@@ -0,0 +1,122 @@
+#include "mapped_file.hpp"
+
+#include "engine/debugging/debugger.hpp"
+
+#if defined(_WIN32)
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <windows.h>
+#else
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+namespace Epoch::Engine::Filesystem{
+
+    /// @brief Opens a file for reading
+    /// @return The view, or nullptr if the file can't be opened
+    std::shared_ptr<MappedFile> MappedFile::Open(const Path &path)
+    {
+        std::shared_ptr<MappedFile> file(new MappedFile());
+
+        if (path.IsPacked()) {
+            std::shared_ptr<Archive> archive = ArchiveCache::GetInstance().Get(path.GetParentArchive());
+            const ArchiveEntry* entry = archive ? archive->Find(path.GetPathInsideArchive()) : nullptr;
+            if (!entry) {
+                DEBUG_ERROR("Can't find file in archive : " + path.full);
+                return nullptr;
+            }
+
+            // Stored entries are views of the archive mapping, compressed ones are decompressed once
+            if (!archive->Read(*entry, file->archiveData))
+                return nullptr;
+            file->data = file->archiveData.data;
+            file->size = file->archiveData.size;
+            return file;
+        }
+
+#if defined(_WIN32)
+        HANDLE handle = CreateFileA(path.full.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (handle == INVALID_HANDLE_VALUE) {
+            DEBUG_ERROR("Can't open file for mapping : " + path.full);
+            return nullptr;
+        }
+
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(handle, &fileSize)) {
+            CloseHandle(handle);
+            DEBUG_ERROR("Can't get the size of : " + path.full);
+            return nullptr;
+        }
+
+        file->fileHandle = handle;
+        file->size = static_cast<size_t>(fileSize.QuadPart);
+
+        if (file->size == 0)
+            return file;
+
+        HANDLE mapping = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!mapping) {
+            DEBUG_ERROR("Can't map file : " + path.full);
+            return nullptr;
+        }
+        file->mappingHandle = mapping;
+
+        file->data = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        if (!file->data) {
+            DEBUG_ERROR("Can't map file : " + path.full);
+            return nullptr;
+        }
+#else
+        int fd = open(path.full.c_str(), O_RDONLY);
+        if (fd < 0) {
+            DEBUG_ERROR("Can't open file for mapping : " + path.full);
+            return nullptr;
+        }
+
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            close(fd);
+            DEBUG_ERROR("Can't get the size of : " + path.full);
+            return nullptr;
+        }
+
+        file->size = static_cast<size_t>(st.st_size);
+
+        if (file->size == 0) {
+            close(fd);
+            return file;
+        }
+
+        void* address = mmap(nullptr, file->size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+
+        if (address == MAP_FAILED) {
+            DEBUG_ERROR("Can't map file : " + path.full);
+            return nullptr;
+        }
+
+        file->data = static_cast<const uint8_t*>(address);
+#endif
+
+        file->mapped = true;
+        return file;
+    }
+
+    MappedFile::~MappedFile()
+    {
+#if defined(_WIN32)
+        if (mapped && data)
+            UnmapViewOfFile(data);
+        if (mappingHandle)
+            CloseHandle(mappingHandle);
+        if (fileHandle)
+            CloseHandle(fileHandle);
+#else
+        if (mapped && data)
+            munmap(const_cast<uint8_t*>(data), size);
+#endif
+    }
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "filesystem.hpp"
+#include "archive.hpp"
+
+#include <memory>
+#include <cstdint>
+
+namespace Epoch::Engine::Filesystem{
+
+    // Read-only view of a whole file. Loose files are memory-mapped, packed files point into their mapped archive
+    // (or into a buffer when they are compressed)
+    class MappedFile {
+        public:
+            static std::shared_ptr<MappedFile> Open(const Path& path);
+
+            ~MappedFile();
+
+            MappedFile(const MappedFile&) = delete;
+            MappedFile& operator=(const MappedFile&) = delete;
+
+            const uint8_t* GetData() const { return data; }
+            size_t GetSize() const { return size; }
+            bool IsMapped() const { return mapped; }
+
+        private:
+            MappedFile() = default;
+
+            const uint8_t* data = nullptr;
+            size_t size = 0;
+            bool mapped = false;
+            ArchiveData archiveData;               // Contents of a packed file
+
+#if defined(_WIN32)
+            void* fileHandle = nullptr;
+            void* mappingHandle = nullptr;
+#endif
+    };
+}
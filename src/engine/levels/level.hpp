@@ -61,7 +61,7 @@ namespace Epoch::Engine::Levels{
         std::vector<std::shared_ptr<ECS::Components::Camera>> cameras;
         std::vector<std::shared_ptr<ECS::Components::Script>> scripts;
 
-        std::unordered_map<int, std::pair<glm::mat4, Rendering::Mesh*>> meshes;
+        std::unordered_map<int, Rendering::ShadowCaster> meshes;
         
         bool loaded = false;
         
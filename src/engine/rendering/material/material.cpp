@@ -64,37 +64,61 @@ namespace Epoch::Engine::Rendering{
         return nullptr;
     }
 
-    void Material::Use()
+    /// @brief Keywords the material needs from its shader (render mode, shadows, normal map and its channels)
+    uint32_t Material::GetKeywords() const
     {
-        shader->Activate();
+        uint32_t keywords = 0;
+        if (renderMode == MASKED)
+            keywords |= KEYWORD_MASKED;
+        if (recievesShadows)
+            keywords |= KEYWORD_RECEIVE_SHADOWS;
+
+        auto normalMap = parameters.find("normalMap");
+        if (normalMap != parameters.end()) {
+            const std::shared_ptr<Texture>* texture = std::get_if<std::shared_ptr<Texture>>(&normalMap->second);
+            if (texture && *texture) {
+                keywords |= KEYWORD_NORMAL_MAP;
+                if ((*texture)->GetInfos()->nrChannels == 2)
+                    keywords |= KEYWORD_RECONSTRUCT_NORMAL_Z;
+            }
+        }
+
+        return keywords;
+    }
+
+    /// @brief Activates the variant of the shader for "keywords" and sets every parameter on it
+    void Material::Use(uint32_t keywords)
+    {
+        Shader* program = shader->GetVariant(keywords);
+        program->Activate();
 
         int textureUnit = 0;
 
         for (const auto& [name, value] : parameters)
         {
             if (std::holds_alternative<float>(value)){
-                shader->setFloat(name, std::get<float>(value));
+                program->setFloat(name, std::get<float>(value));
             }
             else if (std::holds_alternative<int>(value)){
-                shader->setInt(name, std::get<int>(value));
+                program->setInt(name, std::get<int>(value));
             }
             else if (std::holds_alternative<glm::vec2>(value)){
-                shader->setVec2(name, std::get<glm::vec2>(value));
+                program->setVec2(name, std::get<glm::vec2>(value));
             }
             else if (std::holds_alternative<glm::vec3>(value)){
-                shader->setVec3(name, std::get<glm::vec3>(value));
+                program->setVec3(name, std::get<glm::vec3>(value));
             }
             else if (std::holds_alternative<glm::vec4>(value)){
-                shader->setVec4(name, std::get<glm::vec4>(value));
+                program->setVec4(name, std::get<glm::vec4>(value));
             }
             else if (std::holds_alternative<glm::mat4>(value)){
-                shader->setMat4(name, std::get<glm::mat4>(value));
+                program->setMat4(name, std::get<glm::mat4>(value));
             }
             else if (std::holds_alternative<std::shared_ptr<Texture>>(value)){
                 std::shared_ptr<Texture> val = std::get<std::shared_ptr<Texture>>(value);
                 if (val != nullptr) {
                     val->Bind(textureUnit); // Bind to GL_TEXTURE0 + textureUnit
-                    shader->setInt(name, textureUnit);
+                    program->setInt(name, textureUnit);
                     textureUnit++;
                 }
             }
@@ -29,7 +29,9 @@ namespace Epoch::Engine::Rendering {
     
             std::map<std::string, UniformValue>* GetParameters() { return &parameters; };
             std::shared_ptr<Texture> GetTexture(std::string name);
-            void Use();
+            void Use() { Use(GetKeywords()); }
+            void Use(uint32_t keywords);
+            uint32_t GetKeywords() const;
             void StopUsing();
             std::shared_ptr<Shader> shader;
             bool recievesShadows = false;
@@ -0,0 +1,353 @@
+#include "geometry_arena.hpp"
+
+#include "engine/rendering/upload/upload_queue.hpp"
+#include "engine/debugging/debugger.hpp"
+
+#include <algorithm>
+
+namespace Epoch::Engine::Rendering{
+
+    constexpr size_t INITIAL_VERTEX_CAPACITY = 1 << 16;
+    constexpr size_t INITIAL_INDEX_CAPACITY = 1 << 20;
+    constexpr size_t INDEX_ALIGNMENT = 4;
+    constexpr size_t INITIAL_DRAW_ID_CAPACITY = 1024;
+
+    /// @brief Creates the VAO and the initial buffers of every vertex format
+    void GeometryArena::Init()
+    {
+        if (initialized)
+            return;
+
+        buffers[static_cast<int>(VertexFormat::Full)].format = VertexFormat::Full;
+        buffers[static_cast<int>(VertexFormat::Full)].vertexStride = sizeof(Vertex);
+        buffers[static_cast<int>(VertexFormat::Compact)].format = VertexFormat::Compact;
+        buffers[static_cast<int>(VertexFormat::Compact)].vertexStride = sizeof(CompactVertex);
+
+        glGenBuffers(1, &drawIDBuffer);
+        drawIDCapacity = 0;
+        initialized = true;
+        ReserveDrawIDs(INITIAL_DRAW_ID_CAPACITY);
+
+        for (Buffers& b : buffers) {
+            glGenVertexArrays(1, &b.VAO);
+            glGenBuffers(1, &b.VBO);
+            glGenBuffers(1, &b.EBO);
+
+            b.vertexCapacity = INITIAL_VERTEX_CAPACITY;
+            b.indexCapacity = INITIAL_INDEX_CAPACITY;
+            b.freeVertices = { Range{0, b.vertexCapacity} };
+            b.freeIndices = { Range{0, b.indexCapacity} };
+
+            glBindBuffer(GL_COPY_WRITE_BUFFER, b.VBO);
+            glBufferData(GL_COPY_WRITE_BUFFER, b.vertexCapacity * b.vertexStride, nullptr, GL_STATIC_DRAW);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, b.EBO);
+            glBufferData(GL_COPY_WRITE_BUFFER, b.indexCapacity, nullptr, GL_STATIC_DRAW);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+            SetupVertexLayout(b);
+        }
+    }
+
+    void GeometryArena::Shutdown()
+    {
+        if (!initialized)
+            return;
+
+        for (Buffers& b : buffers) {
+            glDeleteVertexArrays(1, &b.VAO);
+            glDeleteBuffers(1, &b.VBO);
+            glDeleteBuffers(1, &b.EBO);
+            b = Buffers{};
+        }
+
+        glDeleteBuffers(1, &drawIDBuffer);
+        drawIDBuffer = 0;
+        drawIDCapacity = 0;
+
+        initialized = false;
+    }
+
+    /// @brief Binds the arena buffers to the VAO of a vertex format (called again after each reallocation)
+    void GeometryArena::SetupVertexLayout(Buffers &b)
+    {
+        glBindVertexArray(b.VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, b.VBO);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, b.EBO);
+
+        if (b.format == VertexFormat::Compact) {
+            // layout: 0 - position (unorm16), 1 - normal (octahedral), 3 - texCoord (half), 4 - tangent (octahedral)
+            // The color attribute (2) is left disabled, it is replaced by the "meshColor" uniform
+            glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(CompactVertex), (void*)offsetof(CompactVertex, position));
+            glEnableVertexAttribArray(0);
+
+            glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, sizeof(CompactVertex), (void*)offsetof(CompactVertex, normal));
+            glEnableVertexAttribArray(1);
+
+            glVertexAttribPointer(3, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(CompactVertex), (void*)offsetof(CompactVertex, texCoord));
+            glEnableVertexAttribArray(3);
+
+            glVertexAttribPointer(4, 2, GL_SHORT, GL_TRUE, sizeof(CompactVertex), (void*)offsetof(CompactVertex, tangent));
+            glEnableVertexAttribArray(4);
+        }
+        else {
+            // layout: 0 - position, 1 - normal, 2 - color, 3 - texCoord, 4 - tangent
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+            glEnableVertexAttribArray(0);
+
+            glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal));
+            glEnableVertexAttribArray(1);
+
+            glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, color));
+            glEnableVertexAttribArray(2);
+
+            glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, texCoord));
+            glEnableVertexAttribArray(3);
+
+            glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, tangent));
+            glEnableVertexAttribArray(4);
+        }
+
+        // 5 - draw ID (per instance)
+        if (drawIDBuffer != 0) {
+            glBindBuffer(GL_ARRAY_BUFFER, drawIDBuffer);
+            glVertexAttribIPointer(5, 1, GL_UNSIGNED_INT, sizeof(uint32_t), (void*)0);
+            glVertexAttribDivisor(5, 1);
+            glEnableVertexAttribArray(5);
+        }
+
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    void GeometryArena::ReserveDrawIDs(size_t count)
+    {
+        if (!initialized || count <= drawIDCapacity)
+            return;
+
+        size_t newCapacity = std::max(count, drawIDCapacity * 2);
+
+        std::vector<uint32_t> ids(newCapacity);
+        for (size_t i = 0; i < newCapacity; i++)
+            ids[i] = static_cast<uint32_t>(i);
+
+        glBindBuffer(GL_COPY_WRITE_BUFFER, drawIDBuffer);
+        glBufferData(GL_COPY_WRITE_BUFFER, newCapacity * sizeof(uint32_t), ids.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+        drawIDCapacity = newCapacity;
+
+        // The VAOs keep a reference to the buffer, but are refreshed in case it was just created
+        for (Buffers& b : buffers) {
+            if (b.VAO != 0)
+                SetupVertexLayout(b);
+        }
+    }
+
+    /// @brief Reallocates a buffer with a bigger size and copies the previous content on the GPU
+    /// @return The new buffer
+    GLuint ReallocateBuffer(GLuint oldBuffer, size_t oldSize, size_t newSize)
+    {
+        // Queued copies target the old buffer, they have to land before its content is moved
+        UploadQueue::GetInstance().Flush();
+
+        GLuint newBuffer;
+        glGenBuffers(1, &newBuffer);
+
+        glBindBuffer(GL_COPY_WRITE_BUFFER, newBuffer);
+        glBufferData(GL_COPY_WRITE_BUFFER, newSize, nullptr, GL_STATIC_DRAW);
+
+        glBindBuffer(GL_COPY_READ_BUFFER, oldBuffer);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, oldSize);
+
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+        glDeleteBuffers(1, &oldBuffer);
+
+        return newBuffer;
+    }
+
+    void GeometryArena::GrowVertices(Buffers &b, size_t minFreeVertices)
+    {
+        size_t oldCapacity = b.vertexCapacity;
+        size_t newCapacity = std::max(oldCapacity * 2, oldCapacity + minFreeVertices);
+
+        b.VBO = ReallocateBuffer(b.VBO, oldCapacity * b.vertexStride, newCapacity * b.vertexStride);
+        b.vertexCapacity = newCapacity;
+        FreeRange(b.freeVertices, oldCapacity, newCapacity - oldCapacity);
+
+        SetupVertexLayout(b);
+
+        DEBUG_LOG("Geometry arena vertex buffer grown to " + std::to_string(newCapacity) + " vertices");
+    }
+
+    void GeometryArena::GrowIndices(Buffers &b, size_t minFreeBytes)
+    {
+        size_t oldCapacity = b.indexCapacity;
+        size_t newCapacity = std::max(oldCapacity * 2, oldCapacity + minFreeBytes);
+
+        b.EBO = ReallocateBuffer(b.EBO, oldCapacity, newCapacity);
+        b.indexCapacity = newCapacity;
+        FreeRange(b.freeIndices, oldCapacity, newCapacity - oldCapacity);
+
+        SetupVertexLayout(b);
+
+        DEBUG_LOG("Geometry arena index buffer grown to " + std::to_string(newCapacity) + " bytes");
+    }
+
+    /// @brief First fit allocation in a sorted free list
+    /// @return false if no free range is big enough
+    bool GeometryArena::AllocateRange(std::vector<Range> &freeList, size_t size, size_t &offset)
+    {
+        for (auto it = freeList.begin(); it != freeList.end(); ++it) {
+            if (it->size < size)
+                continue;
+
+            offset = it->offset;
+            it->offset += size;
+            it->size -= size;
+
+            if (it->size == 0)
+                freeList.erase(it);
+
+            return true;
+        }
+        return false;
+    }
+
+    /// @brief Returns a range to a sorted free list, merging it with its neighbours
+    void GeometryArena::FreeRange(std::vector<Range> &freeList, size_t offset, size_t size)
+    {
+        if (size == 0)
+            return;
+
+        auto it = std::lower_bound(freeList.begin(), freeList.end(), offset, [](const Range& r, size_t value) {
+            return r.offset < value;
+        });
+
+        it = freeList.insert(it, Range{offset, size});
+
+        // Merge with the next range
+        auto next = it + 1;
+        if (next != freeList.end() && it->offset + it->size == next->offset) {
+            it->size += next->size;
+            freeList.erase(next);
+        }
+
+        // Merge with the previous range
+        if (it != freeList.begin()) {
+            auto prev = it - 1;
+            if (prev->offset + prev->size == it->offset) {
+                prev->size += it->size;
+                freeList.erase(it);
+            }
+        }
+    }
+
+    /// @brief Copies a mesh into the arena
+    /// @param format The layout of "vertexData"
+    /// @param vertexData The vertices (Vertex or CompactVertex)
+    /// @param vertexCount The number of vertices
+    /// @param indexData The raw index buffer, indices are relative to the first vertex of the mesh
+    /// @param indexBytes The size of "indexData" in bytes
+    /// @param keepAlive Owns "vertexData" and "indexData" until the upload queue copied them
+    /// @param stagedVertices The vertices already written into the upload ring by a worker, replaces "vertexData"
+    /// @param stagedIndices The indices already written into the upload ring, replaces "indexData"
+    /// @return The allocation, invalid if the arena isn't initialized
+    GeometryAllocation GeometryArena::Allocate(VertexFormat format, const void *vertexData, size_t vertexCount, const void *indexData, size_t indexBytes, std::shared_ptr<const void> keepAlive,
+                                               const StagingAllocation &stagedVertices, const StagingAllocation &stagedIndices)
+    {
+        GeometryAllocation allocation;
+
+        if (!initialized) {
+            DEBUG_ERROR("Geometry arena used before initialization");
+            return allocation;
+        }
+
+        if (vertexCount == 0 || indexBytes == 0)
+            return allocation;
+
+        Buffers& b = buffers[static_cast<int>(format)];
+        size_t alignedIndexBytes = (indexBytes + INDEX_ALIGNMENT - 1) / INDEX_ALIGNMENT * INDEX_ALIGNMENT;
+
+        size_t baseVertex = 0;
+        if (!AllocateRange(b.freeVertices, vertexCount, baseVertex)) {
+            GrowVertices(b, vertexCount);
+            AllocateRange(b.freeVertices, vertexCount, baseVertex);
+        }
+
+        size_t indexOffset = 0;
+        if (!AllocateRange(b.freeIndices, alignedIndexBytes, indexOffset)) {
+            GrowIndices(b, alignedIndexBytes);
+            AllocateRange(b.freeIndices, alignedIndexBytes, indexOffset);
+        }
+
+        // Buffer copies are spread over the frames, the draws wait for their tickets
+        UploadRequest vertices;
+        vertices.object = b.VBO;
+        vertices.offset = baseVertex * b.vertexStride;
+        vertices.data = vertexData;
+        vertices.size = vertexCount * b.vertexStride;
+        vertices.keepAlive = keepAlive;
+        vertices.staging = stagedVertices;
+        allocation.vertexUpload = UploadQueue::GetInstance().Submit(std::move(vertices));
+
+        UploadRequest indices;
+        indices.object = b.EBO;
+        indices.offset = indexOffset;
+        indices.data = indexData;
+        indices.size = indexBytes;
+        indices.keepAlive = std::move(keepAlive);
+        indices.staging = stagedIndices;
+        allocation.indexUpload = UploadQueue::GetInstance().Submit(std::move(indices));
+
+        allocation.format = format;
+        allocation.baseVertex = baseVertex;
+        allocation.vertexCount = vertexCount;
+        allocation.indexByteOffset = indexOffset;
+        allocation.indexByteSize = alignedIndexBytes;
+
+        return allocation;
+    }
+
+    bool GeometryArena::IsUploaded(const GeometryAllocation &allocation) const
+    {
+        UploadQueue& uploads = UploadQueue::GetInstance();
+        return uploads.IsComplete(allocation.vertexUpload) && uploads.IsComplete(allocation.indexUpload);
+    }
+
+    void GeometryArena::Free(const GeometryAllocation &allocation)
+    {
+        if (!initialized || !allocation.IsValid())
+            return;
+
+        Buffers& b = buffers[static_cast<int>(allocation.format)];
+        FreeRange(b.freeVertices, allocation.baseVertex, allocation.vertexCount);
+        FreeRange(b.freeIndices, allocation.indexByteOffset, allocation.indexByteSize);
+    }
+
+    size_t GeometryArena::GetUsedBytes() const
+    {
+        size_t used = 0;
+        for (const Buffers& b : buffers) {
+            size_t freeVertices = 0;
+            for (const Range& r : b.freeVertices)
+                freeVertices += r.size;
+
+            size_t freeIndices = 0;
+            for (const Range& r : b.freeIndices)
+                freeIndices += r.size;
+
+            used += (b.vertexCapacity - freeVertices) * b.vertexStride + (b.indexCapacity - freeIndices);
+        }
+        return used;
+    }
+
+    size_t GeometryArena::GetCapacityBytes() const
+    {
+        size_t capacity = 0;
+        for (const Buffers& b : buffers)
+            capacity += b.vertexCapacity * b.vertexStride + b.indexCapacity;
+        return capacity;
+    }
+}
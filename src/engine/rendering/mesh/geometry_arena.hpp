@@ -0,0 +1,88 @@
+#pragma once
+
+#include "engine/rendering/utils.hpp"
+#include "engine/rendering/upload/upload_queue.hpp"
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+namespace Epoch::Engine::Rendering{
+
+    // Location of a mesh inside the arena, submeshes are drawn with glDrawElementsBaseVertex
+    struct GeometryAllocation {
+        VertexFormat format = VertexFormat::Full;
+        size_t baseVertex = 0;          // First vertex of the allocation (in vertices)
+        size_t vertexCount = 0;
+        size_t indexByteOffset = 0;     // Offset of the first index in the shared EBO (4 bytes aligned)
+        size_t indexByteSize = 0;
+        uint64_t vertexUpload = 0;      // Upload queue tickets, the allocation can't be drawn before they complete
+        uint64_t indexUpload = 0;
+
+        bool IsValid() const { return vertexCount > 0; }
+    };
+
+    // Shared, growable vertex/index storage with one VAO per vertex format
+    class GeometryArena{
+        public:
+            static GeometryArena& GetInstance() {
+                static GeometryArena instance;
+                return instance;
+            }
+
+            void Init();
+            void Shutdown();
+
+            GeometryAllocation Allocate(VertexFormat format, const void* vertexData, size_t vertexCount, const void* indexData, size_t indexBytes, std::shared_ptr<const void> keepAlive,
+                                        const StagingAllocation& stagedVertices = {}, const StagingAllocation& stagedIndices = {});
+            void Free(const GeometryAllocation& allocation);
+
+            /// @brief Whether the copies of an allocation were issued, draws read garbage before that
+            bool IsUploaded(const GeometryAllocation& allocation) const;
+
+            GLuint GetVAO(VertexFormat format) const { return buffers[static_cast<int>(format)].VAO; }
+
+            size_t GetVertexStride(VertexFormat format) const { return buffers[static_cast<int>(format)].vertexStride; }
+
+            /// @brief Makes sure the per-instance draw ID stream (attribute 5) covers "count" draws
+            void ReserveDrawIDs(size_t count);
+
+            size_t GetUsedBytes() const;
+            size_t GetCapacityBytes() const;
+
+        private:
+            GeometryArena() = default;
+            ~GeometryArena() = default;
+            GeometryArena(const GeometryArena&) = delete;
+            GeometryArena& operator=(const GeometryArena&) = delete;
+
+            struct Range {
+                size_t offset;
+                size_t size;
+            };
+
+            struct Buffers {
+                GLuint VAO = 0, VBO = 0, EBO = 0;
+                VertexFormat format = VertexFormat::Full;
+                size_t vertexStride = 0;
+                size_t vertexCapacity = 0;      // In vertices
+                size_t indexCapacity = 0;       // In bytes
+                std::vector<Range> freeVertices;
+                std::vector<Range> freeIndices;
+            };
+
+            void SetupVertexLayout(Buffers& b);
+            void GrowVertices(Buffers& b, size_t minFreeVertices);
+            void GrowIndices(Buffers& b, size_t minFreeBytes);
+
+            static bool AllocateRange(std::vector<Range>& freeList, size_t size, size_t& offset);
+            static void FreeRange(std::vector<Range>& freeList, size_t offset, size_t size);
+
+            Buffers buffers[2];
+            bool initialized = false;
+
+            // 0, 1, 2... read with a divisor of 1, so the base instance of an indirect draw becomes its draw ID
+            GLuint drawIDBuffer = 0;
+            size_t drawIDCapacity = 0;
+    };
+}
@@ -1,21 +1,27 @@
 #include "mesh.hpp"
 
 #include "engine/rendering/renderer/renderer.hpp"
+#include "engine/rendering/mesh/mesh_optimizer.hpp"
+#include "engine/rendering/mesh/geometry_arena.hpp"
+
+#include <glm/gtc/packing.hpp>
 
 #include <iostream>
+#include <cmath>
+#include <cstring>
 
 namespace Epoch::Engine::Rendering{
     
-    Mesh::Mesh(const ufbx_mesh* ufbx_mesh, double scene_unit_meters, ufbx_material_list& ufbx_mats, COL_RGBA diffuse)
+    Mesh::Mesh(const ufbx_mesh* ufbx_mesh, double scene_unit_meters, ufbx_material_list& ufbx_mats, COL_RGBA diffuse, MeshImportSettings settings)
     {
-        LoadMesh(ufbx_mesh, scene_unit_meters, ufbx_mats, diffuse);
+        if (LoadMesh(ufbx_mesh, scene_unit_meters, ufbx_mats, diffuse, settings) && !settings.deferUpload)
+            Upload();
     }
 
     Mesh::~Mesh()
     {
-        glDeleteVertexArrays(1, &VAO);
-        glDeleteBuffers(1, &VBO);
-        glDeleteBuffers(1, &EBO);
+        GeometryArena::GetInstance().Free(allocation);
+        ReleaseStaging();
     }
 
     void ComputeTangents(std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices)
@@ -63,7 +69,67 @@ namespace Epoch::Engine::Rendering{
         }
     }
 
-    bool Mesh::LoadMesh(const ufbx_mesh* ufbx_mesh, double scene_unit_meters, ufbx_material_list& ufbx_mats, COL_RGBA diffuse)
+    int16_t PackSnorm16(float value)
+    {
+        return static_cast<int16_t>(std::round(glm::clamp(value, -1.0f, 1.0f) * 32767.0f));
+    }
+
+    /// @brief Encodes a unit vector with the octahedral mapping (Cigolle et al. 2014)
+    /// @return The two snorm16 components, decoded in the vertex shaders
+    void PackOctahedral(const glm::vec3& v, int16_t out[2])
+    {
+        float l1 = std::abs(v.x) + std::abs(v.y) + std::abs(v.z);
+        if (!(l1 > 0.0f) || !std::isfinite(l1)) {
+            out[0] = 0;
+            out[1] = 0;
+            return;
+        }
+
+        glm::vec2 p = glm::vec2(v.x, v.y) / l1;
+        if (v.z < 0.0f) {
+            glm::vec2 folded = (1.0f - glm::abs(glm::vec2(p.y, p.x)));
+            p.x = folded.x * (p.x >= 0.0f ? 1.0f : -1.0f);
+            p.y = folded.y * (p.y >= 0.0f ? 1.0f : -1.0f);
+        }
+
+        out[0] = PackSnorm16(p.x);
+        out[1] = PackSnorm16(p.y);
+    }
+
+    /// @brief Quantizes full vertices into the compact layout
+    /// @param boundsMin The minimum corner of the mesh bounds
+    /// @param boundsMax The maximum corner of the mesh bounds
+    std::vector<CompactVertex> PackCompactVertices(const std::vector<Vertex>& vertices, const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+    {
+        std::vector<CompactVertex> compact(vertices.size());
+
+        glm::vec3 size = boundsMax - boundsMin;
+        glm::vec3 invSize = glm::vec3(
+            size.x > 0.0f ? 1.0f / size.x : 0.0f,
+            size.y > 0.0f ? 1.0f / size.y : 0.0f,
+            size.z > 0.0f ? 1.0f / size.z : 0.0f);
+
+        for (size_t i = 0; i < vertices.size(); i++) {
+            const Vertex& v = vertices[i];
+            CompactVertex& c = compact[i];
+
+            glm::vec3 normalized = glm::clamp((v.position - boundsMin) * invSize, 0.0f, 1.0f);
+            c.position[0] = static_cast<uint16_t>(std::round(normalized.x * 65535.0f));
+            c.position[1] = static_cast<uint16_t>(std::round(normalized.y * 65535.0f));
+            c.position[2] = static_cast<uint16_t>(std::round(normalized.z * 65535.0f));
+            c.position[3] = 0;
+
+            PackOctahedral(v.normal, c.normal);
+            PackOctahedral(v.tangent, c.tangent);
+
+            c.texCoord[0] = glm::packHalf1x16(v.texCoord.x);
+            c.texCoord[1] = glm::packHalf1x16(v.texCoord.y);
+        }
+
+        return compact;
+    }
+
+    bool Mesh::LoadMesh(const ufbx_mesh* ufbx_mesh, double scene_unit_meters, ufbx_material_list& ufbx_mats, COL_RGBA diffuse, MeshImportSettings settings)
     {
         
         double scene_scale = scene_unit_meters;
@@ -155,15 +221,42 @@ namespace Epoch::Engine::Rendering{
         }
 
         // Merge all material groups into one VBO/EBO
-        vertices.clear();
-        indices.clear();
+        std::vector<Vertex> vertices;
+        std::vector<GLuint> indices;
         submeshes.clear();
 
         for (ufbx_material* mat : materialOrder) {
             auto& group = materialGroups[mat];
+
+            // Reorder for vertex cache, overdraw and vertex fetch before anything is uploaded
+            MeshOptimizer::OptimizationStats stats;
+            MeshOptimizer::Optimize(group.verts, group.localIndices, &stats);
+            DEBUG_LOG("Optimized submesh " + std::to_string(submeshes.size()) + " (" + std::to_string(group.localIndices.size() / 3) + " triangles, "
+                + std::to_string(stats.clusterCount) + " clusters) : ACMR " + std::to_string(stats.acmrBefore) + " -> " + std::to_string(stats.acmrAfter)
+                + ", ATVR " + std::to_string(stats.atvrBefore) + " -> " + std::to_string(stats.atvrAfter));
+
             size_t indexOffset = indices.size();
             size_t indexCount = group.localIndices.size();
 
+            // Clusters follow the optimized triangle order, so they are contiguous index ranges
+            size_t meshletOffset = meshlets ? meshlets->size() : 0;
+            size_t meshletCount = 0;
+
+            if (settings.buildMeshlets && indexCount / 3 >= settings.meshletMinTriangles) {
+                std::vector<Meshlet> groupMeshlets = MeshOptimizer::BuildMeshlets(group.verts, group.localIndices);
+
+                if (!meshlets)
+                    meshlets = std::make_shared<std::vector<Meshlet>>();
+
+                for (Meshlet& meshlet : groupMeshlets) {
+                    meshlet.indexOffset += static_cast<uint32_t>(indexOffset);
+                    meshlets->push_back(meshlet);
+                }
+
+                meshletCount = groupMeshlets.size();
+                DEBUG_LOG("Split submesh " + std::to_string(submeshes.size()) + " into " + std::to_string(meshletCount) + " meshlets");
+            }
+
             size_t vertexOffset = vertices.size();
             vertices.insert(vertices.end(), group.verts.begin(), group.verts.end());
 
@@ -172,7 +265,11 @@ namespace Epoch::Engine::Rendering{
 
             submeshes.push_back(SubMesh{
                 .indexOffset = indexOffset,
-                .indexCount = indexCount
+                .indexCount = indexCount,
+                .materialSlot = mat ? static_cast<int>(mat->typed_id) : 0,
+                .lods = {},
+                .meshletOffset = meshletOffset,
+                .meshletCount = meshletCount
             });
         }
 
@@ -180,44 +277,247 @@ namespace Epoch::Engine::Rendering{
 
         ComputeTangents(vertices, indices);
 
-        glGenVertexArrays(1, &VAO);
-        glGenBuffers(1, &VBO);
-        glGenBuffers(1, &EBO);
+        if (!vertices.empty()) {
+            boundsMin = vertices[0].position;
+            boundsMax = vertices[0].position;
+        }
 
-        glBindVertexArray(VAO);
+        for (const Vertex& v : vertices) {
+            boundsMin = glm::min(boundsMin, v.position);
+            boundsMax = glm::max(boundsMax, v.position);
+        }
+
+        for (SubMesh& submesh : submeshes) {
+            submesh.lods[0] = MeshLod{ .indexOffset = submesh.indexOffset, .indexCount = submesh.indexCount, .error = 0.0f };
+            submesh.lodCount = 1;
+        }
 
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_STATIC_DRAW);
+        if (settings.generateLods)
+            GenerateLods(vertices, indices, settings.maxLodError * glm::length(boundsMax - boundsMin) * 0.5f);
 
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+        color = diffuse;
+        vertexFormat = settings.compactVertices ? VertexFormat::Compact : VertexFormat::Full;
+        indexType = (vertexFormat == VertexFormat::Compact && vertices.size() <= 65536) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
 
-        // layout: 0 - position, 1 - normal, 2 - color, 3 - texCoord, 4 - tangent 
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-        glEnableVertexAttribArray(0);
+        // Indices stay local to the mesh, the arena offsets them with the base vertex
+        auto assignBytes = [](std::vector<uint8_t>& bytes, const void* data, size_t size) {
+            bytes.assign(static_cast<const uint8_t*>(data), static_cast<const uint8_t*>(data) + size);
+        };
 
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal));
-        glEnableVertexAttribArray(1);
+        if (vertexFormat == VertexFormat::Compact) {
+            std::vector<CompactVertex> compactVertices = PackCompactVertices(vertices, boundsMin, boundsMax);
+            assignBytes(pendingVertices, compactVertices.data(), compactVertices.size() * sizeof(CompactVertex));
+        }
+        else {
+            assignBytes(pendingVertices, vertices.data(), vertices.size() * sizeof(Vertex));
+        }
 
-        glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, color));
-        glEnableVertexAttribArray(2);
+        if (indexType == GL_UNSIGNED_SHORT) {
+            std::vector<uint16_t> shortIndices(indices.begin(), indices.end());
+            assignBytes(pendingIndices, shortIndices.data(), shortIndices.size() * sizeof(uint16_t));
+        }
+        else {
+            assignBytes(pendingIndices, indices.data(), indices.size() * sizeof(uint32_t));
+        }
 
-        glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, texCoord));
-        glEnableVertexAttribArray(3);
+        pendingVertexCount = vertices.size();
 
-        glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, tangent));
-        glEnableVertexAttribArray(4);
+        if (settings.deferUpload)
+            StageGeometry();
 
-        glBindVertexArray(0);
+        if (vertexFormat == VertexFormat::Compact) {
+            size_t fullBytes = vertices.size() * sizeof(Vertex) + indices.size() * sizeof(uint32_t);
+            size_t compactBytes = pendingVertices.size() + pendingIndices.size();
+            DEBUG_LOG("Compact mesh (" + std::to_string(vertices.size()) + " vertices, " + std::to_string(indices.size()) + " indices) : "
+                + std::to_string(fullBytes) + " -> " + std::to_string(compactBytes) + " bytes, saved "
+                + std::to_string(fullBytes - compactBytes) + " bytes");
+        }
 
         return true;
     }
     
-    void Mesh::DrawWithoutMaterial() const {
-        glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(totalIndexCount), GL_UNSIGNED_INT, 0);
+    /// @brief Writes the packed geometry into the upload ring from the importing worker, so the GL thread only issues its copy.
+    /// The geometry stays in the pending buffers when the ring has no room
+    void Mesh::StageGeometry()
+    {
+        UploadQueue& uploads = UploadQueue::GetInstance();
+
+        StagingAllocation vertexRegion = uploads.Reserve(pendingVertices.size());
+        StagingAllocation indexRegion = vertexRegion.IsValid() ? uploads.Reserve(pendingIndices.size()) : StagingAllocation();
+        if (!indexRegion.IsValid()) {
+            uploads.Release(vertexRegion);
+            return;
+        }
+
+        std::memcpy(vertexRegion.data, pendingVertices.data(), pendingVertices.size());
+        std::memcpy(indexRegion.data, pendingIndices.data(), pendingIndices.size());
+
+        stagedVertices = vertexRegion;
+        stagedIndices = indexRegion;
+        pendingVertices = std::vector<uint8_t>();
+        pendingIndices = std::vector<uint8_t>();
+    }
+
+    void Mesh::ReleaseStaging()
+    {
+        UploadQueue::GetInstance().Release(stagedVertices);
+        UploadQueue::GetInstance().Release(stagedIndices);
+        stagedVertices = stagedIndices = StagingAllocation();
+    }
+
+    /// @brief Moves the packed geometry into the geometry arena, must be called from the GL thread
+    /// @return False if the arena allocation failed
+    bool Mesh::Upload()
+    {
+        if (allocation.IsValid())
+            return true;
+
+        if (stagedVertices.IsValid()) {
+            allocation = GeometryArena::GetInstance().Allocate(vertexFormat, nullptr, pendingVertexCount, nullptr, stagedIndices.size, nullptr, stagedVertices, stagedIndices);
+            if (!allocation.IsValid()) {
+                DEBUG_ERROR("Failed to allocate mesh geometry (" + std::to_string(pendingVertexCount) + " vertices, " + std::to_string(stagedIndices.size / GetIndexSize()) + " indices)");
+                return false;
+            }
+
+            // Submitted, the upload queue gives the regions back
+            stagedVertices = stagedIndices = StagingAllocation();
+            pendingVertexCount = 0;
+            return true;
+        }
+
+        // The upload queue copies the geometry later, it owns the bytes until then
+        auto geometry = std::make_shared<std::pair<std::vector<uint8_t>, std::vector<uint8_t>>>(std::move(pendingVertices), std::move(pendingIndices));
+
+        allocation = GeometryArena::GetInstance().Allocate(vertexFormat, geometry->first.data(), pendingVertexCount, geometry->second.data(), geometry->second.size(), geometry);
+
+        if (!allocation.IsValid()) {
+            pendingVertices = std::move(geometry->first);
+            pendingIndices = std::move(geometry->second);
+            DEBUG_ERROR("Failed to allocate mesh geometry (" + std::to_string(pendingVertexCount) + " vertices, " + std::to_string(pendingIndices.size() / GetIndexSize()) + " indices)");
+            return false;
+        }
+
+        pendingVertexCount = 0;
+
+        return true;
+    }
+
+    /// @brief Takes the geometry of another mesh so the components and models holding this one draw the new geometry
+    /// once they resubmit their commands. "other" is left without arena allocation
+    void Mesh::Replace(Mesh &other)
+    {
+        GeometryArena::GetInstance().Free(allocation);
+        ReleaseStaging();
+        *this = other;
+        other.allocation = GeometryAllocation();
+        other.stagedVertices = other.stagedIndices = StagingAllocation();
+    }
+
+    /// @brief Arena space of the geometry, or its CPU copy while waiting for Upload, plus the meshlets
+    size_t Mesh::GetMemoryBytes() const
+    {
+        size_t bytes = pendingVertices.size() + pendingIndices.size();
+        if (allocation.IsValid())
+            bytes += allocation.vertexCount * GeometryArena::GetInstance().GetVertexStride(allocation.format) + allocation.indexByteSize;
+        if (meshlets)
+            bytes += meshlets->size() * sizeof(Meshlet);
+        return bytes;
+    }
+
+    /// @brief Builds the LOD chain of every submesh, the simplified ranges are appended to "indices"
+    /// @param maxError The maximum surface deviation of the coarsest LOD, in mesh units
+    void Mesh::GenerateLods(const std::vector<Vertex> &vertices, std::vector<GLuint> &indices, float maxError)
+    {
+        lodCount = 1;
+
+        for (SubMesh& submesh : submeshes) {
+            std::vector<uint32_t> source(indices.begin() + submesh.indexOffset, indices.begin() + submesh.indexOffset + submesh.indexCount);
+            std::vector<uint32_t> simplified;
+            std::vector<uint32_t> clusters;
+
+            size_t previousCount = submesh.indexCount;
+
+            for (int lod = 1; lod < MAX_MESH_LODS; lod++) {
+                size_t target = (submesh.indexCount >> lod) / 3 * 3;
+                if (target < 3)
+                    break;
+
+                float error = MeshOptimizer::Simplify(vertices, source, simplified, target, maxError);
+
+                // Stop when the simplification is blocked by the error limit or the locked vertices
+                if (simplified.empty() || simplified.size() > previousCount * 9 / 10)
+                    break;
+
+                MeshOptimizer::OptimizeVertexCache(simplified, vertices.size(), clusters);
+
+                submesh.lods[lod] = MeshLod{ .indexOffset = indices.size(), .indexCount = simplified.size(), .error = error };
+                submesh.lodCount = lod + 1;
+                indices.insert(indices.end(), simplified.begin(), simplified.end());
+
+                previousCount = simplified.size();
+            }
+
+            lodCount = std::max(lodCount, submesh.lodCount);
+
+            std::string chain = std::to_string(submesh.lods[0].indexCount / 3);
+            for (int lod = 1; lod < submesh.lodCount; lod++)
+                chain += " -> " + std::to_string(submesh.lods[lod].indexCount / 3) + " (error " + std::to_string(submesh.lods[lod].error) + ")";
+            DEBUG_LOG("Submesh LODs (triangles) : " + chain);
+        }
+
+        // A submesh with a shorter chain keeps drawing its coarsest LOD
+        for (int lod = 0; lod < lodCount; lod++) {
+            lodErrors[lod].error = 0.0f;
+            for (const SubMesh& submesh : submeshes)
+                lodErrors[lod].error = std::max(lodErrors[lod].error, submesh.lods[std::min(lod, submesh.lodCount - 1)].error);
+        }
+    }
+
+    /// @brief Picks a LOD from the projected error of the mesh
+    /// @param model The transform of the mesh
+    /// @param viewPosition The position of the camera
+    /// @param lodScale The value returned by ComputeLodScale for the view
+    /// @param threshold The maximum projected error, in pixels
+    /// @param hysteresis Fraction of the threshold the error must cross before leaving "currentLod"
+    /// @param currentLod The LOD this mesh was drawn with on the previous frame
+    int Mesh::SelectLod(const glm::mat4 &model, const glm::vec3 &viewPosition, float lodScale, float threshold, float hysteresis, int currentLod) const
+    {
+        if (lodCount <= 1)
+            return 0;
+
+        float scale = glm::max(glm::length(glm::vec3(model[0])), glm::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+        glm::vec3 center = glm::vec3(model * glm::vec4(GetBoundsCenter(), 1.0f));
+        float distance = glm::length(center - viewPosition) - GetBoundingRadius() * scale;
+
+        return Rendering::SelectLod(lodErrors, lodCount, scale, distance, lodScale, threshold, hysteresis, currentLod);
+    }
+
+    void Mesh::DrawWithoutMaterial(int lod) const {
+        if (!allocation.IsValid() || !GeometryArena::GetInstance().IsUploaded(allocation))
+            return;
+
+        glBindVertexArray(GeometryArena::GetInstance().GetVAO(vertexFormat));
+
+        if (lod <= 0 || lodCount <= 1) {
+            glDrawElementsBaseVertex(GL_TRIANGLES, static_cast<GLsizei>(totalIndexCount), indexType, (void*)allocation.indexByteOffset, static_cast<GLint>(allocation.baseVertex));
+        }
+        else {
+            for (const SubMesh& submesh : submeshes) {
+                const MeshLod& range = submesh.lods[std::min(lod, submesh.lodCount - 1)];
+                glDrawElementsBaseVertex(GL_TRIANGLES, static_cast<GLsizei>(range.indexCount), indexType,
+                    (void*)(allocation.indexByteOffset + range.indexOffset * GetIndexSize()), static_cast<GLint>(allocation.baseVertex));
+            }
+        }
+
         glBindVertexArray(0);
     }
+
+    void Mesh::SetPositionUniforms(const Shader &shader) const
+    {
+        shader.setVec3("posScale", GetPositionScale());
+        shader.setVec3("posOffset", GetPositionOffset());
+    }
+
     std::vector<DrawCommand> Mesh::CreateDrawCmds(std::shared_ptr<ECS::Components::Transform> tr, int objectID, std::vector<std::shared_ptr<Material>> mats)
     {
         std::vector<DrawCommand> cmds;
@@ -229,31 +529,37 @@ namespace Epoch::Engine::Rendering{
         for (int i = 0; i < submeshes.size(); i++) {
 
             DrawCommand cmd;
-            cmd.indexOffset = static_cast<int>(submeshes[i].indexOffset);
+            cmd.indexOffset = static_cast<int>(allocation.indexByteOffset / GetIndexSize() + submeshes[i].indexOffset);
             cmd.indexCount  = static_cast<int>(submeshes[i].indexCount);
-            cmd.VAO         = VAO;
-            cmd.VBO         = VBO;
+            cmd.baseVertex  = static_cast<int>(allocation.baseVertex);
+            cmd.geometryUploads[0] = allocation.vertexUpload;
+            cmd.geometryUploads[1] = allocation.indexUpload;
+            cmd.VAO         = GeometryArena::GetInstance().GetVAO(vertexFormat);
             cmd.mat         = mats[i];
             cmd.tr          = tr;
             cmd.id          = objectID;
             cmd.fillMode    = GL_FILL;
-
-
-            glm::vec3 maxVec = glm::vec3(0);
-            glm::vec3 minVec = glm::vec3(0);
-
-            if(!vertices.empty()){
-                maxVec = vertices[0].position;
-                minVec = vertices[0].position;
-            }
-            
-            for (size_t i = 1; i < vertices.size(); ++i){
-                maxVec = glm::max(maxVec, vertices[i].position);
-                minVec = glm::min(minVec, vertices[i].position);
+            cmd.indexType   = indexType;
+            cmd.vertexFormat = vertexFormat;
+            cmd.positionScale = GetPositionScale();
+            cmd.positionOffset = GetPositionOffset();
+            cmd.color       = color;
+            cmd.boundsMax   = boundsMax;
+            cmd.boundsMin   = boundsMin;
+
+            size_t firstIndex = allocation.indexByteOffset / GetIndexSize();
+            cmd.lodCount    = submeshes[i].lodCount;
+            for (int lod = 0; lod < submeshes[i].lodCount; lod++) {
+                cmd.lods[lod] = submeshes[i].lods[lod];
+                cmd.lods[lod].indexOffset += firstIndex;
             }
 
-            cmd.boundsMax = maxVec;
-            cmd.boundsMin = minVec;
+            if (submeshes[i].meshletCount > 0) {
+                cmd.meshlets = meshlets;
+                cmd.meshletOffset = static_cast<int>(submeshes[i].meshletOffset);
+                cmd.meshletCount = static_cast<int>(submeshes[i].meshletCount);
+                cmd.meshletIndexBase = firstIndex;
+            }
 
             cmds.push_back(std::move(cmd));
         }
@@ -3,6 +3,9 @@
 #include "engine/ecs/components/core/transform.hpp"
 #include "engine/filesystem/filesystem.hpp"
 #include "engine/rendering/material/material.hpp"
+#include "engine/rendering/mesh/geometry_arena.hpp"
+#include "engine/rendering/mesh/mesh_lod.hpp"
+#include "engine/rendering/mesh/meshlet.hpp"
 
 #include <ufbx/ufbx.h>
 
@@ -11,29 +14,100 @@ namespace Epoch::Engine::Rendering{
     struct SubMesh {
         size_t indexOffset;
         size_t indexCount;
+        int materialSlot = 0;   // Index of the material in the source scene
+        MeshLod lods[MAX_MESH_LODS];    // lods[0] is the full resolution range
+        int lodCount = 1;
+        size_t meshletOffset = 0;       // Range in Mesh::meshlets, covering lods[0]
+        size_t meshletCount = 0;
+    };
+
+    struct MeshImportSettings {
+        bool compactVertices = false;   // Quantized 20 bytes vertices (see CompactVertex) and 16-bit indices when possible
+        bool generateLods = true;       // Simplified index ranges sharing the LOD 0 vertices
+        float maxLodError = 0.05f;      // Maximum LOD error, relative to the mesh bounding radius
+        bool buildMeshlets = true;      // Per cluster frustum and backface culling of large submeshes
+        size_t meshletMinTriangles = 4096;  // Smaller submeshes are only culled as a whole
+        bool deferUpload = false;       // Keep the geometry on the CPU until Upload is called from the GL thread (worker thread imports)
     };
 
     class Mesh {
         public:
-            Mesh(const ufbx_mesh *ufbx_mesh, double scene_unit_meters, ufbx_material_list& ufbx_mats, COL_RGBA diffuse = COL_RGBA(0.99f,0.06f,0.75f,1.0f));
+            Mesh(const ufbx_mesh *ufbx_mesh, double scene_unit_meters, ufbx_material_list& ufbx_mats, COL_RGBA diffuse = COL_RGBA(0.99f,0.06f,0.75f,1.0f), MeshImportSettings settings = {});
             ~Mesh();
 
-            void DrawWithoutMaterial() const;
+            bool Upload();
+
+            bool IsUploaded() const { return allocation.IsValid(); }
+
+            void Replace(Mesh& other);
+
+            void DrawWithoutMaterial(int lod = 0) const;
 
             std::vector<DrawCommand> CreateDrawCmds(std::shared_ptr<ECS::Components::Transform> tr, int objectID, std::vector<std::shared_ptr<Material>> mats);
 
             int SubMeshesCount() const { return submeshes.size(); }
 
+            VertexFormat GetVertexFormat() const { return vertexFormat; }
+
+            GLenum GetIndexType() const { return indexType; }
+
+            size_t GetIndexSize() const { return indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t); }
+
+            int GetSubMeshMaterialSlot(int index) const { return submeshes[index].materialSlot; }
+
+            const GeometryAllocation& GetAllocation() const { return allocation; }
+
+            /// @brief Scale applied to the decoded positions (the bounds size for compact meshes)
+            glm::vec3 GetPositionScale() const { return vertexFormat == VertexFormat::Compact ? boundsMax - boundsMin : glm::vec3(1.0f); }
+
+            /// @brief Offset applied to the decoded positions (the bounds minimum for compact meshes)
+            glm::vec3 GetPositionOffset() const { return vertexFormat == VertexFormat::Compact ? boundsMin : glm::vec3(0.0f); }
+
+            int GetLodCount() const { return lodCount; }
+
+            glm::vec3 GetBoundsCenter() const { return (boundsMin + boundsMax) * 0.5f; }
+
+            float GetBoundingRadius() const { return glm::length(boundsMax - boundsMin) * 0.5f; }
+
+            size_t GetMeshletCount() const { return meshlets ? meshlets->size() : 0; }
+
+            size_t GetMemoryBytes() const;
+
+            int SelectLod(const glm::mat4& model, const glm::vec3& viewPosition, float lodScale, float threshold, float hysteresis, int currentLod) const;
+
+            /// @brief Sets the position dequantization uniforms of a shader that draws this mesh without its material
+            void SetPositionUniforms(const Shader& shader) const;
+
             int materialsSlots;
 
         private:
-            GLuint VAO, VBO, EBO;
+            GeometryAllocation allocation;
             size_t totalIndexCount;
-            std::vector<Vertex> vertices;
-            std::vector<GLuint> indices;
             std::vector<SubMesh> submeshes;
 
-            bool LoadMesh(const ufbx_mesh *ufbx_mesh, double scene_unit_meters, ufbx_material_list& ufbx_mats, COL_RGBA diffuse);
+            VertexFormat vertexFormat = VertexFormat::Full;
+            GLenum indexType = GL_UNSIGNED_INT;
+            glm::vec3 boundsMin = glm::vec3(0);
+            glm::vec3 boundsMax = glm::vec3(0);
+            COL_RGBA color;
+
+            int lodCount = 1;
+            MeshLod lodErrors[MAX_MESH_LODS];   // Worst error of all the submeshes, per LOD
+
+            std::shared_ptr<std::vector<Meshlet>> meshlets;     // Shared with the draw commands, null when no submesh was split
+
+            // Packed geometry waiting for Upload, in the upload ring when the importing worker could reserve it
+            std::vector<uint8_t> pendingVertices;
+            std::vector<uint8_t> pendingIndices;
+            StagingAllocation stagedVertices;
+            StagingAllocation stagedIndices;
+            size_t pendingVertexCount = 0;
+
+            void StageGeometry();
+            void ReleaseStaging();
+
+            bool LoadMesh(const ufbx_mesh *ufbx_mesh, double scene_unit_meters, ufbx_material_list& ufbx_mats, COL_RGBA diffuse, MeshImportSettings settings);
+            void GenerateLods(const std::vector<Vertex>& vertices, std::vector<GLuint>& indices, float maxError);
 
     };
     
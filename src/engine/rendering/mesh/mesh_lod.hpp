@@ -0,0 +1,56 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+
+namespace Epoch::Engine::Rendering{
+
+    constexpr int MAX_MESH_LODS = 4;
+
+    struct MeshLod {
+        size_t indexOffset = 0;
+        size_t indexCount = 0;
+        float error = 0.0f;     // Maximum surface deviation from LOD 0, in mesh units
+    };
+
+    /// @brief Converts a world space distance seen at 1 unit from the camera into pixels
+    inline float ComputeLodScale(float fovDegrees, float screenHeight)
+    {
+        return screenHeight / (2.0f * glm::tan(glm::radians(fovDegrees) * 0.5f));
+    }
+
+    /// @brief Picks the coarsest LOD whose projected error stays under the pixel threshold
+    /// @param lods The LOD chain, from the finest to the coarsest
+    /// @param lodCount The number of LODs in the chain
+    /// @param errorScale The world scale applied to the mesh errors
+    /// @param distance The distance from the camera to the mesh bounds
+    /// @param lodScale The value returned by ComputeLodScale
+    /// @param threshold The maximum projected error, in pixels
+    /// @param hysteresis Fraction of the threshold the error must cross before leaving "currentLod"
+    /// @param currentLod The LOD used on the previous frame
+    inline int SelectLod(const MeshLod* lods, int lodCount, float errorScale, float distance, float lodScale, float threshold, float hysteresis, int currentLod)
+    {
+        if (lodCount <= 1)
+            return 0;
+
+        float pixelsPerUnit = errorScale * lodScale / glm::max(distance, 1e-3f);
+
+        int lod = 0;
+        for (int i = 1; i < lodCount; i++) {
+            if (lods[i].error * pixelsPerUnit > threshold)
+                break;
+            lod = i;
+        }
+
+        currentLod = glm::clamp(currentLod, 0, lodCount - 1);
+
+        // Going coarser needs the new error well under the threshold, going finer needs the current one well over it
+        if (lod > currentLod && lods[lod].error * pixelsPerUnit > threshold * (1.0f - hysteresis))
+            return currentLod;
+        if (lod < currentLod && lods[currentLod].error * pixelsPerUnit < threshold * (1.0f + hysteresis))
+            return currentLod;
+
+        return lod;
+    }
+}
@@ -0,0 +1,755 @@
+#include "mesh_optimizer.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <unordered_map>
+#include <cmath>
+#include <limits>
+
+namespace Epoch::Engine::Rendering::MeshOptimizer{
+
+    /// @brief Simulates a FIFO post-transform cache and counts the vertices that have to be transformed
+    size_t CountCacheMisses(const std::vector<uint32_t> &indices, size_t vertexCount, unsigned int cacheSize)
+    {
+        std::vector<size_t> cacheTime(vertexCount, 0);
+        size_t timestamp = cacheSize + 1;
+        size_t misses = 0;
+
+        for (uint32_t index : indices) {
+            if (index >= vertexCount)
+                continue;
+
+            if (timestamp - cacheTime[index] > cacheSize) {
+                cacheTime[index] = timestamp++;
+                misses++;
+            }
+        }
+
+        return misses;
+    }
+
+    /// @brief Computes the average cache miss ratio of an index buffer
+    /// @return The number of transformed vertices per triangle (0.5 is optimal, 3.0 is the worst case)
+    float ComputeACMR(const std::vector<uint32_t> &indices, size_t vertexCount, unsigned int cacheSize)
+    {
+        if (indices.size() < 3)
+            return 0.0f;
+
+        return static_cast<float>(CountCacheMisses(indices, vertexCount, cacheSize)) / static_cast<float>(indices.size() / 3);
+    }
+
+    /// @brief Computes the average transformed vertex ratio of an index buffer
+    /// @return The number of transformed vertices per referenced vertex (1.0 is optimal)
+    float ComputeATVR(const std::vector<uint32_t> &indices, size_t vertexCount, unsigned int cacheSize)
+    {
+        std::vector<bool> used(vertexCount, false);
+        size_t uniqueCount = 0;
+
+        for (uint32_t index : indices) {
+            if (index < vertexCount && !used[index]) {
+                used[index] = true;
+                uniqueCount++;
+            }
+        }
+
+        if (uniqueCount == 0)
+            return 0.0f;
+
+        return static_cast<float>(CountCacheMisses(indices, vertexCount, cacheSize)) / static_cast<float>(uniqueCount);
+    }
+
+    /// @brief Splits the clusters of a vertex cache optimized triangle list where the cache has warmed up again
+    /// @note Each cluster is simulated from an empty cache, as it may be drawn after any other one once reordered.
+    /// A split happens once the running ACMR is within "threshold" of the ACMR of the whole cluster,
+    /// so reordering the pieces costs little vertex cache efficiency
+    static void SplitClusters(const std::vector<uint32_t> &indices, size_t vertexCount, std::vector<uint32_t> &clusters, unsigned int cacheSize, float threshold)
+    {
+        const uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+
+        std::vector<size_t> cacheTime(vertexCount, 0);
+        size_t timestamp = cacheSize + 1;
+
+        // Counts the misses of a triangle, all the cache entries older than "flush" are empty
+        auto countMisses = [&](uint32_t t, size_t flush) {
+            size_t misses = 0;
+            for (int k = 0; k < 3; k++) {
+                uint32_t v = indices[t * 3 + k];
+                if (cacheTime[v] <= flush || timestamp - cacheTime[v] > cacheSize) {
+                    cacheTime[v] = timestamp++;
+                    misses++;
+                }
+            }
+            return misses;
+        };
+
+        std::vector<uint32_t> split;
+        split.reserve(clusters.size());
+
+        for (size_t c = 0; c < clusters.size(); c++) {
+            uint32_t begin = clusters[c];
+            uint32_t end = (c + 1 < clusters.size()) ? clusters[c + 1] : triangleCount;
+            if (begin >= end)
+                continue;
+
+            size_t flush = timestamp++;
+            size_t clusterMisses = 0;
+            for (uint32_t t = begin; t < end; t++)
+                clusterMisses += countMisses(t, flush);
+
+            const float limit = threshold * static_cast<float>(clusterMisses) / static_cast<float>(end - begin);
+
+            split.push_back(begin);
+            flush = timestamp++;
+            size_t misses = 0;
+
+            for (uint32_t t = begin; t < end; t++) {
+                misses += countMisses(t, flush);
+
+                uint32_t triangles = t + 1 - split.back();
+                if (t + 1 < end && static_cast<float>(misses) / static_cast<float>(triangles) <= limit) {
+                    split.push_back(t + 1);
+                    flush = timestamp++;
+                    misses = 0;
+                }
+            }
+        }
+
+        clusters = std::move(split);
+    }
+
+    /// @brief Reorders triangles for post-transform vertex cache locality (Tipsify, Sander et al. 2007)
+    /// @param indices The triangle list to reorder in place
+    /// @param vertexCount The number of vertices referenced by the index buffer
+    /// @param clusters Receives the first triangle of every cluster. A cluster starts at each dead end of the fan walk,
+    /// and is split again wherever its running ACMR falls to "threshold" times the ACMR of the whole cluster
+    /// @param cacheSize The size of the targeted vertex cache
+    /// @param threshold The lambda of Sander et al., lower values give fewer, more cache friendly clusters to OptimizeOverdraw
+    void OptimizeVertexCache(std::vector<uint32_t> &indices, size_t vertexCount, std::vector<uint32_t> &clusters, unsigned int cacheSize, float threshold)
+    {
+        clusters.clear();
+
+        const size_t triangleCount = indices.size() / 3;
+        if (triangleCount == 0 || vertexCount == 0)
+            return;
+
+        // Vertex -> triangles adjacency (compressed rows)
+        std::vector<uint32_t> liveTriangles(vertexCount, 0);
+        for (size_t i = 0; i < triangleCount * 3; i++)
+            liveTriangles[indices[i]]++;
+
+        std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+        for (size_t v = 0; v < vertexCount; v++)
+            adjacencyOffsets[v + 1] = adjacencyOffsets[v] + liveTriangles[v];
+
+        std::vector<uint32_t> adjacency(adjacencyOffsets[vertexCount]);
+        std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+        for (size_t t = 0; t < triangleCount; t++) {
+            for (int k = 0; k < 3; k++) {
+                uint32_t v = indices[t * 3 + k];
+                adjacency[fill[v]++] = static_cast<uint32_t>(t);
+            }
+        }
+
+        std::vector<size_t> cacheTime(vertexCount, 0);
+        std::vector<bool> emitted(triangleCount, false);
+        std::vector<uint32_t> deadEndStack;
+        std::vector<uint32_t> candidates;
+
+        std::vector<uint32_t> output;
+        output.reserve(triangleCount * 3);
+
+        size_t timestamp = cacheSize + 1;
+        size_t cursor = 1;
+        int64_t fanningVertex = indices[0];
+        bool startsCluster = true;
+
+        while (fanningVertex >= 0) {
+            candidates.clear();
+
+            for (uint32_t a = adjacencyOffsets[fanningVertex]; a < adjacencyOffsets[fanningVertex + 1]; a++) {
+                uint32_t t = adjacency[a];
+                if (emitted[t])
+                    continue;
+
+                if (startsCluster) {
+                    clusters.push_back(static_cast<uint32_t>(output.size() / 3));
+                    startsCluster = false;
+                }
+
+                for (int k = 0; k < 3; k++) {
+                    uint32_t v = indices[t * 3 + k];
+                    output.push_back(v);
+                    deadEndStack.push_back(v);
+                    candidates.push_back(v);
+                    liveTriangles[v]--;
+
+                    if (timestamp - cacheTime[v] > cacheSize)
+                        cacheTime[v] = timestamp++;
+                }
+                emitted[t] = true;
+            }
+
+            // Pick the candidate that stays in cache the longest while still having triangles to emit
+            int64_t best = -1;
+            int64_t bestPriority = -1;
+            for (uint32_t v : candidates) {
+                if (liveTriangles[v] == 0)
+                    continue;
+
+                int64_t priority = 0;
+                if (static_cast<int64_t>(timestamp - cacheTime[v]) + 2 * static_cast<int64_t>(liveTriangles[v]) <= static_cast<int64_t>(cacheSize))
+                    priority = static_cast<int64_t>(timestamp - cacheTime[v]);
+
+                if (priority > bestPriority) {
+                    bestPriority = priority;
+                    best = v;
+                }
+            }
+
+            if (best >= 0) {
+                fanningVertex = best;
+                continue;
+            }
+
+            // Dead end : fall back to recently used vertices, then to the next vertex in input order
+            startsCluster = true;
+            fanningVertex = -1;
+
+            while (!deadEndStack.empty()) {
+                uint32_t v = deadEndStack.back();
+                deadEndStack.pop_back();
+                if (liveTriangles[v] > 0) {
+                    fanningVertex = v;
+                    break;
+                }
+            }
+
+            if (fanningVertex < 0) {
+                while (cursor < vertexCount) {
+                    if (liveTriangles[cursor] > 0) {
+                        fanningVertex = static_cast<int64_t>(cursor);
+                        break;
+                    }
+                    cursor++;
+                }
+            }
+        }
+
+        // Degenerate leftovers (indices past the last full triangle) are dropped like the original draw would
+        indices = std::move(output);
+
+        SplitClusters(indices, vertexCount, clusters, cacheSize, threshold);
+    }
+
+    /// @brief Orders the clusters produced by OptimizeVertexCache so that outward facing clusters are drawn first
+    /// @note Fast approximation of Sander et al. : clusters are sorted by the dot product between their
+    /// average normal and their offset from the mesh centroid
+    void OptimizeOverdraw(std::vector<uint32_t> &indices, const std::vector<Vertex> &vertices, const std::vector<uint32_t> &clusters)
+    {
+        const size_t triangleCount = indices.size() / 3;
+        if (clusters.size() < 2 || triangleCount == 0)
+            return;
+
+        glm::vec3 meshCentroid(0.0f);
+        float meshArea = 0.0f;
+
+        struct ClusterInfo {
+            uint32_t begin;
+            uint32_t end;
+            glm::vec3 centroid;
+            glm::vec3 normal;
+            float sortKey;
+        };
+
+        std::vector<ClusterInfo> infos(clusters.size());
+
+        for (size_t c = 0; c < clusters.size(); c++) {
+            ClusterInfo &info = infos[c];
+            info.begin = clusters[c];
+            info.end = (c + 1 < clusters.size()) ? clusters[c + 1] : static_cast<uint32_t>(triangleCount);
+            info.centroid = glm::vec3(0.0f);
+            info.normal = glm::vec3(0.0f);
+
+            float clusterArea = 0.0f;
+
+            for (uint32_t t = info.begin; t < info.end; t++) {
+                const glm::vec3 &p0 = vertices[indices[t * 3 + 0]].position;
+                const glm::vec3 &p1 = vertices[indices[t * 3 + 1]].position;
+                const glm::vec3 &p2 = vertices[indices[t * 3 + 2]].position;
+
+                glm::vec3 faceNormal = glm::cross(p1 - p0, p2 - p0);
+                float area = glm::length(faceNormal);
+
+                info.centroid += (p0 + p1 + p2) * (area / 3.0f);
+                info.normal += faceNormal;
+                clusterArea += area;
+            }
+
+            meshCentroid += info.centroid;
+            meshArea += clusterArea;
+
+            if (clusterArea > 0.0f)
+                info.centroid /= clusterArea;
+        }
+
+        if (meshArea > 0.0f)
+            meshCentroid /= meshArea;
+
+        for (ClusterInfo &info : infos) {
+            float normalLength = glm::length(info.normal);
+            glm::vec3 n = normalLength > 0.0f ? info.normal / normalLength : glm::vec3(0.0f);
+            info.sortKey = glm::dot(info.centroid - meshCentroid, n);
+        }
+
+        std::stable_sort(infos.begin(), infos.end(), [](const ClusterInfo &a, const ClusterInfo &b) {
+            return a.sortKey > b.sortKey;
+        });
+
+        std::vector<uint32_t> output;
+        output.reserve(indices.size());
+
+        for (const ClusterInfo &info : infos)
+            output.insert(output.end(), indices.begin() + info.begin * 3, indices.begin() + info.end * 3);
+
+        indices = std::move(output);
+    }
+
+    /// @brief Reorders the vertex buffer in the order vertices are first referenced by the index buffer
+    /// @note Unreferenced vertices are removed
+    void OptimizeVertexFetch(std::vector<Vertex> &vertices, std::vector<uint32_t> &indices)
+    {
+        constexpr uint32_t UNASSIGNED = ~0u;
+
+        std::vector<uint32_t> remap(vertices.size(), UNASSIGNED);
+        std::vector<Vertex> output;
+        output.reserve(vertices.size());
+
+        for (uint32_t &index : indices) {
+            if (remap[index] == UNASSIGNED) {
+                remap[index] = static_cast<uint32_t>(output.size());
+                output.push_back(vertices[index]);
+            }
+            index = remap[index];
+        }
+
+        vertices = std::move(output);
+    }
+
+    /// @brief Runs the full import optimization (vertex cache, overdraw then vertex fetch) on a self-contained vertex/index range
+    /// @param vertices The vertices referenced by the range
+    /// @param indices The triangle list, local to "vertices"
+    /// @param stats Optional statistics output
+    void Optimize(std::vector<Vertex> &vertices, std::vector<uint32_t> &indices, OptimizationStats *stats)
+    {
+        if (stats) {
+            stats->acmrBefore = ComputeACMR(indices, vertices.size());
+            stats->atvrBefore = ComputeATVR(indices, vertices.size());
+        }
+
+        std::vector<uint32_t> clusters;
+        OptimizeVertexCache(indices, vertices.size(), clusters);
+        OptimizeOverdraw(indices, vertices, clusters);
+        OptimizeVertexFetch(vertices, indices);
+
+        if (stats) {
+            stats->acmrAfter = ComputeACMR(indices, vertices.size());
+            stats->atvrAfter = ComputeATVR(indices, vertices.size());
+            stats->clusterCount = clusters.size();
+        }
+    }
+
+    /// @brief Computes the bounding sphere and normal cone of a range of triangles
+    void ComputeMeshletBounds(Meshlet &meshlet, const std::vector<Vertex> &vertices, const std::vector<uint32_t> &indices)
+    {
+        glm::vec3 boundsMin(std::numeric_limits<float>::max());
+        glm::vec3 boundsMax(-std::numeric_limits<float>::max());
+
+        for (uint32_t i = meshlet.indexOffset; i < meshlet.indexOffset + meshlet.indexCount; i++) {
+            boundsMin = glm::min(boundsMin, vertices[indices[i]].position);
+            boundsMax = glm::max(boundsMax, vertices[indices[i]].position);
+        }
+
+        meshlet.center = (boundsMin + boundsMax) * 0.5f;
+        meshlet.radius = 0.0f;
+        for (uint32_t i = meshlet.indexOffset; i < meshlet.indexOffset + meshlet.indexCount; i++)
+            meshlet.radius = std::max(meshlet.radius, glm::length(vertices[indices[i]].position - meshlet.center));
+
+        std::vector<glm::vec3> normals;
+        glm::vec3 axis(0.0f);
+
+        for (uint32_t t = meshlet.indexOffset; t + 2 < meshlet.indexOffset + meshlet.indexCount; t += 3) {
+            const glm::vec3 &p0 = vertices[indices[t + 0]].position;
+            const glm::vec3 &p1 = vertices[indices[t + 1]].position;
+            const glm::vec3 &p2 = vertices[indices[t + 2]].position;
+
+            glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+            float length = glm::length(n);
+            if (length <= 0.0f)
+                continue;
+
+            normals.push_back(n / length);
+            axis += n / length;
+        }
+
+        float axisLength = glm::length(axis);
+        if (axisLength <= 1e-6f) {
+            meshlet.coneAxis = glm::vec3(0.0f);
+            meshlet.coneCutoff = 1.0f;
+            return;
+        }
+
+        meshlet.coneAxis = axis / axisLength;
+
+        float minDot = 1.0f;
+        for (const glm::vec3 &n : normals)
+            minDot = std::min(minDot, glm::dot(n, meshlet.coneAxis));
+
+        // Wider than ~85 degrees, the cone test would never succeed
+        meshlet.coneCutoff = minDot <= 0.1f ? 1.0f : std::sqrt(1.0f - minDot * minDot);
+    }
+
+    /// @brief Splits a triangle list into meshlets, following the current triangle order
+    /// @param vertices The vertex buffer referenced by "indices"
+    /// @param indices The triangle list, ideally optimized for vertex cache first so that consecutive triangles are close
+    /// @param maxVertices The maximum number of unique vertices per meshlet
+    /// @param maxTriangles The maximum number of triangles per meshlet
+    /// @return The meshlets, their ranges are relative to the start of "indices"
+    std::vector<Meshlet> BuildMeshlets(const std::vector<Vertex> &vertices, const std::vector<uint32_t> &indices, size_t maxVertices, size_t maxTriangles)
+    {
+        std::vector<Meshlet> meshlets;
+
+        std::vector<uint32_t> lastMeshlet(vertices.size(), ~0u);
+        Meshlet current;
+        size_t currentVertices = 0;
+        glm::vec3 currentMin(0.0f), currentMax(0.0f);
+
+        auto flush = [&]() {
+            if (current.indexCount == 0)
+                return;
+            ComputeMeshletBounds(current, vertices, indices);
+            meshlets.push_back(current);
+            current = Meshlet{};
+            current.indexOffset = static_cast<uint32_t>(meshlets.back().indexOffset + meshlets.back().indexCount);
+            currentVertices = 0;
+        };
+
+        for (size_t t = 0; t + 2 < indices.size(); t += 3) {
+            uint32_t meshletIndex = static_cast<uint32_t>(meshlets.size());
+
+            size_t newVertices = 0;
+            for (int k = 0; k < 3; k++)
+                if (lastMeshlet[indices[t + k]] != meshletIndex)
+                    newVertices++;
+
+            glm::vec3 triangleMin = glm::min(vertices[indices[t]].position, glm::min(vertices[indices[t + 1]].position, vertices[indices[t + 2]].position));
+            glm::vec3 triangleMax = glm::max(vertices[indices[t]].position, glm::max(vertices[indices[t + 1]].position, vertices[indices[t + 2]].position));
+
+            // A triangle that shares nothing with the meshlet starts a new one when it is half full or far away, to keep the clusters compact
+            bool full = currentVertices + newVertices > maxVertices || current.indexCount / 3 + 1 > maxTriangles;
+            bool disconnected = false;
+            if (newVertices == 3 && current.indexCount > 0) {
+                glm::vec3 margin = (currentMax - currentMin) * 0.5f;
+                bool far = glm::any(glm::lessThan(triangleMax, currentMin - margin)) || glm::any(glm::greaterThan(triangleMin, currentMax + margin));
+                disconnected = far || current.indexCount / 3 >= maxTriangles / 2;
+            }
+
+            if (full || disconnected) {
+                flush();
+                meshletIndex = static_cast<uint32_t>(meshlets.size());
+                newVertices = 3;
+            }
+
+            if (current.indexCount == 0) {
+                currentMin = triangleMin;
+                currentMax = triangleMax;
+            }
+            else {
+                currentMin = glm::min(currentMin, triangleMin);
+                currentMax = glm::max(currentMax, triangleMax);
+            }
+
+            for (int k = 0; k < 3; k++) {
+                if (lastMeshlet[indices[t + k]] != meshletIndex) {
+                    lastMeshlet[indices[t + k]] = meshletIndex;
+                    currentVertices++;
+                }
+            }
+
+            current.indexCount += 3;
+        }
+
+        flush();
+
+        return meshlets;
+    }
+
+    // Symmetric 4x4 error quadric (Garland & Heckbert 1997), weighted by triangle area
+    struct Quadric {
+        double a2 = 0, ab = 0, ac = 0, ad = 0;
+        double b2 = 0, bc = 0, bd = 0;
+        double c2 = 0, cd = 0;
+        double d2 = 0;
+        double weight = 0;
+
+        void AddPlane(const glm::dvec3 &n, double d, double w) {
+            a2 += w * n.x * n.x; ab += w * n.x * n.y; ac += w * n.x * n.z; ad += w * n.x * d;
+            b2 += w * n.y * n.y; bc += w * n.y * n.z; bd += w * n.y * d;
+            c2 += w * n.z * n.z; cd += w * n.z * d;
+            d2 += w * d * d;
+            weight += w;
+        }
+
+        void Add(const Quadric &q) {
+            a2 += q.a2; ab += q.ab; ac += q.ac; ad += q.ad;
+            b2 += q.b2; bc += q.bc; bd += q.bd;
+            c2 += q.c2; cd += q.cd;
+            d2 += q.d2;
+            weight += q.weight;
+        }
+
+        double Evaluate(const glm::dvec3 &p) const {
+            double e = a2 * p.x * p.x + 2.0 * ab * p.x * p.y + 2.0 * ac * p.x * p.z + 2.0 * ad * p.x
+                     + b2 * p.y * p.y + 2.0 * bc * p.y * p.z + 2.0 * bd * p.y
+                     + c2 * p.z * p.z + 2.0 * cd * p.z
+                     + d2;
+            return e > 0.0 ? e : 0.0;
+        }
+    };
+
+    struct PositionKey {
+        float x, y, z;
+        bool operator==(const PositionKey &o) const { return x == o.x && y == o.y && z == o.z; }
+    };
+
+    struct PositionKeyHash {
+        size_t operator()(const PositionKey &k) const {
+            size_t h = std::hash<float>()(k.x);
+            h ^= std::hash<float>()(k.y) + 0x9e3779b9 + (h << 6) + (h >> 2);
+            h ^= std::hash<float>()(k.z) + 0x9e3779b9 + (h << 6) + (h >> 2);
+            return h;
+        }
+    };
+
+    /// @brief Simplifies a triangle list with quadric error metric edge collapses, the vertex buffer is left untouched
+    /// @param vertices The vertex buffer referenced by "indices"
+    /// @param indices The triangle list to simplify
+    /// @param result Receives the simplified triangle list (referencing the same vertices)
+    /// @param targetIndexCount The index count to reach
+    /// @param targetError The maximum distance (in mesh units) a collapse may move the surface
+    /// @return The error of the simplified mesh, in mesh units
+    /// @note Vertices on borders and attribute seams (several vertices sharing a position) are locked,
+    /// every other vertex can only collapse onto one of its neighbours
+    float Simplify(const std::vector<Vertex> &vertices, const std::vector<uint32_t> &indices, std::vector<uint32_t> &result, size_t targetIndexCount, float targetError)
+    {
+        result = indices;
+        result.resize(result.size() / 3 * 3);
+
+        if (result.size() <= targetIndexCount)
+            return 0.0f;
+
+        // Weld vertices by position : "rep" is the first vertex found at each position
+        std::vector<uint32_t> rep(vertices.size());
+        std::vector<uint32_t> groupSize(vertices.size(), 0);
+        {
+            std::unordered_map<PositionKey, uint32_t, PositionKeyHash> firstAtPosition;
+            std::vector<bool> seen(vertices.size(), false);
+            for (uint32_t index : result) {
+                if (seen[index])
+                    continue;
+                seen[index] = true;
+
+                const glm::vec3 &p = vertices[index].position;
+                auto [it, inserted] = firstAtPosition.emplace(PositionKey{p.x, p.y, p.z}, index);
+                rep[index] = it->second;
+                groupSize[it->second]++;
+            }
+        }
+
+        std::vector<bool> locked(vertices.size(), false);
+        for (uint32_t index : result) {
+            if (groupSize[rep[index]] > 1)
+                locked[rep[index]] = true;
+        }
+
+        // Border and non-manifold edges lock their vertices
+        {
+            std::unordered_map<uint64_t, uint32_t> edgeUses;
+            for (size_t t = 0; t < result.size(); t += 3) {
+                for (int k = 0; k < 3; k++) {
+                    uint32_t a = rep[result[t + k]];
+                    uint32_t b = rep[result[t + (k + 1) % 3]];
+                    uint64_t key = a < b ? (uint64_t(a) << 32 | b) : (uint64_t(b) << 32 | a);
+                    edgeUses[key]++;
+                }
+            }
+            for (const auto &[key, uses] : edgeUses) {
+                if (uses != 2) {
+                    locked[key >> 32] = true;
+                    locked[key & 0xffffffffu] = true;
+                }
+            }
+        }
+
+        std::vector<Quadric> quadrics(vertices.size());
+        for (size_t t = 0; t < result.size(); t += 3) {
+            glm::dvec3 p0 = vertices[result[t + 0]].position;
+            glm::dvec3 p1 = vertices[result[t + 1]].position;
+            glm::dvec3 p2 = vertices[result[t + 2]].position;
+
+            glm::dvec3 n = glm::cross(p1 - p0, p2 - p0);
+            double area = glm::length(n);
+            if (area <= 0.0)
+                continue;
+
+            n /= area;
+            double d = -glm::dot(n, p0);
+            for (int k = 0; k < 3; k++)
+                quadrics[rep[result[t + k]]].AddPlane(n, d, area * 0.5);
+        }
+
+        struct Collapse {
+            uint32_t from;
+            uint32_t to;
+            double cost;
+        };
+
+        const double maxCost = static_cast<double>(targetError) * targetError;
+        double resultError = 0.0;
+
+        std::vector<uint32_t> adjacencyOffsets;
+        std::vector<uint32_t> adjacency;
+        std::vector<Collapse> collapses;
+        std::vector<double> bestCost(vertices.size());
+        std::vector<uint32_t> bestTarget(vertices.size());
+        std::vector<bool> used(vertices.size());
+        std::vector<bool> deadTriangles;
+
+        while (result.size() > targetIndexCount) {
+            const size_t triangleCount = result.size() / 3;
+
+            // Vertex -> triangles adjacency (compressed rows)
+            adjacencyOffsets.assign(vertices.size() + 1, 0);
+            for (uint32_t index : result)
+                adjacencyOffsets[index + 1]++;
+            for (size_t v = 0; v < vertices.size(); v++)
+                adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+
+            adjacency.resize(result.size());
+            std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+            for (size_t t = 0; t < triangleCount; t++)
+                for (int k = 0; k < 3; k++)
+                    adjacency[fill[result[t * 3 + k]]++] = static_cast<uint32_t>(t);
+
+            // Cheapest collapse of every free vertex
+            std::fill(bestCost.begin(), bestCost.end(), -1.0);
+            for (size_t t = 0; t < triangleCount; t++) {
+                for (int k = 0; k < 3; k++) {
+                    uint32_t from = result[t * 3 + k];
+                    if (locked[rep[from]])
+                        continue;
+
+                    for (int o = 1; o < 3; o++) {
+                        uint32_t to = result[t * 3 + (k + o) % 3];
+
+                        Quadric q = quadrics[rep[from]];
+                        q.Add(quadrics[rep[to]]);
+                        double cost = q.weight > 0.0 ? q.Evaluate(glm::dvec3(vertices[to].position)) / q.weight : 0.0;
+
+                        if (bestCost[from] < 0.0 || cost < bestCost[from]) {
+                            bestCost[from] = cost;
+                            bestTarget[from] = to;
+                        }
+                    }
+                }
+            }
+
+            collapses.clear();
+            for (size_t v = 0; v < vertices.size(); v++) {
+                if (bestCost[v] >= 0.0 && bestCost[v] <= maxCost)
+                    collapses.push_back(Collapse{static_cast<uint32_t>(v), bestTarget[v], bestCost[v]});
+            }
+
+            std::sort(collapses.begin(), collapses.end(), [](const Collapse &a, const Collapse &b) {
+                return a.cost < b.cost;
+            });
+
+            std::fill(used.begin(), used.end(), false);
+            deadTriangles.assign(triangleCount, false);
+
+            size_t liveTriangles = triangleCount;
+            size_t collapsed = 0;
+
+            for (const Collapse &c : collapses) {
+                if (liveTriangles * 3 <= targetIndexCount)
+                    break;
+
+                if (used[rep[c.from]] || used[rep[c.to]])
+                    continue;
+
+                const glm::vec3 &target = vertices[c.to].position;
+
+                // Reject collapses that would flip a triangle
+                bool flips = false;
+                for (uint32_t a = adjacencyOffsets[c.from]; a < adjacencyOffsets[c.from + 1] && !flips; a++) {
+                    uint32_t t = adjacency[a];
+                    uint32_t i0 = result[t * 3 + 0], i1 = result[t * 3 + 1], i2 = result[t * 3 + 2];
+
+                    if (rep[i0] == rep[c.to] || rep[i1] == rep[c.to] || rep[i2] == rep[c.to])
+                        continue;
+
+                    glm::vec3 p0 = vertices[i0].position, p1 = vertices[i1].position, p2 = vertices[i2].position;
+                    glm::vec3 before = glm::cross(p1 - p0, p2 - p0);
+
+                    if (i0 == c.from) p0 = target;
+                    if (i1 == c.from) p1 = target;
+                    if (i2 == c.from) p2 = target;
+                    glm::vec3 after = glm::cross(p1 - p0, p2 - p0);
+
+                    if (glm::dot(before, after) <= 0.0f)
+                        flips = true;
+                }
+
+                if (flips)
+                    continue;
+
+                for (uint32_t a = adjacencyOffsets[c.from]; a < adjacencyOffsets[c.from + 1]; a++) {
+                    uint32_t t = adjacency[a];
+                    bool degenerate = false;
+
+                    for (int k = 0; k < 3; k++) {
+                        uint32_t &index = result[t * 3 + k];
+                        used[rep[index]] = true;
+
+                        if (index == c.from)
+                            index = c.to;
+                        else if (rep[index] == rep[c.to])
+                            degenerate = true;
+                    }
+
+                    if (degenerate && !deadTriangles[t]) {
+                        deadTriangles[t] = true;
+                        liveTriangles--;
+                    }
+                }
+
+                quadrics[rep[c.to]].Add(quadrics[rep[c.from]]);
+                resultError = std::max(resultError, c.cost);
+                collapsed++;
+            }
+
+            if (collapsed == 0)
+                break;
+
+            size_t write = 0;
+            for (size_t t = 0; t < triangleCount; t++) {
+                if (deadTriangles[t])
+                    continue;
+                for (int k = 0; k < 3; k++)
+                    result[write++] = result[t * 3 + k];
+            }
+            result.resize(write);
+        }
+
+        return static_cast<float>(std::sqrt(resultError));
+    }
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "engine/rendering/utils.hpp"
+#include "engine/rendering/mesh/meshlet.hpp"
+
+#include <vector>
+#include <cstdint>
+
+namespace Epoch::Engine::Rendering::MeshOptimizer{
+
+    // Size of the simulated post-transform vertex cache (FIFO)
+    constexpr unsigned int VERTEX_CACHE_SIZE = 16;
+
+    // Clusters are split once their running ACMR is within this factor of the ACMR of the whole cluster (lambda in Sander et al.)
+    constexpr float OVERDRAW_ACMR_THRESHOLD = 1.05f;
+
+    struct OptimizationStats {
+        float acmrBefore = 0.0f;    // Average cache miss ratio (transformed vertices per triangle)
+        float acmrAfter = 0.0f;
+        float atvrBefore = 0.0f;    // Average transformed vertex ratio (transformed vertices per unique vertex)
+        float atvrAfter = 0.0f;
+        size_t clusterCount = 0;
+    };
+
+    float ComputeACMR(const std::vector<uint32_t> &indices, size_t vertexCount, unsigned int cacheSize = VERTEX_CACHE_SIZE);
+
+    float ComputeATVR(const std::vector<uint32_t> &indices, size_t vertexCount, unsigned int cacheSize = VERTEX_CACHE_SIZE);
+
+    void OptimizeVertexCache(std::vector<uint32_t> &indices, size_t vertexCount, std::vector<uint32_t> &clusters, unsigned int cacheSize = VERTEX_CACHE_SIZE, float threshold = OVERDRAW_ACMR_THRESHOLD);
+
+    void OptimizeOverdraw(std::vector<uint32_t> &indices, const std::vector<Vertex> &vertices, const std::vector<uint32_t> &clusters);
+
+    void OptimizeVertexFetch(std::vector<Vertex> &vertices, std::vector<uint32_t> &indices);
+
+    void Optimize(std::vector<Vertex> &vertices, std::vector<uint32_t> &indices, OptimizationStats *stats = nullptr);
+
+    std::vector<Meshlet> BuildMeshlets(const std::vector<Vertex> &vertices, const std::vector<uint32_t> &indices, size_t maxVertices = MESHLET_MAX_VERTICES, size_t maxTriangles = MESHLET_MAX_TRIANGLES);
+
+    float Simplify(const std::vector<Vertex> &vertices, const std::vector<uint32_t> &indices, std::vector<uint32_t> &result, size_t targetIndexCount, float targetError);
+}
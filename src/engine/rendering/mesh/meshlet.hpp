@@ -0,0 +1,22 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+
+namespace Epoch::Engine::Rendering{
+
+    // Limits of a cluster, small enough for tight bounds and normal cones
+    constexpr size_t MESHLET_MAX_VERTICES = 64;
+    constexpr size_t MESHLET_MAX_TRIANGLES = 124;
+
+    // Contiguous range of triangles culled as a whole
+    struct Meshlet {
+        uint32_t indexOffset = 0;               // Relative to the first index of the mesh
+        uint32_t indexCount = 0;
+        glm::vec3 center = glm::vec3(0.0f);     // Bounding sphere, in mesh units
+        float radius = 0.0f;
+        glm::vec3 coneAxis = glm::vec3(0.0f);   // Average facing direction of the triangles
+        float coneCutoff = 1.0f;                // Sine of the cone spread, 1 when the cluster can't be backface culled
+    };
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "engine/rendering/mesh/mesh.hpp"
+
+#include <string>
+#include <vector>
+#include <memory>
+
+namespace Epoch::Engine::Rendering{
+
+    struct ModelNode {
+        std::string name;
+        int parent = -1;                            // Index in ModelAsset::nodes, -1 for the scene roots
+        glm::mat4 localTransform = glm::mat4(1.0f); // Relative to the parent node, in meters
+        int mesh = -1;                              // Index in ModelAsset::meshes, -1 for empty nodes
+    };
+
+    // Every mesh and node of an imported scene
+    struct ModelAsset {
+        std::vector<ModelNode> nodes;
+        std::vector<std::shared_ptr<Mesh>> meshes;
+
+        /// @brief Computes the transform of a node relative to the model root
+        glm::mat4 GetNodeTransform(int node) const {
+            glm::mat4 transform = glm::mat4(1.0f);
+            while (node >= 0) {
+                transform = nodes[node].localTransform * transform;
+                node = nodes[node].parent;
+            }
+            return transform;
+        }
+    };
+}
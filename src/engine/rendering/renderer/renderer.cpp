@@ -2,6 +2,7 @@
 
 #include <iostream>
 #include <algorithm>
+#include <tuple>
 
 #include "engine/levels/level_manager.hpp"
 
@@ -13,6 +14,10 @@
 
 #include "engine/core/resources/resources_manager.hpp"
 
+#include "engine/rendering/mesh/geometry_arena.hpp"
+#include "engine/rendering/shader/shader_cache.hpp"
+#include "engine/rendering/texture/block_compression.hpp"
+
 namespace Epoch::Engine::Rendering{
 
 
@@ -69,15 +74,33 @@ namespace Epoch::Engine::Rendering{
         //MULTISAMPLING
         glEnable(GL_MULTISAMPLE);
         
+        //UPLOADS
+        UploadQueue::GetInstance().Init(settings.uploads);
+
+        //GEOMETRY
+        GeometryArena::GetInstance().Init();
+
+        //TEXTURES
+        BlockCompression::DetectSupport();
+        TextureStreamer::GetInstance().Init(settings.textureStreaming);
+
+        //SHADERS
+        ShaderCache::GetInstance().Init(settings.shaderCacheDirectory);
+
         //SHADOWS
         shadowMan = new ShadowManager();
         shadowMan->Init(4096);
+        shadowMan->lodBias = settings.enableLods ? settings.shadowLodBias : 0.0f;
+        shadowMan->lodHysteresis = settings.lodHysteresis;
     }
 
     void Renderer::InitFramebuffers()
     {
-        blendShader = Core::Resources::ResourcesManager::GetInstance().GetShader("shaders\\fb\\blend");
-        framebufferShader = Core::Resources::ResourcesManager::GetInstance().GetShader("shaders\\fb\\framebuffer");
+        using namespace Core::Literals;
+
+        Core::Resources::ResourcesManager& resources = Core::Resources::ResourcesManager::GetInstance();
+        blendShader = resources.Get<Shader>("shaders\\fb\\blend"_sid);
+        framebufferShader = resources.Get<Shader>("shaders\\fb\\framebuffer"_sid);
 
         if(framebufferShader == nullptr || blendShader == nullptr){
             DEBUG_ERROR("Viewport buffer cannot be created if the framebuffer shader or the blend shader are null");
@@ -87,7 +110,7 @@ namespace Epoch::Engine::Rendering{
         }
 
         //DEBUG_SHAPES
-        Renderer::unlitShader = Core::Resources::ResourcesManager::GetInstance().GetShader("shaders\\mesh\\unlit");
+        Renderer::unlitShader = resources.Get<Shader>("shaders\\mesh\\unlit"_sid);
     }
 
     void Renderer::Shutdown()
@@ -96,14 +119,25 @@ namespace Epoch::Engine::Rendering{
             renderPass.target->Shutdown();
         }
         viewportBuffer->Shutdown();
+
+        glDeleteBuffers(1, &indirectBuffer);
+        glDeleteBuffers(1, &drawDataBuffer);
+        TextureStreamer::GetInstance().Shutdown();
+        UploadQueue::GetInstance().Shutdown();
+        GeometryArena::GetInstance().Shutdown();
     }
 
     void Renderer::Render()
     {
+        // Copies queued since the last frame, before any draw reads them
+        UploadQueue::GetInstance().Update();
+
         if(CameraManager::GetInstance().GetActiveCamera() != nullptr){
             BeginFrame();
 
             ExecuteRenderPasses();
+
+            TextureStreamer::GetInstance().Update();
         }
     }
 
@@ -125,6 +159,16 @@ namespace Epoch::Engine::Rendering{
 
     void Renderer::SubmitCommands(std::vector<DrawCommand> cmds, bool replace)
     {
+        // The variants are compiled while the level loads rather than on their first draw
+        for (const auto& cmd : cmds) {
+            if (!cmd.mat || !cmd.mat->shader)
+                continue;
+            uint32_t keywords = GetDrawKeywords(cmd);
+            if (settings.multiDrawIndirect && cmd.mat->renderMode != TRANSLUCENT)
+                keywords |= KEYWORD_DRAW_DATA;
+            cmd.mat->shader->GetVariant(keywords);
+        }
+
         if (replace) {
             for (const auto& cmd : cmds) {
                 bool found = false;
@@ -213,51 +257,342 @@ namespace Epoch::Engine::Rendering{
         viewportBuffer->Unbind();
     }
   
+    /// @brief Sets the render state and the per-frame parameters shared by every draw of a material
+    void Renderer::SetupMaterialForDraw(const DrawCommand &cmd)
+    {
+        if(settings.enableShadows && cmd.mat->recievesShadows)
+            shadowMan->BindShadowMaps(cmd.mat);
+
+        switch (cmd.mat->renderMode)
+        {
+            case TRANSLUCENT:
+                glEnable(GL_BLEND);
+                glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+                break;
+
+            case MASKED:
+            case OPAQUE:
+                glDisable(GL_BLEND);
+                break;
+                
+            default:
+                break;
+        }
+
+        cmd.mat->SetParameter("projection", CameraManager::GetInstance().GetActiveCamera()->GetProjection());
+        cmd.mat->SetParameter("view", CameraManager::GetInstance().GetActiveCamera()->GetView());
+        cmd.mat->SetParameter("lightNB", lightMan->GetLightsCount());
+        cmd.mat->SetParameter("camPos", CameraManager::GetInstance().GetActiveCamera()->parent->transform->GetPosition());
+    }
+
+    /// @brief Shader keywords of a draw : those of its material, minus the shadows when they are disabled, and its vertex format
+    uint32_t Renderer::GetDrawKeywords(const DrawCommand &cmd) const
+    {
+        uint32_t keywords = cmd.mat->GetKeywords();
+        if (!settings.enableShadows)
+            keywords &= ~KEYWORD_RECEIVE_SHADOWS;
+        if (cmd.vertexFormat == VertexFormat::Compact)
+            keywords |= KEYWORD_COMPACT_VERTEX;
+        return keywords;
+    }
+
+    /// @brief Picks the LOD of a draw from its projected error and updates its index range
+    /// @param lodScale The value returned by ComputeLodScale for the active camera
+    void Renderer::UpdateLod(DrawCommand &cmd, float lodScale, const glm::vec3 &viewPosition)
+    {
+        if (cmd.lodCount <= 1)
+            return;
+
+        int lod = 0;
+
+        if (settings.enableLods) {
+            glm::mat4 model = cmd.tr->GetTransformMatrix();
+            float scale = glm::max(glm::length(glm::vec3(model[0])), glm::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+            glm::vec3 center = glm::vec3(model * glm::vec4((cmd.boundsMin + cmd.boundsMax) * 0.5f, 1.0f));
+            float radius = glm::length(cmd.boundsMax - cmd.boundsMin) * 0.5f * scale;
+            float distance = glm::length(center - viewPosition) - radius;
+
+            lod = SelectLod(cmd.lods, cmd.lodCount, scale, distance, lodScale, settings.lodBias, settings.lodHysteresis, cmd.currentLod);
+        }
+
+        cmd.currentLod = lod;
+        cmd.indexOffset = static_cast<int>(cmd.lods[lod].indexOffset);
+        cmd.indexCount = static_cast<int>(cmd.lods[lod].indexCount);
+    }
+
+    /// @brief Reports the projected size of a draw to the texture streamer, for every texture of its material
+    /// @param lodScale The value returned by ComputeLodScale for the active camera
+    void Renderer::RequestTextureResolution(const DrawCommand &cmd, float lodScale, const glm::vec3 &viewPosition)
+    {
+        glm::mat4 model = cmd.tr->GetTransformMatrix();
+        float scale = glm::max(glm::length(glm::vec3(model[0])), glm::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+        glm::vec3 center = glm::vec3(model * glm::vec4((cmd.boundsMin + cmd.boundsMax) * 0.5f, 1.0f));
+        float radius = glm::length(cmd.boundsMax - cmd.boundsMin) * 0.5f * scale;
+        float distance = glm::max(glm::length(center - viewPosition) - radius, 1e-3f);
+
+        float pixels = 2.0f * radius * lodScale / distance;
+
+        for (auto& [name, value] : *cmd.mat->GetParameters()) {
+            if (const std::shared_ptr<Texture>* texture = std::get_if<std::shared_ptr<Texture>>(&value); texture && *texture)
+                TextureStreamer::GetInstance().RequestResolution(texture->get(), pixels);
+        }
+    }
+
+    /// @brief Whether the arena copies of a draw were issued, the tickets are cleared once they are so the check is free afterwards
+    bool Renderer::IsGeometryUploaded(DrawCommand &cmd)
+    {
+        for (uint64_t& ticket : cmd.geometryUploads) {
+            if (ticket == 0)
+                continue;
+            if (!UploadQueue::GetInstance().IsComplete(ticket))
+                return false;
+            ticket = 0;
+        }
+        return true;
+    }
+
+    /// @brief Tests the meshlets of a draw against the frustum and their normal cones, the survivors go to visibleClusters
+    /// @param frustum The frustum of the active camera
+    /// @param viewPosition The position of the active camera
+    /// @return False when the draw has no meshlets to cull (coarser LOD or small mesh), it is then drawn as a whole
+    bool Renderer::CullMeshlets(const DrawCommand &cmd, const ECS::Components::Frustum &frustum, const glm::vec3 &viewPosition)
+    {
+        visibleClusters.clear();
+
+        if (!settings.clusterCulling || !cmd.meshlets || cmd.meshletCount <= 0 || cmd.currentLod != 0)
+            return false;
+
+        glm::mat4 model = cmd.tr->GetTransformMatrix();
+        glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(model)));
+        float scale = glm::max(glm::length(glm::vec3(model[0])), glm::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+
+        const std::vector<Meshlet>& meshlets = *cmd.meshlets;
+
+        for (int i = cmd.meshletOffset; i < cmd.meshletOffset + cmd.meshletCount; i++) {
+            const Meshlet& meshlet = meshlets[i];
+
+            glm::vec3 center = glm::vec3(model * glm::vec4(meshlet.center, 1.0f));
+            float radius = meshlet.radius * scale;
+
+            if (!ECS::Components::Camera::IsSphereInFrustum(frustum, center, radius))
+                continue;
+
+            // Every triangle faces away when the view direction stays inside the cone around the axis
+            if (meshlet.coneCutoff < 1.0f) {
+                glm::vec3 axis = glm::normalize(normalMatrix * meshlet.coneAxis);
+                glm::vec3 toCenter = center - viewPosition;
+                if (glm::dot(toCenter, axis) >= meshlet.coneCutoff * glm::length(toCenter) + radius)
+                    continue;
+            }
+
+            size_t firstIndex = cmd.meshletIndexBase + meshlet.indexOffset;
+
+            if (!visibleClusters.empty() && visibleClusters.back().firstIndex + visibleClusters.back().count == firstIndex)
+                visibleClusters.back().count += static_cast<GLsizei>(meshlet.indexCount);
+            else
+                visibleClusters.push_back(ClusterRange{ .count = static_cast<GLsizei>(meshlet.indexCount), .firstIndex = firstIndex });
+        }
+
+        return true;
+    }
+
+    /// @brief Draws every visible opaque and masked command with one glMultiDrawElementsIndirect per (material, VAO, index type, fill mode) bucket
+    void Renderer::DrawOpaqueIndirect()
+    {
+        auto cam = CameraManager::GetInstance().GetActiveCamera();
+
+        float lodScale = ComputeLodScale(cam->fov, cam->GetSize().y);
+        glm::vec3 viewPosition = cam->parent->transform->GetPosition();
+        ECS::Components::Frustum frustum = cam->GetFrustum();
+
+        indirectDraws.clear();
+        for (auto& cmd : drawList) {
+            if (!cmd.mat || cmd.indexCount <= 0 || cmd.mat->renderMode == TRANSLUCENT || !IsGeometryUploaded(cmd))
+                continue;
+            if (cam->frustumCulling && !cam->IsInFrustum(cmd.boundsMin, cmd.boundsMax))
+                continue;
+            UpdateLod(cmd, lodScale, viewPosition);
+            RequestTextureResolution(cmd, lodScale, viewPosition);
+            indirectDraws.push_back(&cmd);
+        }
+
+        if (indirectDraws.empty())
+            return;
+
+        auto bucketKey = [](const DrawCommand* cmd) {
+            return std::make_tuple(cmd->mat.get(), cmd->VAO, cmd->indexType, cmd->fillMode);
+        };
+
+        std::stable_sort(indirectDraws.begin(), indirectDraws.end(), [&](const DrawCommand* a, const DrawCommand* b) {
+            return bucketKey(a) < bucketKey(b);
+        });
+
+        indirectCommands.clear();
+        indirectCommandStarts.clear();
+        drawData.clear();
+
+        // The draw data are written in submission order, so the base instance of each command is the index of its draw.
+        // A draw split into meshlets emits one command per visible cluster range, all sharing its draw data
+        uint32_t materialIndex = 0;
+        for (size_t i = 0; i < indirectDraws.size(); i++) {
+            const DrawCommand* cmd = indirectDraws[i];
+
+            if (i > 0 && cmd->mat != indirectDraws[i - 1]->mat)
+                materialIndex++;
+
+            indirectCommandStarts.push_back(indirectCommands.size());
+
+            if (CullMeshlets(*cmd, frustum, viewPosition)) {
+                for (const ClusterRange& range : visibleClusters) {
+                    indirectCommands.push_back(DrawElementsIndirectCommand{
+                        .count = static_cast<GLuint>(range.count),
+                        .instanceCount = 1,
+                        .firstIndex = static_cast<GLuint>(range.firstIndex),
+                        .baseVertex = cmd->baseVertex,
+                        .baseInstance = static_cast<GLuint>(i)
+                    });
+                }
+            }
+            else {
+                indirectCommands.push_back(DrawElementsIndirectCommand{
+                    .count = static_cast<GLuint>(cmd->indexCount),
+                    .instanceCount = 1,
+                    .firstIndex = static_cast<GLuint>(cmd->indexOffset),
+                    .baseVertex = cmd->baseVertex,
+                    .baseInstance = static_cast<GLuint>(i)
+                });
+            }
+
+            drawData.push_back(DrawData{
+                .model = cmd->tr->GetTransformMatrix(),
+                .posScale = glm::vec4(cmd->positionScale, 0.0f),
+                .posOffset = glm::vec4(cmd->positionOffset, 0.0f),
+                .color = cmd->color,
+                .misc = glm::uvec4(materialIndex, 0, 0, 0)
+            });
+        }
+
+        indirectCommandStarts.push_back(indirectCommands.size());
+
+        if (indirectCommands.empty())
+            return;
+
+        GeometryArena::GetInstance().ReserveDrawIDs(drawData.size());
+
+        if (indirectBuffer == 0)
+            glGenBuffers(1, &indirectBuffer);
+        if (drawDataBuffer == 0)
+            glGenBuffers(1, &drawDataBuffer);
+
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
+        glBufferData(GL_DRAW_INDIRECT_BUFFER, indirectCommands.size() * sizeof(DrawElementsIndirectCommand), indirectCommands.data(), GL_STREAM_DRAW);
+
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, drawDataBuffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, drawData.size() * sizeof(DrawData), drawData.data(), GL_STREAM_DRAW);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, drawDataBuffer);
+
+        GLuint boundVAO = 0;
+        size_t bucketStart = 0;
+
+        while (bucketStart < indirectDraws.size()) {
+            size_t bucketEnd = bucketStart + 1;
+            while (bucketEnd < indirectDraws.size() && bucketKey(indirectDraws[bucketEnd]) == bucketKey(indirectDraws[bucketStart]))
+                bucketEnd++;
+
+            const DrawCommand& first = *indirectDraws[bucketStart];
+            size_t commandStart = indirectCommandStarts[bucketStart];
+            size_t commandEnd = indirectCommandStarts[bucketEnd];
+
+            if (commandStart == commandEnd) {
+                bucketStart = bucketEnd;
+                continue;
+            }
+
+            SetupMaterialForDraw(first);
+            first.mat->Use(GetDrawKeywords(first) | KEYWORD_DRAW_DATA);
+
+            if (first.VAO != boundVAO) {
+                glBindVertexArray(first.VAO);
+                boundVAO = first.VAO;
+            }
+            glPolygonMode(GL_FRONT_AND_BACK, first.fillMode);
+
+            glMultiDrawElementsIndirect(GL_TRIANGLES, first.indexType,
+                (void*)(commandStart * sizeof(DrawElementsIndirectCommand)),
+                static_cast<GLsizei>(commandEnd - commandStart), 0);
+
+            first.mat->StopUsing();
+
+            bucketStart = bucketEnd;
+        }
+
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    }
+  
     void Renderer::DrawScene()
     {
         glEnable(GL_DEPTH_TEST);
         glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+        glBindVertexArray(0);
+
+        if (settings.multiDrawIndirect)
+            DrawOpaqueIndirect();
+
         // --- Main Draw Calls ---
+        // Meshes share one VAO per vertex format, so it only changes between formats
+        GLuint boundVAO = 0;
+        glBindVertexArray(0);
+
+        auto cam = CameraManager::GetInstance().GetActiveCamera();
+        float lodScale = ComputeLodScale(cam->fov, cam->GetSize().y);
+        glm::vec3 viewPosition = cam->parent->transform->GetPosition();
+        ECS::Components::Frustum frustum = cam->GetFrustum();
+
         for (auto& cmd : drawList) {
-            if (!cmd.mat || cmd.indexCount <= 0 || (CameraManager::GetInstance().GetActiveCamera()->frustumCulling && !CameraManager::GetInstance().GetActiveCamera()->IsInFrustum(cmd.boundsMin, cmd.boundsMax)))
+            if (settings.multiDrawIndirect && cmd.mat && cmd.mat->renderMode != TRANSLUCENT)
                 continue;
 
-            if(settings.enableShadows && cmd.mat->recievesShadows)
-                shadowMan->BindShadowMaps(cmd.mat);
-
-            switch (cmd.mat->renderMode)
-            {
-                case TRANSLUCENT:
-                    glEnable(GL_BLEND);
-                    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-                    cmd.mat->SetParameter("masked", false);
-                    break;
+            if (!cmd.mat || cmd.indexCount <= 0 || (CameraManager::GetInstance().GetActiveCamera()->frustumCulling && !CameraManager::GetInstance().GetActiveCamera()->IsInFrustum(cmd.boundsMin, cmd.boundsMax)))
+                continue;
+            if (!IsGeometryUploaded(cmd))
+                continue;
 
-                case MASKED:
-                    cmd.mat->SetParameter("masked", true);
-                    glDisable(GL_BLEND);
-                    break;
+            UpdateLod(cmd, lodScale, viewPosition);
+            RequestTextureResolution(cmd, lodScale, viewPosition);
 
-                case OPAQUE:
-                    cmd.mat->SetParameter("masked", false);
-                    glDisable(GL_BLEND);
-                    break;
-                    
-                default:
-                    break;
-            }
+            bool clustered = CullMeshlets(cmd, frustum, viewPosition);
+            if (clustered && visibleClusters.empty())
+                continue;
 
-            cmd.mat->SetParameter("projection", CameraManager::GetInstance().GetActiveCamera()->GetProjection());
-            cmd.mat->SetParameter("view", CameraManager::GetInstance().GetActiveCamera()->GetView());
+            SetupMaterialForDraw(cmd);
             cmd.mat->SetParameter("model", cmd.tr->GetTransformMatrix());
-            cmd.mat->SetParameter("lightNB", lightMan->GetLightsCount());
-            cmd.mat->SetParameter("camPos", CameraManager::GetInstance().GetActiveCamera()->parent->transform->GetPosition());
-            cmd.mat->Use();
-            glBindVertexArray(cmd.VAO);
+            cmd.mat->SetParameter("posScale", cmd.positionScale);
+            cmd.mat->SetParameter("posOffset", cmd.positionOffset);
+            cmd.mat->SetParameter("meshColor", cmd.color);
+            cmd.mat->Use(GetDrawKeywords(cmd));
+            if (cmd.VAO != boundVAO) {
+                glBindVertexArray(cmd.VAO);
+                boundVAO = cmd.VAO;
+            }
             glPolygonMode(GL_FRONT_AND_BACK, cmd.fillMode);
-            glDrawElements(GL_TRIANGLES, cmd.indexCount, GL_UNSIGNED_INT, (void*)(cmd.indexOffset * sizeof(uint32_t)));
+            size_t indexSize = cmd.indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+            if (clustered) {
+                clusterCounts.clear();
+                clusterOffsets.clear();
+                clusterBaseVertices.clear();
+                for (const ClusterRange& range : visibleClusters) {
+                    clusterCounts.push_back(range.count);
+                    clusterOffsets.push_back((const void*)(range.firstIndex * indexSize));
+                    clusterBaseVertices.push_back(cmd.baseVertex);
+                }
+                glMultiDrawElementsBaseVertex(GL_TRIANGLES, clusterCounts.data(), cmd.indexType, clusterOffsets.data(),
+                    static_cast<GLsizei>(clusterCounts.size()), clusterBaseVertices.data());
+            }
+            else {
+                glDrawElementsBaseVertex(GL_TRIANGLES, cmd.indexCount, cmd.indexType, (void*)(cmd.indexOffset * indexSize), cmd.baseVertex);
+            }
             cmd.mat->StopUsing();
         }
 
@@ -271,6 +606,8 @@ namespace Epoch::Engine::Rendering{
         // --- Debug Physics Shapes ---
         unlitShader->Activate();
         unlitShader->setMat4("projectionView", CameraManager::GetInstance().GetActiveCamera()->GetMatrix());
+        unlitShader->setVec3("posScale", glm::vec3(1.0f));
+        unlitShader->setVec3("posOffset", glm::vec3(0.0f));
 
         for (auto& physicBody : Levels::LevelManager::GetInstance().GetLevelAt(0)->physicsBodies) {
 
@@ -1,6 +1,10 @@
 #pragma once
 
 #include "engine/rendering/material/material.hpp"
+#include "engine/rendering/mesh/mesh_lod.hpp"
+#include "engine/rendering/mesh/meshlet.hpp"
+#include "engine/rendering/texture/texture_streamer.hpp"
+#include "engine/rendering/upload/upload_queue.hpp"
 #include "engine/rendering/framebuffer/framebuffer.hpp"
 #include "engine/rendering/light/light_manager.hpp"
 #include "engine/ecs/components/rendering/model_component.hpp"
@@ -12,6 +16,7 @@ namespace Epoch::Engine{
 
     namespace ECS::Components{
         class Transform;
+        struct Frustum;
     }
 
     namespace Rendering {
@@ -24,6 +29,15 @@ namespace Epoch::Engine{
             //TODO : bool enableStatsOverlay = false;
             bool enableShadows = true;
             bool enablePostProcessing = true;
+            bool multiDrawIndirect = false;     // Opaque and masked draws are batched per material with glMultiDrawElementsIndirect
+            bool enableLods = true;
+            float lodBias = 1.0f;               // Maximum projected LOD error, in pixels
+            float shadowLodBias = 4.0f;         // Same for the shadow passes, coarser since shadow maps are filtered
+            float lodHysteresis = 0.25f;        // Fraction of the bias the error must cross before switching LOD
+            bool clusterCulling = true;         // Frustum and backface culling of the meshlets of large meshes
+            TextureStreamingSettings textureStreaming;
+            UploadQueueSettings uploads;
+            std::string shaderCacheDirectory = "shader_cache";  // Linked program binaries, empty to always compile
             private:
                 int windowPosX, windowPosY, windowWidth, windowHeight= 0;
                 bool fullscreen = false;
@@ -56,14 +70,45 @@ namespace Epoch::Engine{
         struct DrawCommand {
             int indexOffset = 0;
             int indexCount = 0;
+            int baseVertex = 0;
             unsigned int VAO;
-            unsigned int VBO;
             std::shared_ptr<Material> mat;
             std::shared_ptr<ECS::Components::Transform> tr;
             int id;
             int fillMode = GL_FILL;
             glm::vec3 boundsMin = glm::vec3(0);
             glm::vec3 boundsMax = glm::vec3(0);
+            unsigned int indexType = GL_UNSIGNED_INT;
+            VertexFormat vertexFormat = VertexFormat::Full;
+            glm::vec3 positionScale = glm::vec3(1);
+            glm::vec3 positionOffset = glm::vec3(0);
+            glm::vec4 color = glm::vec4(1);
+            MeshLod lods[MAX_MESH_LODS];        // Absolute index ranges, lodCount = 0 when the draw has no LOD chain
+            int lodCount = 0;
+            int currentLod = 0;
+            std::shared_ptr<const std::vector<Meshlet>> meshlets;   // Only drawn while currentLod is 0
+            int meshletOffset = 0;
+            int meshletCount = 0;
+            size_t meshletIndexBase = 0;        // Absolute index of the first mesh index, meshlet ranges are relative to it
+            uint64_t geometryUploads[2] = { 0, 0 };     // Upload queue tickets of the arena copies, the draw waits for them
+        };
+
+        // Layout expected by GL_DRAW_INDIRECT_BUFFER
+        struct DrawElementsIndirectCommand {
+            GLuint count;
+            GLuint instanceCount;
+            GLuint firstIndex;
+            GLint baseVertex;
+            GLuint baseInstance;
+        };
+
+        // Per draw data of the indirect path (std430, "DrawDataBuffer" at binding 1)
+        struct DrawData {
+            glm::mat4 model;
+            glm::vec4 posScale;
+            glm::vec4 posOffset;
+            glm::vec4 color;
+            glm::uvec4 misc;    // x : material index
         };
 
         class Renderer{
@@ -126,6 +171,14 @@ namespace Epoch::Engine{
 
             void BeginFrame();
 
+            void DrawOpaqueIndirect();
+            void SetupMaterialForDraw(const DrawCommand& cmd);
+            uint32_t GetDrawKeywords(const DrawCommand& cmd) const;
+            static bool IsGeometryUploaded(DrawCommand& cmd);
+            void UpdateLod(DrawCommand& cmd, float lodScale, const glm::vec3& viewPosition);
+            void RequestTextureResolution(const DrawCommand& cmd, float lodScale, const glm::vec3& viewPosition);
+            bool CullMeshlets(const DrawCommand& cmd, const ECS::Components::Frustum& frustum, const glm::vec3& viewPosition);
+
             GLFWwindow *window;
 
             std::vector<DrawCommand> drawList;
@@ -141,6 +194,23 @@ namespace Epoch::Engine{
 
             std::shared_ptr<Shader> unlitShader;
 
+            GLuint indirectBuffer = 0;
+            GLuint drawDataBuffer = 0;
+            std::vector<const DrawCommand*> indirectDraws;
+            std::vector<DrawElementsIndirectCommand> indirectCommands;
+            std::vector<DrawData> drawData;
+            std::vector<size_t> indirectCommandStarts;     // First command of each entry of indirectDraws, plus the total
+
+            // Index ranges of the meshlets that survived CullMeshlets, adjacent ranges merged
+            struct ClusterRange {
+                GLsizei count;
+                size_t firstIndex;
+            };
+            std::vector<ClusterRange> visibleClusters;
+            std::vector<GLsizei> clusterCounts;
+            std::vector<const void*> clusterOffsets;
+            std::vector<GLint> clusterBaseVertices;
+
             RendererSettings settings;
 
         };
@@ -1,9 +1,11 @@
 #include "shader.hpp"
 
+#include "engine/rendering/shader/shader_cache.hpp"
 #include "engine/debugging/debugger.hpp"
 
 #include <stdexcept>
 #include <iostream>
+#include <algorithm>
 
 
 namespace Epoch::Engine::Rendering {
@@ -21,68 +23,206 @@ namespace Epoch::Engine::Rendering {
                type == GL_SAMPLER_2D_RECT || type == GL_SAMPLER_2D_RECT_SHADOW;
     }
 
+    static const char* KEYWORD_NAMES[KEYWORD_COUNT] = { "MASKED", "RECEIVE_SHADOWS", "NORMAL_MAP", "DRAW_DATA", "COMPACT_VERTEX", "RECONSTRUCT_NORMAL_Z" };
+
+    /// @brief Inserts #define lines after the #version directive, a #line directive keeps the error lines of the file
+    static std::string InjectDefines(const std::string& code, const std::string& defines)
+    {
+        size_t version = code.find("#version");
+        if (code.empty() || version == std::string::npos)
+            return defines + "#line 1\n" + code;
+
+        size_t lineEnd = code.find('\n', version);
+        if (lineEnd == std::string::npos)
+            return code + "\n" + defines;
+
+        size_t nextLine = std::count(code.begin(), code.begin() + lineEnd + 1, '\n') + 1;
+        return code.substr(0, lineEnd + 1) + defines + "#line " + std::to_string(nextLine) + "\n" + code.substr(lineEnd + 1);
+    }
+
     /// @brief Constructor that build a Shader Program from 2 (vert and frag) or 3 (vert, frag and geom) different shaders path
     Shader::Shader(const Path vertexFilePath, const Path fragmentFilePath, const Path geometryFilePath)
     {
-        if (vertexFilePath.full != "" && fragmentFilePath.full != "") {
-		
-            this->vertexFilePath = vertexFilePath.full;
-            this->fragmentFilePath = fragmentFilePath.full;
-
-            // Read vertexFile and fragmentFile and store the strings
-            std::string vertexCode = vertexFilePath.ReadFile();
-            std::string fragmentCode = fragmentFilePath.ReadFile();
-    
-            // Convert the shader source strings into character arrays
-            const char* vertexSource = vertexCode.c_str();
-            const char* fragmentSource = fragmentCode.c_str();
-    
-            // Create Vertex Shader Object and get its reference
-            GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
-            // Attach Vertex Shader source to the Vertex Shader Object
-            glShaderSource(vertexShader, 1, &vertexSource, NULL);
-            // Compile the Vertex Shader into machine code
-            glCompileShader(vertexShader);
-            // Checks if Shader compiled succesfully
-            CompileErrors(vertexShader, "VERTEX");
-    
-            // Create Fragment Shader Object and get its reference
-            GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-            // Attach Fragment Shader source to the Fragment Shader Object
-            glShaderSource(fragmentShader, 1, &fragmentSource, NULL);
-            // Compile the Vertex Shader into machine code
-            glCompileShader(fragmentShader);
-            // Checks if Shader compiled succesfully
-            CompileErrors(fragmentShader, "FRAGMENT");
-    
-            GLuint geometryShader = 0;
-            bool hasGeometry = !geometryFilePath.full.empty();
-
-            if (hasGeometry) {
-                this->geometryFilePath = geometryFilePath.full;
-                std::string geometryCode = geometryFilePath.ReadFile();
-                const char* geometrySource = geometryCode.c_str();
-
-                geometryShader = glCreateShader(GL_GEOMETRY_SHADER);
-                glShaderSource(geometryShader, 1, &geometrySource, NULL);
-                glCompileShader(geometryShader);
-                CompileErrors(geometryShader, "GEOMETRY");
-            }
+        if (vertexFilePath.full != "" && fragmentFilePath.full != "")
+            Compile(ReadSources(vertexFilePath, fragmentFilePath, geometryFilePath));
+    }
+
+    /// @brief Constructor that build a Shader Program from sources read with ReadSources
+    Shader::Shader(const ShaderSources &sources)
+    {
+        if (!sources.vertexCode.empty() && !sources.fragmentCode.empty())
+            Compile(sources);
+    }
+
+    /// @brief Reads the source files of a program, without any GL call so it can run on a worker thread
+    /// @param geometryFilePath The geometry stage, ignored if empty
+    ShaderSources Shader::ReadSources(const Path &vertexFilePath, const Path &fragmentFilePath, const Path &geometryFilePath)
+    {
+        ShaderSources sources;
+        sources.vertexFilePath = vertexFilePath.full;
+        sources.fragmentFilePath = fragmentFilePath.full;
+        sources.vertexCode = vertexFilePath.ReadFile();
+        sources.fragmentCode = fragmentFilePath.ReadFile();
+
+        if (!geometryFilePath.full.empty()) {
+            sources.geometryFilePath = geometryFilePath.full;
+            sources.geometryCode = geometryFilePath.ReadFile();
+        }
+
+        return sources;
+    }
+
+    /// @brief Reads the stage files again and relinks the program. The previous program is kept when the new one does not link
+    /// @return True if the program was replaced
+    bool Shader::Reload()
+    {
+        if (vertexFilePath.empty() || fragmentFilePath.empty())
+            return false;
+
+        ShaderSources fresh = ReadSources(Path(vertexFilePath), Path(fragmentFilePath), geometryFilePath.empty() ? Path("") : Path(geometryFilePath));
+        if (fresh.vertexCode.empty() || fresh.fragmentCode.empty())
+            return false;
+
+        GLuint previousID = ID;
+        ShaderSources previousSources = sources;
+        uint32_t previousKeywords = supportedKeywords;
+        Compile(fresh);
+
+        GLint linked = GL_FALSE;
+        glGetProgramiv(ID, GL_LINK_STATUS, &linked);
+        if (linked == GL_FALSE) {
+            glDeleteProgram(ID);
+            ID = previousID;
+            sources = std::move(previousSources);
+            supportedKeywords = previousKeywords;
+            return false;
+        }
+
+        glDeleteProgram(previousID);
 
-            ID = glCreateProgram();
-            glAttachShader(ID, vertexShader);
-            glAttachShader(ID, fragmentShader);
-            if (hasGeometry)
-                glAttachShader(ID, geometryShader);
+        // Compiled again from the new sources on their next use
+        for (auto& [keywords, variant] : variants)
+            if (variant)
+                variant->Cleanup();
+        variants.clear();
 
-            glLinkProgram(ID);
-            CompileErrors(ID, "PROGRAM");
+        return true;
+    }
+
+    Shader* Shader::GetVariant(uint32_t keywords)
+    {
+        keywords &= supportedKeywords;
+        if (keywords == 0)
+            return this;
+
+        auto it = variants.find(keywords);
+        if (it != variants.end())
+            return it->second ? it->second.get() : this;
+
+        std::string defines;
+        for (uint32_t i = 0; i < KEYWORD_COUNT; i++)
+            if (keywords & (1u << i))
+                defines += std::string("#define ") + KEYWORD_NAMES[i] + "\n";
+
+        ShaderSources variantSources = sources;
+        variantSources.vertexCode = InjectDefines(sources.vertexCode, defines);
+        variantSources.fragmentCode = InjectDefines(sources.fragmentCode, defines);
+        if (!sources.geometryCode.empty())
+            variantSources.geometryCode = InjectDefines(sources.geometryCode, defines);
+
+        std::shared_ptr<Shader> variant = std::make_shared<Shader>(variantSources);
+
+        // A variant that doesn't link falls back to the base program
+        GLint linked = GL_FALSE;
+        glGetProgramiv(variant->ID, GL_LINK_STATUS, &linked);
+        if (linked == GL_FALSE) {
+            DEBUG_ERROR("Couldn't build the variant " + defines + "of shader : " + fragmentFilePath);
+            variant->Cleanup();
+            variants.emplace(keywords, nullptr);
+            return this;
+        }
+
+        variants.emplace(keywords, variant);
+        return variant.get();
+    }
+
+    void Shader::Compile(const ShaderSources &sources)
+    {
+        this->vertexFilePath = sources.vertexFilePath;
+        this->fragmentFilePath = sources.fragmentFilePath;
+        if (!sources.geometryFilePath.empty())
+            this->geometryFilePath = sources.geometryFilePath;
+        this->sources = sources;
+
+        supportedKeywords = 0;
+        for (uint32_t i = 0; i < KEYWORD_COUNT; i++) {
+            const char* name = KEYWORD_NAMES[i];
+            if (sources.vertexCode.find(name) != std::string::npos || sources.fragmentCode.find(name) != std::string::npos
+                || sources.geometryCode.find(name) != std::string::npos)
+                supportedKeywords |= 1u << i;
+        }
+
+        ShaderCache& cache = ShaderCache::GetInstance();
+
+        ID = cache.Load(sources);
+        if (ID != 0)
+            return;
+
+        // Convert the shader source strings into character arrays
+        const char* vertexSource = sources.vertexCode.c_str();
+        const char* fragmentSource = sources.fragmentCode.c_str();
+
+        // Create Vertex Shader Object and get its reference
+        GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
+        // Attach Vertex Shader source to the Vertex Shader Object
+        glShaderSource(vertexShader, 1, &vertexSource, NULL);
+        // Compile the Vertex Shader into machine code
+        glCompileShader(vertexShader);
+        // Checks if Shader compiled succesfully
+        CompileErrors(vertexShader, "VERTEX");
+
+        // Create Fragment Shader Object and get its reference
+        GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+        // Attach Fragment Shader source to the Fragment Shader Object
+        glShaderSource(fragmentShader, 1, &fragmentSource, NULL);
+        // Compile the Vertex Shader into machine code
+        glCompileShader(fragmentShader);
+        // Checks if Shader compiled succesfully
+        CompileErrors(fragmentShader, "FRAGMENT");
+
+        GLuint geometryShader = 0;
+        bool hasGeometry = !sources.geometryFilePath.empty();
 
-            glDeleteShader(vertexShader);
-            glDeleteShader(fragmentShader);
-            if (hasGeometry)
-                glDeleteShader(geometryShader);
+        if (hasGeometry) {
+            const char* geometrySource = sources.geometryCode.c_str();
+
+            geometryShader = glCreateShader(GL_GEOMETRY_SHADER);
+            glShaderSource(geometryShader, 1, &geometrySource, NULL);
+            glCompileShader(geometryShader);
+            CompileErrors(geometryShader, "GEOMETRY");
         }
+
+        ID = glCreateProgram();
+        glAttachShader(ID, vertexShader);
+        glAttachShader(ID, fragmentShader);
+        if (hasGeometry)
+            glAttachShader(ID, geometryShader);
+
+        if (cache.IsEnabled())
+            glProgramParameteri(ID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
+        glLinkProgram(ID);
+        CompileErrors(ID, "PROGRAM");
+
+        GLint linked = GL_FALSE;
+        glGetProgramiv(ID, GL_LINK_STATUS, &linked);
+        if (linked == GL_TRUE)
+            cache.Store(ID, sources);
+
+        glDeleteShader(vertexShader);
+        glDeleteShader(fragmentShader);
+        if (hasGeometry)
+            glDeleteShader(geometryShader);
     }
 
     /// @brief Getter for the uniforms names and types of the shader
@@ -132,6 +272,11 @@ namespace Epoch::Engine::Rendering {
     void Shader::Cleanup()
     {
         glDeleteProgram(ID);
+
+        for (auto& [keywords, variant] : variants)
+            if (variant)
+                variant->Cleanup();
+        variants.clear();
     }
 
     /// @brief Checks if the different Shaders have compiled properly
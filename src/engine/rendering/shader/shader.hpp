@@ -6,6 +6,9 @@
 
 #include <string>
 #include <iostream>
+#include <unordered_map>
+#include <memory>
+#include <cstdint>
 
 namespace Epoch::Engine::Rendering {
 
@@ -15,6 +18,23 @@ namespace Epoch::Engine::Rendering {
         GLint location;
     };
 
+    // Source code of the stages of a program, read off the GL thread by Shader::ReadSources
+    struct ShaderSources {
+        std::string vertexFilePath, fragmentFilePath, geometryFilePath;
+        std::string vertexCode, fragmentCode, geometryCode;
+    };
+
+    // Compile time features of a program, each one becomes a #define of its variants
+    enum ShaderKeyword : uint32_t {
+        KEYWORD_MASKED          = 1 << 0,   // Alpha tested
+        KEYWORD_RECEIVE_SHADOWS = 1 << 1,
+        KEYWORD_NORMAL_MAP      = 1 << 2,
+        KEYWORD_DRAW_DATA       = 1 << 3,   // Per draw data of the multi-draw indirect path
+        KEYWORD_COMPACT_VERTEX  = 1 << 4,
+        KEYWORD_RECONSTRUCT_NORMAL_Z = 1 << 5,   // The normal map only stores xy (BC5 or two channels)
+        KEYWORD_COUNT           = 6
+    };
+
     class Shader{
         
         public:
@@ -22,6 +42,16 @@ namespace Epoch::Engine::Rendering {
             GLuint ID;
         
             Shader(const Filesystem::Path vertexFilePath = Filesystem::Path(""), const Filesystem::Path fragmentFilePath = Filesystem::Path(""), const Filesystem::Path geometryFilePath = Filesystem::Path(""));
+            Shader(const ShaderSources& sources);
+
+            bool Reload();
+
+            /// @brief Returns the program specialized for a set of keywords, compiled on first use. Keywords the sources
+            /// never mention are ignored, so shaders without any keyword always return themselves
+            Shader* GetVariant(uint32_t keywords);
+            uint32_t GetSupportedKeywords() const { return supportedKeywords; }
+
+            static ShaderSources ReadSources(const Filesystem::Path& vertexFilePath, const Filesystem::Path& fragmentFilePath, const Filesystem::Path& geometryFilePath);
 
             std::vector<UniformInfo> GetActiveUniforms();
 
@@ -89,10 +119,15 @@ namespace Epoch::Engine::Rendering {
             std::string fragmentFilePath;
 
         private:
+            void Compile(const ShaderSources& sources);
             void CompileErrors(unsigned int shader, const char* type);
         
             std::string vertexFilePath;
             std::string geometryFilePath;
+
+            ShaderSources sources;                  // Kept to compile the variants
+            uint32_t supportedKeywords = 0;
+            std::unordered_map<uint32_t, std::shared_ptr<Shader>> variants;
     };
 
 }
\ No newline at end of file
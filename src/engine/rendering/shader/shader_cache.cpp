@@ -0,0 +1,140 @@
+#include "shader_cache.hpp"
+
+#include "engine/rendering/shader/shader.hpp"
+#include "engine/debugging/debugger.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cstring>
+#include <vector>
+
+namespace Epoch::Engine::Rendering {
+
+    // .bin layout : header then the driver specific program binary
+    struct ShaderBinaryHeader {
+        char magic[4];          // "ESHB"
+        uint32_t version;
+        uint32_t format;        // Binary format returned by glGetProgramBinary
+        uint32_t size;
+    };
+
+    constexpr uint32_t SHADER_BINARY_VERSION = 1;
+
+    static uint64_t HashBytes(uint64_t hash, const std::string& bytes)
+    {
+        // FNV-1a, the length is hashed too so stages can't shift into each other
+        for (unsigned char c : bytes) {
+            hash ^= c;
+            hash *= 1099511628211ull;
+        }
+        for (size_t i = 0, length = bytes.size(); i < sizeof(length); i++) {
+            hash ^= (length >> (i * 8)) & 0xff;
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    void ShaderCache::Init(const std::string &directory)
+    {
+        enabled = false;
+        this->directory = directory;
+
+        if (directory.empty())
+            return;
+
+        GLint formats = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        if (formats == 0) {
+            DEBUG_WARNING("The driver has no program binary format, shaders are compiled on every start");
+            return;
+        }
+
+        std::error_code error;
+        std::filesystem::create_directories(directory, error);
+        if (error) {
+            DEBUG_WARNING("Couldn't create the shader cache directory : " + directory);
+            return;
+        }
+
+        auto glString = [](GLenum name) {
+            const GLubyte* value = glGetString(name);
+            return value ? std::string(reinterpret_cast<const char*>(value)) : std::string();
+        };
+        driver = glString(GL_VENDOR) + "|" + glString(GL_RENDERER) + "|" + glString(GL_VERSION);
+
+        enabled = true;
+    }
+
+    std::string ShaderCache::GetCachePath(const ShaderSources &sources) const
+    {
+        uint64_t hash = 14695981039346656037ull;
+        hash = HashBytes(hash, driver);
+        hash = HashBytes(hash, sources.vertexCode);
+        hash = HashBytes(hash, sources.fragmentCode);
+        hash = HashBytes(hash, sources.geometryCode);
+
+        std::ostringstream name;
+        name << std::hex << std::setw(16) << std::setfill('0') << hash << ".bin";
+        return (std::filesystem::path(directory) / name.str()).string();
+    }
+
+    GLuint ShaderCache::Load(const ShaderSources &sources)
+    {
+        if (!enabled)
+            return 0;
+
+        std::ifstream file(GetCachePath(sources), std::ios::binary);
+        if (!file)
+            return 0;
+
+        ShaderBinaryHeader header;
+        if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))
+            || std::memcmp(header.magic, "ESHB", 4) != 0 || header.version != SHADER_BINARY_VERSION || header.size == 0)
+            return 0;
+
+        std::vector<char> binary(header.size);
+        if (!file.read(binary.data(), binary.size()))
+            return 0;
+
+        GLuint program = glCreateProgram();
+        glProgramBinary(program, header.format, binary.data(), static_cast<GLsizei>(binary.size()));
+
+        // Rejected after a driver update the version string didn't reveal, the caller compiles and overwrites it
+        GLint linked = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        if (linked == GL_FALSE) {
+            glDeleteProgram(program);
+            return 0;
+        }
+
+        return program;
+    }
+
+    void ShaderCache::Store(GLuint program, const ShaderSources &sources)
+    {
+        if (!enabled)
+            return;
+
+        GLint length = 0;
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (length <= 0)
+            return;
+
+        std::vector<char> binary(length);
+        GLenum format = 0;
+        glGetProgramBinary(program, length, &length, &format, binary.data());
+
+        ShaderBinaryHeader header;
+        std::memcpy(header.magic, "ESHB", 4);
+        header.version = SHADER_BINARY_VERSION;
+        header.format = format;
+        header.size = static_cast<uint32_t>(length);
+
+        std::string path = GetCachePath(sources);
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if (!file.write(reinterpret_cast<const char*>(&header), sizeof(header)) || !file.write(binary.data(), length))
+            DEBUG_WARNING("Couldn't write the shader cache file : " + path);
+    }
+}
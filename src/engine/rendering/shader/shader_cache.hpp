@@ -0,0 +1,44 @@
+#pragma once
+
+#include "engine/rendering/utils.hpp"
+
+#include <string>
+#include <cstdint>
+
+namespace Epoch::Engine::Rendering {
+
+    struct ShaderSources;
+
+    // Linked program binaries saved by glGetProgramBinary, one file per program keyed by its sources and the driver
+    class ShaderCache {
+        public:
+            static ShaderCache& GetInstance() {
+                static ShaderCache instance;
+                return instance;
+            }
+
+            /// @brief Must be called with a current GL context, an empty directory disables the cache
+            void Init(const std::string& directory);
+
+            /// @brief Creates a program from the cached binary of these sources
+            /// @return The linked program, 0 if there is no usable binary
+            GLuint Load(const ShaderSources& sources);
+
+            /// @brief Saves the binary of a program linked from these sources
+            void Store(GLuint program, const ShaderSources& sources);
+
+            bool IsEnabled() const { return enabled; }
+
+        private:
+            ShaderCache() = default;
+            ~ShaderCache() = default;
+            ShaderCache(const ShaderCache&) = delete;
+            ShaderCache& operator=(const ShaderCache&) = delete;
+
+            std::string GetCachePath(const ShaderSources& sources) const;
+
+            bool enabled = false;
+            std::string directory;
+            std::string driver;     // Vendor, renderer and version strings, binaries only load on the driver that produced them
+    };
+}
@@ -4,6 +4,7 @@
 
 #include "engine/rendering/renderer/renderer.hpp"
 #include "engine/ecs/components/rendering/camera.hpp"
+#include "engine/ecs/objects/actors/actor.hpp"
 
 namespace Epoch::Engine::Rendering{
     
@@ -237,13 +238,19 @@ namespace Epoch::Engine::Rendering{
 
     /// @brief Render the scene into each shadow map
     /// @param meshes The meshes to render. All other meshes will be occluded from the shadow pass
-    void ShadowManager::RenderShadowMaps(const std::unordered_map<int, std::pair<glm::mat4, Rendering::Mesh*>> &meshes, std::shared_ptr<ECS::Components::Camera> cam)
+    void ShadowManager::RenderShadowMaps(std::unordered_map<int, ShadowCaster> &meshes, std::shared_ptr<ECS::Components::Camera> cam)
     {
         glEnable(GL_DEPTH_TEST);
         glEnable(GL_CULL_FACE);
         glCullFace(GL_FRONT);
         glFrontFace(GL_CCW);
 
+        // One LOD per mesh for every pass, picked from the main camera point of view
+        float lodScale = ComputeLodScale(cam->fov, cam->GetSize().y);
+        glm::vec3 viewPosition = cam->parent->transform->GetPosition();
+        for (auto& [id, caster] : meshes)
+            caster.lod = lodBias > 0.0f ? caster.mesh->SelectLod(caster.model, viewPosition, lodScale, lodBias, lodHysteresis, caster.lod) : 0;
+
         for (auto& sm : shadowMaps)
         {
             LightData* light = &sm.light;
@@ -270,10 +277,11 @@ namespace Epoch::Engine::Rendering{
                     pointShader.setFloat("farPlane", light->radius);
                     pointShader.setVec3("lightPos", light->position);
 
-                    for (const auto& [_, pair] : meshes)
+                    for (const auto& [id, caster] : meshes)
                     {
-                        pointShader.setMat4("model", pair.first);
-                        pair.second->DrawWithoutMaterial();
+                        pointShader.setMat4("model", caster.model);
+                        caster.mesh->SetPositionUniforms(pointShader);
+                        caster.mesh->DrawWithoutMaterial(caster.lod);
                     }
                 }
 
@@ -290,10 +298,11 @@ namespace Epoch::Engine::Rendering{
                 
                 spotShader.setMat4("lightSpaceMatrix", sm.lightMatrix[0]);
 
-                for (const auto& [_, pair] : meshes)
+                for (const auto& [id, caster] : meshes)
                 {
-                    spotShader.setMat4("model", pair.first);
-                    pair.second->DrawWithoutMaterial();
+                    spotShader.setMat4("model", caster.model);
+                    caster.mesh->SetPositionUniforms(spotShader);
+                    caster.mesh->DrawWithoutMaterial(caster.lod);
                 }
 
                 spotShader.Deactivate();
@@ -317,10 +326,11 @@ namespace Epoch::Engine::Rendering{
 
                     dirShader.setMat4("lightSpaceMatrix", sm.lightMatrix[c]);
 
-                    for (const auto& [_, pair] : meshes)
+                    for (const auto& [id, caster] : meshes)
                     {
-                        dirShader.setMat4("model", pair.first);
-                        pair.second->DrawWithoutMaterial();
+                        dirShader.setMat4("model", caster.model);
+                        caster.mesh->SetPositionUniforms(dirShader);
+                        caster.mesh->DrawWithoutMaterial(caster.lod);
                     }
 
                     glBindFramebuffer(GL_FRAMEBUFFER, 0);
@@ -35,15 +35,25 @@ namespace Epoch::Engine::Rendering{
         int resolution = 1024;
     };
 
+    // A mesh drawn in the shadow passes
+    struct ShadowCaster {
+        glm::mat4 model;
+        Mesh* mesh = nullptr;
+        int lod = 0;            // Drawn on the previous frame, kept for the hysteresis of the next selection
+    };
+
     class ShadowManager {
     public:
         void Init(int resolution);
         void RegisterLight(int lightIndex, std::shared_ptr<LightData> light);
         void ResolveShadowMaps();
         void UnregisterLight(int lightIndex);
-        void RenderShadowMaps(const std::unordered_map<int, std::pair<glm::mat4, Rendering::Mesh *>> &meshes, std::shared_ptr<ECS::Components::Camera> cam);
+        void RenderShadowMaps(std::unordered_map<int, ShadowCaster> &meshes, std::shared_ptr<ECS::Components::Camera> cam);
         void BindShadowMaps(std::shared_ptr<Epoch::Engine::Rendering::Material> material);
 
+        float lodBias = 4.0f;   // Maximum projected LOD error (pixels, seen from the main camera), 0 to always draw LOD 0
+        float lodHysteresis = 0.25f;    // Fraction of the bias the error must cross before switching LOD
+
     private:
         std::vector<ShadowMap> shadowMaps;
         Shader dirShader, spotShader, pointShader;
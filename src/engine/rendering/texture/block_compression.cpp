@@ -0,0 +1,402 @@
+#include "block_compression.hpp"
+
+#include "engine/rendering/utils.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+    #define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+    #define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+namespace Epoch::Engine::Rendering::BlockCompression{
+
+    static bool s3tcSupported = false;
+
+    size_t GetBlockBytes(BlockFormat format)
+    {
+        return (format == BlockFormat::BC1 || format == BlockFormat::BC4) ? 8 : 16;
+    }
+
+    size_t GetCompressedSize(BlockFormat format, int width, int height)
+    {
+        return static_cast<size_t>((width + 3) / 4) * static_cast<size_t>((height + 3) / 4) * GetBlockBytes(format);
+    }
+
+    unsigned int GetGLFormat(BlockFormat format)
+    {
+        switch (format) {
+            case BlockFormat::BC1: return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+            case BlockFormat::BC3: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+            case BlockFormat::BC4: return GL_COMPRESSED_RED_RGTC1;
+            case BlockFormat::BC5: return GL_COMPRESSED_RG_RGTC2;
+            case BlockFormat::BC7: return GL_COMPRESSED_RGBA_BPTC_UNORM;
+        }
+        return 0;
+    }
+
+    int GetChannelCount(BlockFormat format)
+    {
+        switch (format) {
+            case BlockFormat::BC1: return 3;
+            case BlockFormat::BC4: return 1;
+            case BlockFormat::BC5: return 2;
+            case BlockFormat::BC3:
+            case BlockFormat::BC7: return 4;
+        }
+        return 0;
+    }
+
+    bool IsValidFormat(uint32_t format)
+    {
+        return format == 1 || format == 3 || format == 4 || format == 5 || format == 7;
+    }
+
+    void DetectSupport()
+    {
+        s3tcSupported = HasGLExtension("GL_EXT_texture_compression_s3tc");
+    }
+
+    bool IsSupported(BlockFormat format)
+    {
+        return (format != BlockFormat::BC1 && format != BlockFormat::BC3) || s3tcSupported;
+    }
+
+    // --- Helpers ---
+
+    /// @brief Principal axis of a set of points (power iteration on the covariance matrix)
+    template<int N>
+    void PrincipalAxis(const float (*points)[N], int count, float mean[N], float axis[N])
+    {
+        for (int c = 0; c < N; c++) {
+            mean[c] = 0.0f;
+            for (int i = 0; i < count; i++)
+                mean[c] += points[i][c];
+            mean[c] /= static_cast<float>(count);
+        }
+
+        float covariance[N][N] = {};
+        for (int i = 0; i < count; i++)
+            for (int a = 0; a < N; a++)
+                for (int b = 0; b < N; b++)
+                    covariance[a][b] += (points[i][a] - mean[a]) * (points[i][b] - mean[b]);
+
+        for (int c = 0; c < N; c++)
+            axis[c] = 1.0f;
+
+        for (int iteration = 0; iteration < 8; iteration++) {
+            float next[N] = {};
+            for (int a = 0; a < N; a++)
+                for (int b = 0; b < N; b++)
+                    next[a] += covariance[a][b] * axis[b];
+
+            float length = 0.0f;
+            for (int c = 0; c < N; c++)
+                length = std::max(length, std::abs(next[c]));
+            if (length <= 1e-8f)
+                break;
+            for (int c = 0; c < N; c++)
+                axis[c] = next[c] / length;
+        }
+    }
+
+    /// @brief Endpoints of a set of points along their principal axis, slightly inset to reduce the error of the extremes
+    template<int N>
+    void ComputeEndpoints(const float (*points)[N], int count, float start[N], float end[N])
+    {
+        float mean[N], axis[N];
+        PrincipalAxis<N>(points, count, mean, axis);
+
+        float minT = 0.0f, maxT = 0.0f;
+        for (int i = 0; i < count; i++) {
+            float t = 0.0f;
+            for (int c = 0; c < N; c++)
+                t += (points[i][c] - mean[c]) * axis[c];
+            minT = i == 0 ? t : std::min(minT, t);
+            maxT = i == 0 ? t : std::max(maxT, t);
+        }
+
+        float axisLengthSquared = 0.0f;
+        for (int c = 0; c < N; c++)
+            axisLengthSquared += axis[c] * axis[c];
+        if (axisLengthSquared > 0.0f) {
+            minT /= axisLengthSquared;
+            maxT /= axisLengthSquared;
+        }
+
+        float inset = (maxT - minT) / 16.0f;
+        minT += inset;
+        maxT -= inset;
+
+        for (int c = 0; c < N; c++) {
+            start[c] = std::clamp(mean[c] + axis[c] * minT, 0.0f, 255.0f);
+            end[c] = std::clamp(mean[c] + axis[c] * maxT, 0.0f, 255.0f);
+        }
+    }
+
+    /// @brief Reads a 4x4 block, clamping at the image borders
+    void FetchBlock(const uint8_t* rgba, int width, int height, int bx, int by, uint8_t block[16][4])
+    {
+        for (int y = 0; y < 4; y++) {
+            int sy = std::min(by * 4 + y, height - 1);
+            for (int x = 0; x < 4; x++) {
+                int sx = std::min(bx * 4 + x, width - 1);
+                std::memcpy(block[y * 4 + x], rgba + (static_cast<size_t>(sy) * width + sx) * 4, 4);
+            }
+        }
+    }
+
+    // --- BC1 ---
+
+    uint16_t PackRGB565(const float color[3])
+    {
+        int r = std::clamp(static_cast<int>(std::round(color[0] * 31.0f / 255.0f)), 0, 31);
+        int g = std::clamp(static_cast<int>(std::round(color[1] * 63.0f / 255.0f)), 0, 63);
+        int b = std::clamp(static_cast<int>(std::round(color[2] * 31.0f / 255.0f)), 0, 31);
+        return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+    }
+
+    void UnpackRGB565(uint16_t packed, int color[3])
+    {
+        int r = (packed >> 11) & 31, g = (packed >> 5) & 63, b = packed & 31;
+        color[0] = (r << 3) | (r >> 2);
+        color[1] = (g << 2) | (g >> 4);
+        color[2] = (b << 3) | (b >> 2);
+    }
+
+    void EncodeBC1(const uint8_t block[16][4], uint8_t* out)
+    {
+        float points[16][3];
+        for (int i = 0; i < 16; i++)
+            for (int c = 0; c < 3; c++)
+                points[i][c] = block[i][c];
+
+        float start[3], end[3];
+        ComputeEndpoints<3>(points, 16, start, end);
+
+        uint16_t color0 = PackRGB565(end);
+        uint16_t color1 = PackRGB565(start);
+
+        // color0 > color1 selects the 4 colors mode
+        if (color0 < color1)
+            std::swap(color0, color1);
+
+        uint32_t indices = 0;
+
+        if (color0 != color1) {
+            int palette[4][3];
+            UnpackRGB565(color0, palette[0]);
+            UnpackRGB565(color1, palette[1]);
+            for (int c = 0; c < 3; c++) {
+                palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+                palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+            }
+
+            for (int i = 0; i < 16; i++) {
+                int best = 0, bestError = INT32_MAX;
+                for (int p = 0; p < 4; p++) {
+                    int error = 0;
+                    for (int c = 0; c < 3; c++) {
+                        int d = block[i][c] - palette[p][c];
+                        error += d * d;
+                    }
+                    if (error < bestError) {
+                        bestError = error;
+                        best = p;
+                    }
+                }
+                indices |= static_cast<uint32_t>(best) << (i * 2);
+            }
+        }
+
+        out[0] = color0 & 0xFF;
+        out[1] = color0 >> 8;
+        out[2] = color1 & 0xFF;
+        out[3] = color1 >> 8;
+        for (int i = 0; i < 4; i++)
+            out[4 + i] = (indices >> (i * 8)) & 0xFF;
+    }
+
+    // --- BC4 (one channel, also the alpha of BC3 and both channels of BC5) ---
+
+    void EncodeBC4(const uint8_t block[16][4], int channel, uint8_t* out)
+    {
+        int minValue = 255, maxValue = 0;
+        for (int i = 0; i < 16; i++) {
+            minValue = std::min<int>(minValue, block[i][channel]);
+            maxValue = std::max<int>(maxValue, block[i][channel]);
+        }
+
+        // a0 > a1 selects the 8 values mode
+        int a0 = maxValue, a1 = minValue;
+        uint64_t indices = 0;
+
+        if (a0 != a1) {
+            int palette[8];
+            palette[0] = a0;
+            palette[1] = a1;
+            for (int p = 2; p < 8; p++)
+                palette[p] = ((8 - p) * a0 + (p - 1) * a1) / 7;
+
+            for (int i = 0; i < 16; i++) {
+                int best = 0, bestError = INT32_MAX;
+                for (int p = 0; p < 8; p++) {
+                    int error = std::abs(block[i][channel] - palette[p]);
+                    if (error < bestError) {
+                        bestError = error;
+                        best = p;
+                    }
+                }
+                indices |= static_cast<uint64_t>(best) << (i * 3);
+            }
+        }
+
+        out[0] = static_cast<uint8_t>(a0);
+        out[1] = static_cast<uint8_t>(a1);
+        for (int i = 0; i < 6; i++)
+            out[2 + i] = (indices >> (i * 8)) & 0xFF;
+    }
+
+    // --- BC7 (mode 6 only : one subset, RGBA 7.7.7.7 endpoints with a P-bit each, 4 bits indices) ---
+
+    struct BitWriter {
+        uint8_t* out;
+        int position = 0;
+
+        void Write(uint32_t value, int bits) {
+            for (int i = 0; i < bits; i++, position++)
+                if (value & (1u << i))
+                    out[position >> 3] |= static_cast<uint8_t>(1u << (position & 7));
+        }
+    };
+
+    void EncodeBC7(const uint8_t block[16][4], uint8_t* out)
+    {
+        static const int weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+        float points[16][4];
+        for (int i = 0; i < 16; i++)
+            for (int c = 0; c < 4; c++)
+                points[i][c] = block[i][c];
+
+        float start[4], end[4];
+        ComputeEndpoints<4>(points, 16, start, end);
+
+        int bestEndpoints[2][4] = {};
+        int bestP[2] = {};
+        int bestIndices[16] = {};
+        long bestError = -1;
+
+        // Every P-bit combination, the endpoints are rounded for each
+        for (int p0 = 0; p0 < 2; p0++) {
+            for (int p1 = 0; p1 < 2; p1++) {
+                int quantized[2][4], expanded[2][4];
+                for (int c = 0; c < 4; c++) {
+                    quantized[0][c] = std::clamp(static_cast<int>(std::round((start[c] - p0) / 2.0f)), 0, 127);
+                    quantized[1][c] = std::clamp(static_cast<int>(std::round((end[c] - p1) / 2.0f)), 0, 127);
+                    expanded[0][c] = (quantized[0][c] << 1) | p0;
+                    expanded[1][c] = (quantized[1][c] << 1) | p1;
+                }
+
+                int palette[16][4];
+                for (int w = 0; w < 16; w++)
+                    for (int c = 0; c < 4; c++)
+                        palette[w][c] = ((64 - weights[w]) * expanded[0][c] + weights[w] * expanded[1][c] + 32) >> 6;
+
+                int indices[16];
+                long error = 0;
+                for (int i = 0; i < 16; i++) {
+                    int best = 0, bestPixelError = INT32_MAX;
+                    for (int w = 0; w < 16; w++) {
+                        int pixelError = 0;
+                        for (int c = 0; c < 4; c++) {
+                            int d = block[i][c] - palette[w][c];
+                            pixelError += d * d;
+                        }
+                        if (pixelError < bestPixelError) {
+                            bestPixelError = pixelError;
+                            best = w;
+                        }
+                    }
+                    indices[i] = best;
+                    error += bestPixelError;
+                }
+
+                if (bestError < 0 || error < bestError) {
+                    bestError = error;
+                    std::memcpy(bestEndpoints, quantized, sizeof(quantized));
+                    bestP[0] = p0;
+                    bestP[1] = p1;
+                    std::memcpy(bestIndices, indices, sizeof(indices));
+                }
+            }
+        }
+
+        // The anchor index is stored without its high bit, so it has to be under 8
+        if (bestIndices[0] >= 8) {
+            for (int c = 0; c < 4; c++)
+                std::swap(bestEndpoints[0][c], bestEndpoints[1][c]);
+            std::swap(bestP[0], bestP[1]);
+            for (int i = 0; i < 16; i++)
+                bestIndices[i] = 15 - bestIndices[i];
+        }
+
+        std::memset(out, 0, 16);
+        BitWriter writer{ out };
+        writer.Write(1u << 6, 7);
+        for (int c = 0; c < 4; c++) {
+            writer.Write(bestEndpoints[0][c], 7);
+            writer.Write(bestEndpoints[1][c], 7);
+        }
+        writer.Write(bestP[0], 1);
+        writer.Write(bestP[1], 1);
+        for (int i = 0; i < 16; i++)
+            writer.Write(bestIndices[i], i == 0 ? 3 : 4);
+    }
+
+    /// @brief Encodes an RGBA8 image, rows in order, into blocks of the given format
+    /// @return The blocks, row by row
+    std::vector<uint8_t> Compress(const uint8_t *rgba, int width, int height, BlockFormat format)
+    {
+        int blocksX = (width + 3) / 4;
+        int blocksY = (height + 3) / 4;
+        size_t blockBytes = GetBlockBytes(format);
+
+        std::vector<uint8_t> result(static_cast<size_t>(blocksX) * blocksY * blockBytes);
+
+        for (int by = 0; by < blocksY; by++) {
+            for (int bx = 0; bx < blocksX; bx++) {
+                uint8_t block[16][4];
+                FetchBlock(rgba, width, height, bx, by, block);
+
+                uint8_t* out = result.data() + (static_cast<size_t>(by) * blocksX + bx) * blockBytes;
+
+                switch (format) {
+                    case BlockFormat::BC1:
+                        EncodeBC1(block, out);
+                        break;
+                    case BlockFormat::BC3:
+                        EncodeBC4(block, 3, out);
+                        EncodeBC1(block, out + 8);
+                        break;
+                    case BlockFormat::BC4:
+                        EncodeBC4(block, 0, out);
+                        break;
+                    case BlockFormat::BC5:
+                        EncodeBC4(block, 0, out);
+                        EncodeBC4(block, 1, out + 8);
+                        break;
+                    case BlockFormat::BC7:
+                        EncodeBC7(block, out);
+                        break;
+                }
+            }
+        }
+
+        return result;
+    }
+}
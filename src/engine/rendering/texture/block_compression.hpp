@@ -0,0 +1,36 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace Epoch::Engine::Rendering::BlockCompression{
+
+    // Values match the BCn numbers, stored as is in cooked textures
+    enum class BlockFormat : uint32_t {
+        BC1 = 1,    // RGB, 4 bits per pixel
+        BC3 = 3,    // RGBA, 8 bits per pixel
+        BC4 = 4,    // R, 4 bits per pixel
+        BC5 = 5,    // RG, 8 bits per pixel (normal maps)
+        BC7 = 7     // RGBA, 8 bits per pixel, higher quality than BC1/BC3
+    };
+
+    size_t GetBlockBytes(BlockFormat format);
+
+    size_t GetCompressedSize(BlockFormat format, int width, int height);
+
+    unsigned int GetGLFormat(BlockFormat format);
+
+    /// @brief Channels a format stores, 2 for BC5 whatever the source image had
+    int GetChannelCount(BlockFormat format);
+
+    bool IsValidFormat(uint32_t format);
+
+    /// @brief Queries the formats the driver can sample, GL thread only, before cooked textures are loaded
+    void DetectSupport();
+
+    /// @brief BC4, BC5 and BC7 are core GL, BC1 and BC3 need GL_EXT_texture_compression_s3tc
+    bool IsSupported(BlockFormat format);
+
+    std::vector<uint8_t> Compress(const uint8_t* rgba, int width, int height, BlockFormat format);
+}
@@ -2,8 +2,11 @@
 
 #include "engine/filesystem/filesystem.hpp"
 #include "engine/rendering/renderer/renderer.hpp"
+#include "engine/rendering/upload/upload_queue.hpp"
 
 #include <iostream>
+#include <algorithm>
+#include <cstring>
 
 namespace Epoch::Engine::Rendering{
 
@@ -14,10 +17,62 @@ namespace Epoch::Engine::Rendering{
         Init(filepath);
     }
 
+    /// @brief Builds a texture from pixels already decoded with Decode
+    Texture::Texture(Filesystem::Path filepath, std::shared_ptr<const TextureData> data)
+    {
+        infos.filepath = std::make_shared<Filesystem::Path>(filepath);
+        Upload(std::move(data));
+    }
+
+    Texture::~Texture()
+    {
+        // Textures still owned after the window is gone have nothing left to release
+        if (glfwGetCurrentContext())
+            Cleanup();
+    }
+
     void Texture::Init(Filesystem::Path filepath)
     {
         infos.filepath = std::make_shared<Filesystem::Path>(filepath);
 
+        std::shared_ptr<TextureData> data = std::make_shared<TextureData>();
+        Decode(filepath, *data);
+        Upload(data);
+    }
+
+    /// @brief Reads and decodes an image file, without any GL call so it can run on a worker thread
+    /// @param filepath The image to decode
+    /// @param data The decoded pixels
+    /// @return False if the file is missing or can't be decoded
+    bool Texture::Decode(const Filesystem::Path &filepath, TextureData &data)
+    {
+        if (!filepath.Exists()) {
+            DEBUG_ERROR("Couldn't find texture : " + filepath.full);
+            return false;
+        }
+
+        std::string file = filepath.ReadFile();
+
+        stbi_set_flip_vertically_on_load_thread(true);
+        data.pixels.reset(stbi_load_from_memory(reinterpret_cast<const unsigned char*>(file.data()),
+                                        static_cast<int>(file.size()),
+                                        &data.width, &data.height, &data.nrChannels, 0));
+
+        if (!data.pixels) {
+            DEBUG_ERROR("Couldn't load texture : " + filepath.full);
+            return false;
+        }
+
+        return true;
+    }
+
+    /// @brief Queues the pixels on the upload queue, the texture stays a 1x1 grey placeholder until they land
+    void Texture::Upload(std::shared_ptr<const TextureData> data)
+    {
+        infos.width = data->width;
+        infos.height = data->height;
+        infos.nrChannels = data->nrChannels;
+
         // Load and set up the texture
         glGenTextures(1, &ID);
         glBindTexture(GL_TEXTURE_2D, ID);
@@ -28,47 +83,347 @@ namespace Epoch::Engine::Rendering{
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR_MIPMAP_LINEAR);
 
-        unsigned char* data = nullptr;
+        if (!data->pixels)
+            return;
+
+        GLenum format;
+        if (data->nrChannels == 1){
+            format = GL_RED;
+        }
+        else if (data->nrChannels == 2){
+            format = GL_RG;
+        }
+        else if (data->nrChannels == 3){
+            format = GL_RGB;
+        }
+        else if (data->nrChannels == 4){
+            format = GL_RGBA;
+        }
+        else{
+            format = GL_RGB; // Default to RGB
+        }
+
+        const unsigned char grey[4] = { 128, 128, 128, 255 };
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, grey);
+
+        UploadRequest request;
+        request.target = UploadRequest::Target::Texture2D;
+        request.object = ID;
+        request.width = data->width;
+        request.height = data->height;
+        request.format = format;
+        request.data = data->pixels.get();
+        request.size = static_cast<size_t>(data->width) * data->height * data->nrChannels;
+        request.keepAlive = data;
+        request.owner = this;
+        request.onComplete = [this]() {
+            glBindTexture(GL_TEXTURE_2D, ID);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 1000);
+            glGenerateMipmap(GL_TEXTURE_2D);
+        };
+        UploadQueue::GetInstance().Submit(std::move(request));
+    }
+
+    /// @brief Creates a 1x1 grey texture, replaced by SetMipChain once the file is decoded
+    std::shared_ptr<Texture> Texture::CreatePlaceholder(Filesystem::Path filepath)
+    {
+        std::shared_ptr<Texture> texture(new Texture());
+        texture->infos.filepath = std::make_shared<Filesystem::Path>(filepath);
+        texture->InitPlaceholder();
+
+        return texture;
+    }
+
+    void Texture::InitPlaceholder()
+    {
+        infos.width = infos.height = 1;
+        infos.nrChannels = 4;
+
+        const unsigned char grey[4] = { 128, 128, 128, 255 };
+
+        glGenTextures(1, &ID);
+        glBindTexture(GL_TEXTURE_2D, ID);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, grey);
+    }
+
+    /// @brief Replaces the content of a loaded texture, the texture object itself stays valid for the materials using it.
+    /// The GL texture is recreated so the levels of the previous content still on the upload queue are dropped
+    void Texture::Reload(std::shared_ptr<const TextureData> data)
+    {
+        Cleanup();
+        mipChain.reset();
+        residentMip = baseMip = 0;
+        Upload(std::move(data));
+    }
+
+    /// @brief Replaces the content of a loaded texture with a mip chain, see SetMipChain
+    void Texture::Reload(std::shared_ptr<const TextureMipChain> chain, int firstResidentMip)
+    {
+        Cleanup();
+        mipChain.reset();
+        residentMip = baseMip = 0;
+        InitPlaceholder();
+        SetMipChain(std::move(chain), firstResidentMip);
+    }
+
+    /// @brief Builds the full mip chain of decoded pixels with a box filter, without any GL call so it can run on a worker thread
+    std::shared_ptr<TextureMipChain> Texture::BuildMipChain(const TextureData &data)
+    {
+        return BuildMipChain(data.pixels.get(), data.width, data.height, data.nrChannels);
+    }
+
+    std::shared_ptr<TextureMipChain> Texture::BuildMipChain(const unsigned char *pixels, int width, int height, int nrChannels)
+    {
+        if (!pixels || width <= 0 || height <= 0)
+            return nullptr;
+
+        std::shared_ptr<TextureMipChain> chain = std::make_shared<TextureMipChain>();
+        chain->width = width;
+        chain->height = height;
+        chain->nrChannels = nrChannels;
+
+        const int channels = nrChannels;
+        chain->storage.emplace_back(pixels, pixels + static_cast<size_t>(width) * height * channels);
+
+        for (int level = 1; chain->GetLevelWidth(level - 1) > 1 || chain->GetLevelHeight(level - 1) > 1; level++) {
+            const std::vector<unsigned char>& source = chain->storage[level - 1];
+            int srcWidth = chain->GetLevelWidth(level - 1);
+            int srcHeight = chain->GetLevelHeight(level - 1);
+            int dstWidth = chain->GetLevelWidth(level);
+            int dstHeight = chain->GetLevelHeight(level);
+
+            std::vector<unsigned char> destination(static_cast<size_t>(dstWidth) * dstHeight * channels);
+
+            for (int y = 0; y < dstHeight; y++) {
+                int y0 = std::min(y * 2, srcHeight - 1);
+                int y1 = std::min(y * 2 + 1, srcHeight - 1);
+
+                for (int x = 0; x < dstWidth; x++) {
+                    int x0 = std::min(x * 2, srcWidth - 1);
+                    int x1 = std::min(x * 2 + 1, srcWidth - 1);
+
+                    for (int c = 0; c < channels; c++) {
+                        int sum = source[(static_cast<size_t>(y0) * srcWidth + x0) * channels + c]
+                                + source[(static_cast<size_t>(y0) * srcWidth + x1) * channels + c]
+                                + source[(static_cast<size_t>(y1) * srcWidth + x0) * channels + c]
+                                + source[(static_cast<size_t>(y1) * srcWidth + x1) * channels + c];
+                        destination[(static_cast<size_t>(y) * dstWidth + x) * channels + c] = static_cast<unsigned char>((sum + 2) / 4);
+                    }
+                }
+            }
+
+            chain->storage.push_back(std::move(destination));
+        }
+
+        for (const std::vector<unsigned char>& level : chain->storage)
+            chain->levels.push_back(TextureMipChain::Level{ level.data(), level.size() });
+
+        return chain;
+    }
+
+    /// @brief Writes the levels [firstMip, last] of a chain into the upload ring, from the worker that built it.
+    /// Levels are staged from the coarsest and it stops when the ring is full, so they still land coarsest first
+    /// @return The regions, indexed by level, invalid for the levels left to the GL thread
+    std::vector<StagingAllocation> Texture::StageMips(const TextureMipChain &chain, int firstMip)
+    {
+        std::vector<StagingAllocation> staged(chain.levels.size());
 
-        if (infos.filepath->Exists()) {
-            std::string file = infos.filepath->ReadFile();
-            
-            stbi_set_flip_vertically_on_load(true);
-            data = stbi_load_from_memory(reinterpret_cast<const unsigned char*>(file.data()),
-                                            static_cast<int>(file.size()),
-                                            &infos.width, &infos.height, &infos.nrChannels, 0);
+        for (int level = static_cast<int>(chain.levels.size()) - 1; level >= std::max(firstMip, 0); level--) {
+            const TextureMipChain::Level& mip = chain.levels[level];
+            staged[level] = UploadQueue::GetInstance().Reserve(mip.size);
+            if (!staged[level].IsValid())
+                break;
+            std::memcpy(staged[level].data, mip.data, mip.size);
+        }
 
-        } else {
-            DEBUG_ERROR("Couldn't find texture : " + infos.filepath->full);
+        return staged;
+    }
+
+    /// @brief Replaces the placeholder with the levels [firstResidentMip, last] of a mip chain
+    void Texture::SetMipChain(std::shared_ptr<const TextureMipChain> chain, int firstResidentMip)
+    {
+        SetMipChain(std::move(chain), firstResidentMip, {});
+    }
+
+    /// @param staged The levels already written into the upload ring, see StageMips
+    void Texture::SetMipChain(std::shared_ptr<const TextureMipChain> chain, int firstResidentMip, const std::vector<StagingAllocation>& staged)
+    {
+        if (!chain) {
+            for (const StagingAllocation& allocation : staged)
+                UploadQueue::GetInstance().Release(allocation);
             return;
         }
 
-        if (data) {
-            GLenum format;
-            if (infos.nrChannels == 1){
-                format = GL_RED;
-            }
-            else if (infos.nrChannels == 2){
-                format = GL_RG;
-            }
-            else if (infos.nrChannels == 3){
-                format = GL_RGB;
-            }
-            else if (infos.nrChannels == 4){
-                format = GL_RGBA;
-            }
-            else{
-                format = GL_RGB; // Default to RGB
+        mipChain = std::move(chain);
+        infos.width = mipChain->width;
+        infos.height = mipChain->height;
+        infos.nrChannels = mipChain->nrChannels;
+
+        glBindTexture(GL_TEXTURE_2D, ID);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+        int lastMip = GetMipCount() - 1;
+        residentMip = std::clamp(firstResidentMip, 0, lastMip);
+
+        // The placeholder stays the only sampled level until the coarsest mip lands, see OnMipUploaded
+        baseMip = lastMip + 1;
+
+        for (int level = lastMip; level >= residentMip; level--)
+            UploadMip(level, level < static_cast<int>(staged.size()) && staged[level].IsValid() ? &staged[level] : nullptr);
+
+        // Staged past the clamped range
+        for (int level = 0; level < std::min(residentMip, static_cast<int>(staged.size())); level++)
+            UploadQueue::GetInstance().Release(staged[level]);
+    }
+
+    /// @brief GPU memory of the texture (resident levels of a streamed texture) and the part of the mip chain kept in memory
+    size_t Texture::GetMemoryBytes() const
+    {
+        if (mipChain)
+            return GetResidentBytes() + mipChain->GetStorageBytes();
+
+        // Full chain generated by glGenerateMipmap
+        return static_cast<size_t>(infos.width) * infos.height * infos.nrChannels * 4 / 3;
+    }
+
+    size_t Texture::GetResidentBytes() const
+    {
+        size_t bytes = 0;
+        for (int level = residentMip; level < GetMipCount(); level++)
+            bytes += GetMipBytes(level);
+        return bytes;
+    }
+
+    /// @brief Queues the next finer mip level, it becomes the base level once uploaded. Its data must be in memory, see RestoreMipData
+    void Texture::StreamIn()
+    {
+        if (!mipChain || residentMip == 0 || !HasMipData(residentMip - 1))
+            return;
+
+        residentMip--;
+        UploadMip(residentMip);
+    }
+
+    /// @brief Releases the finest resident mip level, the next one becomes the base level
+    void Texture::StreamOut()
+    {
+        if (!mipChain || residentMip >= GetMipCount() - 1)
+            return;
+
+        glBindTexture(GL_TEXTURE_2D, ID);
+
+        // Levels still queued are released when they land
+        if (baseMip <= residentMip) {
+            baseMip = residentMip + 1;
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, baseMip);
+            ReleaseMip(residentMip);
+        }
+        residentMip++;
+    }
+
+    /// @brief Drops the CPU copy of the levels finer than "keepMip" (the mapping of a cooked texture with them), the streamer reads
+    /// them again from the file before streaming them back in. Copies still on the upload queue keep the previous chain alive
+    void Texture::ReleaseMipData(int keepMip)
+    {
+        if (!mipChain || keepMip <= 0 || !HasMipData(0))
+            return;
+
+        keepMip = std::min(keepMip, GetMipCount() - 1);
+
+        std::shared_ptr<TextureMipChain> chain = std::make_shared<TextureMipChain>();
+        chain->width = mipChain->width;
+        chain->height = mipChain->height;
+        chain->nrChannels = mipChain->nrChannels;
+        chain->compressedFormat = mipChain->compressedFormat;
+        chain->levels.resize(mipChain->levels.size());
+        chain->storage.reserve(mipChain->levels.size() - keepMip);
+
+        for (int level = 0; level < GetMipCount(); level++) {
+            const TextureMipChain::Level& mip = mipChain->levels[level];
+            if (level < keepMip) {
+                chain->levels[level] = TextureMipChain::Level{ nullptr, mip.size };
+                continue;
             }
 
-            glTexImage2D(GL_TEXTURE_2D, 0, format, infos.width, infos.height, 0, format, GL_UNSIGNED_BYTE, data);
-            glGenerateMipmap(GL_TEXTURE_2D);
-        } else {
-            DEBUG_ERROR("Couldn't load texture : " + filepath.full);   
+            chain->storage.emplace_back(mip.data, mip.data + mip.size);
+            chain->levels[level] = TextureMipChain::Level{ chain->storage.back().data(), mip.size };
         }
 
-        stbi_image_free(data);
-        return;
+        mipChain = std::move(chain);
+    }
+
+    /// @brief Puts back the levels dropped by ReleaseMipData, read again from the file
+    /// @return False if the chain doesn't match the current one, the file changed since it was loaded
+    bool Texture::RestoreMipData(std::shared_ptr<const TextureMipChain> chain)
+    {
+        if (!mipChain || !chain || chain->width != mipChain->width || chain->height != mipChain->height
+            || chain->nrChannels != mipChain->nrChannels || chain->compressedFormat != mipChain->compressedFormat || chain->levels.size() != mipChain->levels.size())
+            return false;
+
+        mipChain = std::move(chain);
+        return true;
+    }
+
+    void Texture::ReleaseMip(int level)
+    {
+        if (mipChain->compressedFormat != 0) {
+            glCompressedTexImage2D(GL_TEXTURE_2D, level, mipChain->compressedFormat, 0, 0, 0, 0, nullptr);
+        }
+        else {
+            GLenum format = mipChain->nrChannels == 1 ? GL_RED : mipChain->nrChannels == 2 ? GL_RG : mipChain->nrChannels == 4 ? GL_RGBA : GL_RGB;
+            glTexImage2D(GL_TEXTURE_2D, level, format, 0, 0, 0, format, GL_UNSIGNED_BYTE, nullptr);
+        }
+    }
+
+    /// @param staging The level already written into the upload ring, null to let the upload queue copy it
+    void Texture::UploadMip(int level, const StagingAllocation* staging)
+    {
+        const TextureMipChain::Level& mip = mipChain->levels[level];
+
+        UploadRequest request;
+        request.target = UploadRequest::Target::Texture2D;
+        request.object = ID;
+        request.level = level;
+        request.width = mipChain->GetLevelWidth(level);
+        request.height = mipChain->GetLevelHeight(level);
+        request.compressed = mipChain->compressedFormat != 0;
+        request.format = request.compressed ? mipChain->compressedFormat
+                       : mipChain->nrChannels == 1 ? GL_RED : mipChain->nrChannels == 2 ? GL_RG : mipChain->nrChannels == 4 ? GL_RGBA : GL_RGB;
+        request.data = mip.data;
+        request.size = mip.size;
+        request.keepAlive = mipChain;
+        if (staging)
+            request.staging = *staging;
+        request.owner = this;
+        request.onComplete = [this, level]() { OnMipUploaded(level); };
+        UploadQueue::GetInstance().Submit(std::move(request));
+    }
+
+    /// @brief Levels land from the coarsest to the finest, each one becomes the base level unless it was evicted meanwhile
+    void Texture::OnMipUploaded(int level)
+    {
+        glBindTexture(GL_TEXTURE_2D, ID);
+
+        if (level < residentMip) {
+            ReleaseMip(level);
+            return;
+        }
+
+        if (level >= baseMip)
+            return;
+
+        // First level of the chain, the 1x1 placeholder in level 0 is no longer sampled (or was just replaced)
+        if (baseMip == GetMipCount())
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, GetMipCount() - 1);
+
+        baseMip = level;
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, baseMip);
     }
 
     void Texture::Bind(int unit)
@@ -85,11 +440,13 @@ namespace Epoch::Engine::Rendering{
 
     void Texture::Cleanup()
     {
+        // The queued copies and their callbacks point to this texture
+        UploadQueue::GetInstance().Cancel(this);
         glDeleteTextures(1, &ID);
 
         glDeleteVertexArrays(1, &VAO);
         glDeleteBuffers(1, &VBO);
         glDeleteBuffers(1, &EBO);
-        VAO = VBO = EBO = 0;
+        ID = VAO = VBO = EBO = 0;
     }
 }
\ No newline at end of file
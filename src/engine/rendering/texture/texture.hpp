@@ -6,15 +6,18 @@
 #include <stb/stb_image_resize2.h>
 #include <string>
 #include <memory>
+#include <vector>
 
 namespace Epoch::Engine::Filesystem{
 
     class Path;
+    class MappedFile;
 }
 
 namespace Epoch::Engine::Rendering {
 
     struct DrawCommand;
+    struct StagingAllocation;
 
     struct TextureInfos{
         int width, height;         
@@ -22,20 +25,90 @@ namespace Epoch::Engine::Rendering {
         std::shared_ptr<Filesystem::Path> filepath;
     };
 
+    // Decoded pixels, produced off the GL thread by Texture::Decode
+    struct TextureData{
+        int width = 0, height = 0;
+        int nrChannels = 0;
+        std::unique_ptr<unsigned char, void(*)(void*)> pixels{ nullptr, stbi_image_free };
+    };
+
+    // Every mip level of a streamed or cooked texture, finest first
+    struct TextureMipChain{
+        struct Level {
+            const unsigned char* data = nullptr;
+            size_t size = 0;
+        };
+
+        int width = 0, height = 0;
+        int nrChannels = 0;                     // Of the levels, 2 for a normal map cooked to BC5
+        unsigned int compressedFormat = 0;      // GL block compressed format of the levels, 0 for 8 bits pixels
+        std::vector<Level> levels;
+
+        std::vector<std::vector<unsigned char>> storage;            // Owns the levels built in memory
+        std::shared_ptr<const Filesystem::MappedFile> mapping;      // Owns the levels of a cooked texture
+
+        int GetLevelWidth(int level) const { return width >> level > 0 ? width >> level : 1; }
+        int GetLevelHeight(int level) const { return height >> level > 0 ? height >> level : 1; }
+        size_t GetLevelBytes(int level) const { return levels[level].size; }
+        size_t GetStorageBytes() const {
+            size_t bytes = 0;
+            for (const std::vector<unsigned char>& level : storage)
+                bytes += level.size();
+            return bytes;
+        }
+    };
+
     class Texture{
         public:
         Texture(Filesystem::Path filepath);
+        Texture(Filesystem::Path filepath, std::shared_ptr<const TextureData> data);
+        ~Texture();
         void Init(Filesystem::Path filepath);
+        static bool Decode(const Filesystem::Path& filepath, TextureData& data);
         void Bind(int unit);
         void UnBind(int unit);
         void Cleanup();
         unsigned int GetID() { return ID; }
         TextureInfos* GetInfos() { return &infos; }
 
+        // Streaming : the texture starts as a 1x1 placeholder, then only a range of its mip chain is resident
+        static std::shared_ptr<Texture> CreatePlaceholder(Filesystem::Path filepath);
+        static std::shared_ptr<TextureMipChain> BuildMipChain(const TextureData& data);
+        static std::shared_ptr<TextureMipChain> BuildMipChain(const unsigned char* pixels, int width, int height, int nrChannels);
+        static std::vector<StagingAllocation> StageMips(const TextureMipChain& chain, int firstMip);
+        void SetMipChain(std::shared_ptr<const TextureMipChain> chain, int firstResidentMip);
+        void SetMipChain(std::shared_ptr<const TextureMipChain> chain, int firstResidentMip, const std::vector<StagingAllocation>& staged);
+        bool IsStreamed() const { return mipChain != nullptr; }
+        int GetMipCount() const { return mipChain ? static_cast<int>(mipChain->levels.size()) : 1; }
+        int GetResidentMip() const { return residentMip; }
+        size_t GetMipBytes(int level) const { return mipChain ? mipChain->GetLevelBytes(level) : 0; }
+        bool HasMipData(int level) const { return mipChain && mipChain->levels[level].data != nullptr; }
+        size_t GetResidentBytes() const;
+        size_t GetMemoryBytes() const;
+        void StreamIn();
+        void StreamOut();
+        void ReleaseMipData(int keepMip);
+        bool RestoreMipData(std::shared_ptr<const TextureMipChain> chain);
+
+        // Hot reload
+        void Reload(std::shared_ptr<const TextureData> data);
+        void Reload(std::shared_ptr<const TextureMipChain> chain, int firstResidentMip);
+
         private:
-        unsigned int ID;
+        Texture() = default;
+        void InitPlaceholder();
+        void Upload(std::shared_ptr<const TextureData> data);
+        void UploadMip(int level, const StagingAllocation* staging = nullptr);
+        void OnMipUploaded(int level);
+        void ReleaseMip(int level);
+
+        std::shared_ptr<const TextureMipChain> mipChain;
+        int residentMip = 0;    // Finest level uploaded or queued on the upload queue
+        int baseMip = 0;        // Finest level on the GPU, GL_TEXTURE_BASE_LEVEL
+
+        unsigned int ID = 0;
         TextureInfos infos;
-        unsigned int VAO, VBO, EBO;
+        unsigned int VAO = 0, VBO = 0, EBO = 0;
         unsigned int indices[6] = { 0, 1, 2, 2, 3, 0 };
     };
 }
\ No newline at end of file
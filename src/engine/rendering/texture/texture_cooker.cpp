@@ -0,0 +1,209 @@
+#include "texture_cooker.hpp"
+
+#include "engine/filesystem/mapped_file.hpp"
+#include "engine/core/jobs/job_system.hpp"
+#include "engine/debugging/debugger.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <atomic>
+#include <cctype>
+
+namespace Epoch::Engine::Rendering{
+
+    using namespace Filesystem;
+    using namespace BlockCompression;
+
+    Path TextureCooker::GetCookedPath(const Path &source)
+    {
+        return Path(source.full + ".ctex");
+    }
+
+    /// @brief Checks if a source image has a cooked version at least as recent as itself
+    bool TextureCooker::IsUpToDate(const Path &source)
+    {
+        Path cooked = GetCookedPath(source);
+        if (!cooked.Exists())
+            return false;
+
+        if (source.IsPacked() || !source.Exists())
+            return true;
+
+        std::error_code error;
+        auto sourceTime = std::filesystem::last_write_time(source.full, error);
+        if (error)
+            return true;
+        auto cookedTime = std::filesystem::last_write_time(cooked.full, error);
+        return !error && cookedTime >= sourceTime;
+    }
+
+    /// @brief Picks the block format of an image : BC5 for normal maps (from their name), BC4/BC5 for 1 and 2 channels,
+    /// BC1 for opaque colors and BC3 when the alpha is used (BC7 for both in high quality)
+    BlockFormat TextureCooker::ChooseFormat(const Path &source, const TextureData &data, bool highQuality)
+    {
+        std::string name = source.GetFilename(false);
+        std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+        auto endsWith = [&name](const std::string& suffix) {
+            return name.size() >= suffix.size() && name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0;
+        };
+
+        bool normalMap = name.find("normal") != std::string::npos || endsWith("_n") || endsWith("_nrm") || endsWith("_norm");
+        if (normalMap || data.nrChannels == 2)
+            return BlockFormat::BC5;
+        if (data.nrChannels == 1)
+            return BlockFormat::BC4;
+
+        bool alpha = false;
+        if (data.nrChannels == 4) {
+            size_t pixelCount = static_cast<size_t>(data.width) * data.height;
+            for (size_t i = 0; i < pixelCount && !alpha; i++)
+                alpha = data.pixels.get()[i * 4 + 3] != 255;
+        }
+
+        if (highQuality)
+            return BlockFormat::BC7;
+        return alpha ? BlockFormat::BC3 : BlockFormat::BC1;
+    }
+
+    /// @brief Decodes an image, builds its mip chain and writes it block compressed
+    /// @return False if the image can't be decoded or the file can't be written
+    bool TextureCooker::Cook(const Path &source, const Path &destination, const TextureCookSettings &settings)
+    {
+        TextureData data;
+        if (!Texture::Decode(source, data))
+            return false;
+
+        BlockFormat format = ChooseFormat(source, data, settings.highQuality);
+
+        // The encoders read RGBA
+        size_t pixelCount = static_cast<size_t>(data.width) * data.height;
+        std::vector<unsigned char> rgba(pixelCount * 4);
+        for (size_t i = 0; i < pixelCount; i++) {
+            const unsigned char* pixel = data.pixels.get() + i * data.nrChannels;
+            rgba[i * 4 + 0] = pixel[0];
+            rgba[i * 4 + 1] = data.nrChannels > 1 ? pixel[1] : pixel[0];
+            rgba[i * 4 + 2] = data.nrChannels > 2 ? pixel[2] : pixel[0];
+            rgba[i * 4 + 3] = data.nrChannels > 3 ? pixel[3] : 255;
+        }
+
+        std::shared_ptr<TextureMipChain> chain = Texture::BuildMipChain(rgba.data(), data.width, data.height, 4);
+        if (!chain)
+            return false;
+
+        CookedTextureHeader header{};
+        std::memcpy(header.magic, "ETEX", 4);
+        header.version = COOKED_TEXTURE_VERSION;
+        header.format = static_cast<uint32_t>(format);
+        header.width = static_cast<uint32_t>(data.width);
+        header.height = static_cast<uint32_t>(data.height);
+        header.mipCount = static_cast<uint32_t>(chain->levels.size());
+        header.nrChannels = static_cast<uint32_t>(data.nrChannels);
+
+        std::vector<CookedMipEntry> entries(header.mipCount);
+        std::vector<std::vector<uint8_t>> blocks(header.mipCount);
+
+        size_t offset = sizeof(CookedTextureHeader) + entries.size() * sizeof(CookedMipEntry);
+        for (uint32_t level = 0; level < header.mipCount; level++) {
+            blocks[level] = Compress(chain->levels[level].data, chain->GetLevelWidth(level), chain->GetLevelHeight(level), format);
+
+            offset = (offset + 15) & ~size_t(15);
+            entries[level] = CookedMipEntry{ offset, blocks[level].size() };
+            offset += blocks[level].size();
+        }
+
+        std::string content(offset, '\0');
+        std::memcpy(content.data(), &header, sizeof(header));
+        std::memcpy(content.data() + sizeof(header), entries.data(), entries.size() * sizeof(CookedMipEntry));
+        for (uint32_t level = 0; level < header.mipCount; level++)
+            std::memcpy(content.data() + entries[level].offset, blocks[level].data(), blocks[level].size());
+
+        if (!destination.WriteFile(content)) {
+            DEBUG_ERROR("Can't write cooked texture : " + destination.full);
+            return false;
+        }
+
+        DEBUG_LOG("Cooked " + source.full + " (BC" + std::to_string(header.format) + ", " + std::to_string(header.mipCount) + " mips) : "
+            + std::to_string(pixelCount * data.nrChannels) + " -> " + std::to_string(blocks[0].size()) + " bytes for mip 0");
+        return true;
+    }
+
+    /// @brief Cooks every outdated image of a directory and its subdirectories, in parallel on the job system
+    /// @return The number of cooked images
+    size_t TextureCooker::CookDirectory(const Path &directory, const TextureCookSettings &settings)
+    {
+        Core::Jobs::JobSystem& jobs = Core::Jobs::JobSystem::GetInstance();
+
+        std::vector<Core::Jobs::JobHandle> handles;
+        std::atomic<size_t> cooked = 0;
+
+        for (const FileInfo& infos : FileManager::ListDirectory(directory, {Type::T_IMAGE}, false, true)) {
+            if (!settings.force && IsUpToDate(infos.path))
+                continue;
+
+            Path source = infos.path;
+            handles.push_back(jobs.Schedule([source, settings, &cooked]() {
+                if (Cook(source, GetCookedPath(source), settings))
+                    cooked++;
+            }));
+        }
+
+        jobs.WaitAll(handles);
+
+        DEBUG_INFO("Cooked " + std::to_string(cooked.load()) + " textures in " + directory.full);
+        return cooked.load();
+    }
+
+    /// @brief Maps a cooked texture, the levels point straight into the mapping
+    /// @return The mip chain, or nullptr if the file is missing, invalid or in a format the driver can't sample
+    std::shared_ptr<TextureMipChain> TextureCooker::Load(const Path &path)
+    {
+        std::shared_ptr<MappedFile> file = MappedFile::Open(path);
+        if (!file)
+            return nullptr;
+
+        if (file->GetSize() < sizeof(CookedTextureHeader)) {
+            DEBUG_ERROR("Invalid cooked texture : " + path.full);
+            return nullptr;
+        }
+
+        CookedTextureHeader header;
+        std::memcpy(&header, file->GetData(), sizeof(header));
+
+        if (std::memcmp(header.magic, "ETEX", 4) != 0 || header.version != COOKED_TEXTURE_VERSION || !IsValidFormat(header.format)
+            || header.mipCount == 0 || sizeof(CookedTextureHeader) + header.mipCount * sizeof(CookedMipEntry) > file->GetSize()) {
+            DEBUG_ERROR("Invalid cooked texture : " + path.full);
+            return nullptr;
+        }
+
+        // The caller decodes the source image instead
+        if (!IsSupported(static_cast<BlockFormat>(header.format))) {
+            DEBUG_WARNING("Block format of cooked texture not supported by the driver, ignoring it : " + path.full);
+            return nullptr;
+        }
+
+        std::shared_ptr<TextureMipChain> chain = std::make_shared<TextureMipChain>();
+        chain->width = static_cast<int>(header.width);
+        chain->height = static_cast<int>(header.height);
+        chain->nrChannels = GetChannelCount(static_cast<BlockFormat>(header.format));
+        chain->compressedFormat = GetGLFormat(static_cast<BlockFormat>(header.format));
+
+        const CookedMipEntry* entries = reinterpret_cast<const CookedMipEntry*>(file->GetData() + sizeof(CookedTextureHeader));
+
+        for (uint32_t level = 0; level < header.mipCount; level++) {
+            CookedMipEntry entry;
+            std::memcpy(&entry, entries + level, sizeof(entry));
+
+            size_t expected = GetCompressedSize(static_cast<BlockFormat>(header.format), chain->GetLevelWidth(level), chain->GetLevelHeight(level));
+            if (entry.size != expected || entry.offset > file->GetSize() || entry.size > file->GetSize() - entry.offset) {
+                DEBUG_ERROR("Corrupted mip " + std::to_string(level) + " in cooked texture : " + path.full);
+                return nullptr;
+            }
+
+            chain->levels.push_back(TextureMipChain::Level{ file->GetData() + entry.offset, static_cast<size_t>(entry.size) });
+        }
+
+        chain->mapping = file;
+        return chain;
+    }
+}
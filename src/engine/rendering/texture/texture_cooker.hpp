@@ -0,0 +1,48 @@
+#pragma once
+
+#include "engine/rendering/texture/texture.hpp"
+#include "engine/rendering/texture/block_compression.hpp"
+#include "engine/filesystem/filesystem.hpp"
+
+#include <cstdint>
+
+namespace Epoch::Engine::Rendering{
+
+    // .ctex layout : header, one CookedMipEntry per level (finest first), then the 16 bytes aligned block data
+    struct CookedTextureHeader {
+        char magic[4];          // "ETEX"
+        uint32_t version;
+        uint32_t format;        // BlockCompression::BlockFormat
+        uint32_t width;
+        uint32_t height;
+        uint32_t mipCount;
+        uint32_t nrChannels;    // Of the source image
+        uint32_t reserved;
+    };
+
+    struct CookedMipEntry {
+        uint64_t offset;        // From the start of the file
+        uint64_t size;
+    };
+
+    constexpr uint32_t COOKED_TEXTURE_VERSION = 1;
+
+    struct TextureCookSettings {
+        bool highQuality = false;   // BC7 instead of BC1/BC3 for color textures
+        bool force = false;         // Cook even when the cooked file is newer than the source
+    };
+
+    // Offline conversion of images into block compressed mip chains, loaded without decoding at runtime
+    class TextureCooker {
+        public:
+            static bool Cook(const Filesystem::Path& source, const Filesystem::Path& destination, const TextureCookSettings& settings = {});
+            static size_t CookDirectory(const Filesystem::Path& directory, const TextureCookSettings& settings = {});
+
+            static std::shared_ptr<TextureMipChain> Load(const Filesystem::Path& path);
+
+            static Filesystem::Path GetCookedPath(const Filesystem::Path& source);
+            static bool IsUpToDate(const Filesystem::Path& source);
+
+            static BlockCompression::BlockFormat ChooseFormat(const Filesystem::Path& source, const TextureData& data, bool highQuality);
+    };
+}
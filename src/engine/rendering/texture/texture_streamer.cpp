@@ -0,0 +1,276 @@
+#include "texture_streamer.hpp"
+
+#include "engine/rendering/texture/texture_cooker.hpp"
+#include "engine/core/jobs/job_system.hpp"
+#include "engine/debugging/debugger.hpp"
+
+#include <algorithm>
+#include <queue>
+#include <cmath>
+
+namespace Epoch::Engine::Rendering{
+
+    void TextureStreamer::Init(TextureStreamingSettings settings)
+    {
+        this->settings = settings;
+        entries.clear();
+        entryIndices.clear();
+        frame = 1;
+        residentBytes = 0;
+    }
+
+    void TextureStreamer::Shutdown()
+    {
+        entries.clear();
+        entryIndices.clear();
+        residentBytes = 0;
+    }
+
+    /// @brief Adds a texture whose mip chain was set, it starts at its tail and follows the requests from then on
+    void TextureStreamer::Register(const std::shared_ptr<Texture> &texture)
+    {
+        if (!texture || !texture->IsStreamed())
+            return;
+
+        Entry entry;
+        entry.texture = texture;
+        entry.tailMip = texture->GetResidentMip();
+        entry.desiredMip = texture->GetResidentMip();
+        entry.targetMip = texture->GetResidentMip();
+
+        // The address of a destroyed texture can be reused before the next Update
+        auto it = entryIndices.find(texture.get());
+        if (it != entryIndices.end()) {
+            // Reloaded texture, its chain and tail changed
+            if (!entries[it->second].texture.expired()) {
+                entry.lastRequestFrame = entries[it->second].lastRequestFrame;
+                entries[it->second] = entry;
+                return;
+            }
+            entries[it->second] = entry;
+        }
+        else {
+            entryIndices[texture.get()] = entries.size();
+            entries.push_back(entry);
+        }
+
+        residentBytes += texture->GetResidentBytes();
+    }
+
+    int TextureStreamer::GetTailMip(const TextureMipChain &chain) const
+    {
+        int mip = 0;
+        while (mip + 1 < static_cast<int>(chain.levels.size()) && std::max(chain.GetLevelWidth(mip), chain.GetLevelHeight(mip)) > settings.residentTailSize)
+            mip++;
+        return mip;
+    }
+
+    /// @brief Records that a texture covers about "screenPixels" pixels this frame
+    void TextureStreamer::RequestResolution(Texture *texture, float screenPixels)
+    {
+        auto it = entryIndices.find(texture);
+        if (it == entryIndices.end())
+            return;
+
+        Entry& entry = entries[it->second];
+        TextureInfos* infos = texture->GetInfos();
+
+        // One texel per pixel when the texture spans the projected bounds
+        float texels = static_cast<float>(std::max(infos->width, infos->height));
+        float mipFloat = std::log2(std::max(texels / std::max(screenPixels, 1.0f), 1.0f)) + settings.mipBias;
+        int mip = std::clamp(static_cast<int>(std::floor(mipFloat)), 0, texture->GetMipCount() - 1);
+
+        if (entry.lastRequestFrame != frame) {
+            entry.desiredMip = mip;
+            entry.lastRequestFrame = frame;
+        }
+        else {
+            entry.desiredMip = std::min(entry.desiredMip, mip);
+        }
+    }
+
+    /// @brief Applies the requests of the frame : evicts the mips nobody needs, fits the budget and uploads the missing levels
+    void TextureStreamer::Update()
+    {
+        if (!settings.enabled) {
+            frame++;
+            return;
+        }
+
+        // Forget the destroyed textures
+        for (size_t i = 0; i < entries.size();) {
+            if (entries[i].texture.expired()) {
+                entries[i] = entries.back();
+                entries.pop_back();
+            }
+            else {
+                i++;
+            }
+        }
+        entryIndices.clear();
+        for (size_t i = 0; i < entries.size(); i++)
+            entryIndices[entries[i].texture.lock().get()] = i;
+
+        // Targets from the requests, unused textures fall back to their tail
+        size_t targetBytes = 0;
+        std::vector<std::shared_ptr<Texture>> textures(entries.size());
+
+        for (size_t i = 0; i < entries.size(); i++) {
+            Entry& entry = entries[i];
+            textures[i] = entry.texture.lock();
+
+            bool unused = entry.lastRequestFrame == 0 || frame - entry.lastRequestFrame > static_cast<uint64_t>(settings.evictFrames);
+            entry.targetMip = unused ? entry.tailMip : std::min(entry.desiredMip, entry.tailMip);
+
+            for (int level = entry.targetMip; level < textures[i]->GetMipCount(); level++)
+                targetBytes += textures[i]->GetMipBytes(level);
+        }
+
+        // Over budget, drop the largest target levels first so every texture loses resolution evenly
+        if (targetBytes > settings.memoryBudget) {
+            auto larger = [&](size_t a, size_t b) {
+                return textures[a]->GetMipBytes(entries[a].targetMip) < textures[b]->GetMipBytes(entries[b].targetMip);
+            };
+            std::priority_queue<size_t, std::vector<size_t>, decltype(larger)> queue(larger);
+            for (size_t i = 0; i < entries.size(); i++)
+                if (entries[i].targetMip < entries[i].tailMip)
+                    queue.push(i);
+
+            while (targetBytes > settings.memoryBudget && !queue.empty()) {
+                size_t i = queue.top();
+                queue.pop();
+
+                targetBytes -= textures[i]->GetMipBytes(entries[i].targetMip);
+                entries[i].targetMip++;
+
+                if (entries[i].targetMip < entries[i].tailMip)
+                    queue.push(i);
+            }
+        }
+
+        // Evictions are free, do them all
+        for (size_t i = 0; i < entries.size(); i++) {
+            while (textures[i]->GetResidentMip() < entries[i].targetMip)
+                textures[i]->StreamOut();
+        }
+
+        // Uploads are limited per frame, the most blurry textures first
+        std::vector<size_t> pending;
+        for (size_t i = 0; i < entries.size(); i++)
+            if (textures[i]->GetResidentMip() > entries[i].targetMip && !entries[i].readFailed)
+                pending.push_back(i);
+
+        std::sort(pending.begin(), pending.end(), [&](size_t a, size_t b) {
+            return textures[a]->GetResidentMip() - entries[a].targetMip > textures[b]->GetResidentMip() - entries[b].targetMip;
+        });
+
+        size_t uploaded = 0;
+        bool progress = true;
+
+        // One level per texture and per round, so a single large texture can't starve the others
+        while (progress && uploaded < settings.uploadBytesPerFrame) {
+            progress = false;
+            for (size_t i : pending) {
+                if (textures[i]->GetResidentMip() <= entries[i].targetMip)
+                    continue;
+
+                // Released levels are read again first, the texture waits for them
+                if (!textures[i]->HasMipData(textures[i]->GetResidentMip() - 1)) {
+                    ReadMips(i);
+                    continue;
+                }
+
+                size_t bytes = textures[i]->GetMipBytes(textures[i]->GetResidentMip() - 1);
+                if (uploaded > 0 && uploaded + bytes > settings.uploadBytesPerFrame)
+                    continue;
+
+                textures[i]->StreamIn();
+                uploaded += bytes;
+                progress = true;
+            }
+        }
+
+        // Textures at their target only keep their tail in memory, the queued copies hold the rest until they are issued
+        for (size_t i = 0; i < entries.size(); i++)
+            if (textures[i]->GetResidentMip() == entries[i].targetMip)
+                textures[i]->ReleaseMipData(entries[i].tailMip);
+
+        residentBytes = 0;
+        for (const std::shared_ptr<Texture>& texture : textures)
+            residentBytes += texture->GetResidentBytes();
+
+        frame++;
+    }
+
+    /// @brief Reads the levels dropped by Texture::ReleaseMipData on a worker, they are put back on the main thread
+    void TextureStreamer::ReadMips(size_t index)
+    {
+        Entry& entry = entries[index];
+        if (entry.reading)
+            return;
+
+        std::shared_ptr<Texture> texture = entry.texture.lock();
+        if (!texture)
+            return;
+        entry.reading = true;
+
+        std::weak_ptr<Texture> weakTexture = texture;
+        Filesystem::Path source = *texture->GetInfos()->filepath;
+
+        auto read = [weakTexture, source]() {
+            std::shared_ptr<TextureMipChain> chain = ReadMipChain(source);
+
+            Core::Jobs::JobSystem::GetInstance().RunOnMainThread([weakTexture, source, chain]() {
+                std::shared_ptr<Texture> texture = weakTexture.lock();
+                if (!texture)
+                    return;
+
+                TextureStreamer& streamer = TextureStreamer::GetInstance();
+                auto it = streamer.entryIndices.find(texture.get());
+                Entry* entry = it != streamer.entryIndices.end() && streamer.entries[it->second].texture.lock() == texture ? &streamer.entries[it->second] : nullptr;
+                if (entry)
+                    entry->reading = false;
+
+                if (!chain) {
+                    if (entry)
+                        entry->readFailed = true;
+                    return;
+                }
+
+                // Hot reloaded meanwhile, its chain is complete
+                if (texture->HasMipData(0) || texture->RestoreMipData(chain))
+                    return;
+
+                DEBUG_WARNING("Streamed texture changed on disk, reloading it : " + source.full);
+                texture->Reload(chain, streamer.GetTailMip(*chain));
+                streamer.Register(texture);
+            });
+        };
+
+        Core::Jobs::JobSystem& jobs = Core::Jobs::JobSystem::GetInstance();
+        if (jobs.GetWorkerCount() > 0)
+            jobs.Schedule(std::move(read));
+        else
+            read();
+    }
+
+    /// @brief Reads the full chain of a texture, from its cooked file when it is up to date, without any GL call
+    /// @return The chain, or nullptr if the file is missing or can't be decoded
+    std::shared_ptr<TextureMipChain> TextureStreamer::ReadMipChain(const Filesystem::Path &source)
+    {
+        std::shared_ptr<TextureMipChain> chain;
+        if (TextureCooker::IsUpToDate(source))
+            chain = TextureCooker::Load(TextureCooker::GetCookedPath(source));
+
+        if (!chain) {
+            TextureData data;
+            if (Texture::Decode(source, data))
+                chain = Texture::BuildMipChain(data);
+        }
+
+        if (!chain)
+            DEBUG_ERROR("Couldn't read the mips of streamed texture : " + source.full);
+
+        return chain;
+    }
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "engine/rendering/texture/texture.hpp"
+
+#include <unordered_map>
+#include <vector>
+#include <memory>
+
+namespace Epoch::Engine::Rendering{
+
+    struct TextureStreamingSettings {
+        bool enabled = true;
+        size_t memoryBudget = 512ull * 1024 * 1024;     // Resident bytes of every streamed texture
+        size_t uploadBytesPerFrame = 8ull * 1024 * 1024;
+        int residentTailSize = 64;                      // Levels up to this size are uploaded on load and never evicted
+        int evictFrames = 120;                          // Frames without request before a texture drops back to its tail
+        float mipBias = -1.0f;                          // Negative is sharper, compensates for UVs tiling over the bounds
+    };
+
+    // Chooses the resident mip range of the streamed textures from the screen space demand of the draws.
+    // Only the tail stays in memory once a texture reached its target, finer levels are read again from the file when requested
+    class TextureStreamer{
+        public:
+            static TextureStreamer& GetInstance() {
+                static TextureStreamer instance;
+                return instance;
+            }
+
+            void Init(TextureStreamingSettings settings = {});
+            void Shutdown();
+
+            void Register(const std::shared_ptr<Texture>& texture);
+
+            /// @brief Returns the finest level of the tail, the part of the chain that always stays resident
+            int GetTailMip(const TextureMipChain& chain) const;
+
+            void RequestResolution(Texture* texture, float screenPixels);
+
+            void Update();
+
+            size_t GetResidentBytes() const { return residentBytes; }
+
+            const TextureStreamingSettings& GetSettings() const { return settings; }
+
+        private:
+            TextureStreamer() = default;
+            ~TextureStreamer() = default;
+            TextureStreamer(const TextureStreamer&) = delete;
+            TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+            struct Entry {
+                std::weak_ptr<Texture> texture;
+                int tailMip = 0;
+                int desiredMip = 0;
+                int targetMip = 0;
+                uint64_t lastRequestFrame = 0;
+                bool reading = false;       // Its dropped levels are being read again
+                bool readFailed = false;    // The file is gone, it stays at its resident levels
+            };
+
+            void ReadMips(size_t index);
+            static std::shared_ptr<TextureMipChain> ReadMipChain(const Filesystem::Path& source);
+
+            TextureStreamingSettings settings;
+            std::vector<Entry> entries;
+            std::unordered_map<Texture*, size_t> entryIndices;
+            uint64_t frame = 1;
+            size_t residentBytes = 0;
+    };
+}
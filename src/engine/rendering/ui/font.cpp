@@ -2,6 +2,7 @@
 
 #include "engine/filesystem/filesystem.hpp"
 #include "engine/debugging/debugger.hpp"
+#include "engine/rendering/upload/upload_queue.hpp"
 
 namespace Epoch::Engine::Rendering::UI{
 
@@ -56,9 +57,6 @@ namespace Epoch::Engine::Rendering::UI{
             // set size to load glyphs as
             FT_Set_Char_Size(face, 0, size * 64, 300, 300);
     
-            // disable byte-alignment restriction
-            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-    
             // load first 128 characters of ASCII set
             for (unsigned char c = 0; c < 128; c++)
             {
@@ -72,17 +70,21 @@ namespace Epoch::Engine::Rendering::UI{
                 unsigned int texture;
                 glGenTextures(1, &texture);
                 glBindTexture(GL_TEXTURE_2D, texture);
-                glTexImage2D(
-                    GL_TEXTURE_2D,
-                    0,
-                    GL_RED,
-                    face->glyph->bitmap.width,
-                    face->glyph->bitmap.rows,
-                    0,
-                    GL_RED,
-                    GL_UNSIGNED_BYTE,
-                    face->glyph->bitmap.buffer
-                );
+                // The bitmap is reused by the next glyph, the queue gets its own copy
+                FT_Bitmap& bitmap = face->glyph->bitmap;
+                auto pixels = std::make_shared<std::vector<unsigned char>>(bitmap.buffer, bitmap.buffer + static_cast<size_t>(bitmap.width) * bitmap.rows);
+
+                UploadRequest request;
+                request.target = UploadRequest::Target::Texture2D;
+                request.object = texture;
+                request.width = static_cast<int>(bitmap.width);
+                request.height = static_cast<int>(bitmap.rows);
+                request.format = GL_RED;
+                request.data = pixels->data();
+                request.size = pixels->size();
+                request.keepAlive = pixels;
+                UploadQueue::GetInstance().Submit(std::move(request));
+
                 // set texture options
                 glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
                 glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
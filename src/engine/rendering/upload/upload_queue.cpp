@@ -0,0 +1,529 @@
+#include "upload_queue.hpp"
+
+#include "engine/debugging/debugger.hpp"
+
+#include <cstring>
+#include <thread>
+#include <algorithm>
+
+#ifndef GL_MAP_PERSISTENT_BIT
+    #define GL_MAP_PERSISTENT_BIT 0x0040
+    #define GL_MAP_COHERENT_BIT 0x0080
+#endif
+
+namespace Epoch::Engine::Rendering{
+
+    // Keeps the staging offsets valid for glCopyBufferSubData and every pixel type
+    constexpr size_t STAGING_ALIGNMENT = 16;
+
+    // glad is generated for GL 4.3, glBufferStorage (GL 4.4, GL_ARB_buffer_storage) is loaded by hand
+    typedef void (APIENTRYP BufferStorageProc)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+
+    void UploadQueue::Init(UploadQueueSettings settings)
+    {
+        if (initialized)
+            return;
+
+        this->settings = settings;
+
+        glGenBuffers(1, &stagingBuffer);
+        glBindBuffer(GL_COPY_READ_BUFFER, stagingBuffer);
+
+        GLint major = 0, minor = 0;
+        glGetIntegerv(GL_MAJOR_VERSION, &major);
+        glGetIntegerv(GL_MINOR_VERSION, &minor);
+        bool hasStorage = major > 4 || (major == 4 && minor >= 4) || HasGLExtension("GL_ARB_buffer_storage");
+
+        BufferStorageProc bufferStorage = hasStorage ? reinterpret_cast<BufferStorageProc>(glfwGetProcAddress("glBufferStorage")) : nullptr;
+        if (bufferStorage) {
+            const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            bufferStorage(GL_COPY_READ_BUFFER, settings.stagingSize, nullptr, flags);
+            ring = static_cast<uint8_t*>(glMapBufferRange(GL_COPY_READ_BUFFER, 0, settings.stagingSize, flags));
+
+            // Immutable storage can't be respecified, start over with a mutable buffer
+            if (!ring) {
+                DEBUG_WARNING("Failed to map the staging ring persistently, sources will be copied on the GL thread");
+                glBindBuffer(GL_COPY_READ_BUFFER, 0);
+                glDeleteBuffers(1, &stagingBuffer);
+                glGenBuffers(1, &stagingBuffer);
+                glBindBuffer(GL_COPY_READ_BUFFER, stagingBuffer);
+            }
+        }
+
+        if (!ring)
+            glBufferData(GL_COPY_READ_BUFFER, settings.stagingSize, nullptr, GL_STREAM_DRAW);
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+        head = 0;
+        initialized = true;
+    }
+
+    void UploadQueue::Shutdown()
+    {
+        if (!initialized)
+            return;
+
+        // The workers may still be writing into the ring
+        for (Copy& copy : copies)
+            while (!copy.job.IsDone())
+                std::this_thread::yield();
+        copies.clear();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pending.clear();
+            incomplete.clear();
+
+            for (Region& region : regions)
+                if (region.fence)
+                    glDeleteSync(region.fence);
+            regions.clear();
+        }
+
+        if (ring) {
+            glBindBuffer(GL_COPY_READ_BUFFER, stagingBuffer);
+            glUnmapBuffer(GL_COPY_READ_BUFFER);
+            glBindBuffer(GL_COPY_READ_BUFFER, 0);
+            ring = nullptr;
+        }
+
+        glDeleteBuffers(1, &stagingBuffer);
+        stagingBuffer = 0;
+        initialized = false;
+    }
+
+    StagingAllocation UploadQueue::Reserve(size_t size)
+    {
+        StagingAllocation allocation;
+        if (!ring || size == 0 || size > settings.stagingSize)
+            return allocation;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        AllocateStaging(size, allocation);
+        return allocation;
+    }
+
+    void UploadQueue::Release(const StagingAllocation &allocation)
+    {
+        if (allocation.IsValid())
+            ReleaseRegion(allocation.id, nullptr);
+    }
+
+    uint64_t UploadQueue::Submit(UploadRequest request)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        uint64_t ticket = nextTicket++;
+        incomplete.insert(ticket);
+        pending.push_back(Pending{ std::move(request), ticket });
+        return ticket;
+    }
+
+    bool UploadQueue::IsComplete(uint64_t ticket)
+    {
+        if (ticket == 0)
+            return true;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        return incomplete.find(ticket) == incomplete.end();
+    }
+
+    void UploadQueue::CompleteTicket(uint64_t ticket)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        incomplete.erase(ticket);
+    }
+
+    void UploadQueue::Cancel(const void *owner)
+    {
+        if (!owner)
+            return;
+
+        std::vector<uint64_t> released;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (auto it = pending.begin(); it != pending.end();) {
+                if (it->request.owner != owner) {
+                    ++it;
+                    continue;
+                }
+
+                if (it->request.staging.IsValid())
+                    released.push_back(it->request.staging.id);
+                incomplete.erase(it->ticket);
+                it = pending.erase(it);
+            }
+        }
+
+        for (uint64_t id : released)
+            ReleaseRegion(id, nullptr);
+
+        // Staged copies keep their region until the worker writing it is done, see Process
+        for (Copy& copy : copies) {
+            if (copy.request.owner != owner)
+                continue;
+            copy.cancelled = true;
+            copy.request.onComplete = nullptr;
+            CompleteTicket(copy.ticket);
+        }
+    }
+
+    size_t UploadQueue::GetPendingBytes()
+    {
+        size_t bytes = 0;
+        for (const Copy& copy : copies)
+            bytes += copy.request.size;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const Pending& request : pending)
+            bytes += request.request.size - request.staged;
+        return bytes;
+    }
+
+    void UploadQueue::Update()
+    {
+        Process(false);
+    }
+
+    void UploadQueue::Flush()
+    {
+        bool empty = false;
+        while (!empty) {
+            Process(true);
+
+            // Completion callbacks can queue more copies
+            std::lock_guard<std::mutex> lock(mutex);
+            empty = pending.empty();
+        }
+    }
+
+    /// @brief Issues the copies whose source landed in the ring, then stages the next ones. Both textures and buffers keep their order.
+    /// With "flush", everything queued is staged and issued at once
+    void UploadQueue::Process(bool flush)
+    {
+        RetireStaging();
+
+        // Staged now, the workers copy them into the ring while the frame is drawn and they are issued on the next update
+        std::vector<Copy> staged;
+        Stage(staged, flush);
+        copies.insert(copies.end(), std::make_move_iterator(staged.begin()), std::make_move_iterator(staged.end()));
+
+        if (copies.empty())
+            return;
+
+        std::vector<Copy> waiting;
+        std::vector<std::function<void()>> callbacks;
+        bool texturesBlocked = false;
+        bool buffersBlocked = false;
+
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+        for (Copy& copy : copies) {
+            if (flush) {
+                while (!copy.job.IsDone())
+                    std::this_thread::yield();
+            }
+
+            if (copy.cancelled) {
+                if (!copy.job.IsDone()) {
+                    waiting.push_back(std::move(copy));
+                    continue;
+                }
+                if (copy.request.staging.IsValid())
+                    ReleaseRegion(copy.request.staging.id, nullptr);
+                continue;
+            }
+
+            bool& blocked = copy.request.target == UploadRequest::Target::Texture2D ? texturesBlocked : buffersBlocked;
+            if (blocked || !copy.job.IsDone()) {
+                blocked = true;
+                waiting.push_back(std::move(copy));
+                continue;
+            }
+
+            Issue(copy);
+
+            if (copy.last) {
+                CompleteTicket(copy.ticket);
+                if (copy.request.onComplete)
+                    callbacks.push_back(std::move(copy.request.onComplete));
+            }
+        }
+
+        copies = std::move(waiting);
+
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        for (std::function<void()>& callback : callbacks)
+            callback();
+    }
+
+    /// @brief Moves the queued requests that fit the frame budgets to "staged", with a ring region each.
+    /// Buffer copies larger than what is left of their budget are split, a texture level is staged whole
+    void UploadQueue::Stage(std::vector<Copy> &staged, bool flush)
+    {
+        size_t textureBytes = 0;
+        size_t bufferBytes = 0;
+        bool texturesBlocked = false;
+        bool buffersBlocked = false;
+
+        // Pieces of a buffer copy leave room for other copies in the ring
+        const size_t maxPiece = std::max(settings.stagingSize / 4, STAGING_ALIGNMENT);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            for (auto it = pending.begin(); it != pending.end();) {
+                UploadRequest& request = it->request;
+                bool isTexture = request.target == UploadRequest::Target::Texture2D;
+
+                // Written into the ring by a worker, only the copy is left
+                if (request.staging.IsValid()) {
+                    Copy copy;
+                    copy.request = std::move(request);
+                    copy.ticket = it->ticket;
+                    copy.copied = true;
+                    staged.push_back(std::move(copy));
+                    it = pending.erase(it);
+                    continue;
+                }
+
+                bool& blocked = isTexture ? texturesBlocked : buffersBlocked;
+                size_t& bytes = isTexture ? textureBytes : bufferBytes;
+                size_t budget = isTexture ? settings.textureBytesPerFrame : settings.bufferBytesPerFrame;
+
+                size_t piece = request.size - it->staged;
+                if (!isTexture && initialized) {
+                    // The first piece of the frame always goes, even with a budget of 0
+                    size_t left = budget > bytes ? budget - bytes : 0;
+                    piece = std::min(piece, maxPiece);
+                    if (!flush)
+                        piece = std::min(piece, bytes == 0 ? std::max(left, STAGING_ALIGNMENT) : left);
+                }
+
+                bool overBudget = isTexture ? bytes > 0 && bytes + piece > budget : piece == 0 && request.size > 0;
+                if (blocked || (!flush && overBudget)) {
+                    blocked = true;
+                    ++it;
+                    continue;
+                }
+
+                Copy copy;
+                copy.request.target = request.target;
+                copy.request.object = request.object;
+                copy.request.offset = request.offset + it->staged;
+                copy.request.level = request.level;
+                copy.request.width = request.width;
+                copy.request.height = request.height;
+                copy.request.format = request.format;
+                copy.request.compressed = request.compressed;
+                copy.request.data = static_cast<const uint8_t*>(request.data) + it->staged;
+                copy.request.size = piece;
+                copy.request.keepAlive = request.keepAlive;
+                copy.request.owner = request.owner;
+                copy.ticket = it->ticket;
+                copy.last = it->staged + piece == request.size;
+
+                // Sources larger than the ring, and copies that don't fit while flushing, are issued from the client memory
+                bool fits = initialized && piece > 0 && piece <= settings.stagingSize;
+                if (fits && !AllocateStaging(piece, copy.request.staging) && !flush) {
+                    blocked = true;
+                    ++it;
+                    continue;
+                }
+
+                bytes += piece;
+
+                if (copy.last) {
+                    copy.request.onComplete = std::move(request.onComplete);
+                    it = pending.erase(it);
+                }
+                else {
+                    it->staged += piece;
+                }
+
+                staged.push_back(std::move(copy));
+            }
+        }
+
+        if (!ring)
+            return;
+
+        // Flushing waits for the copies anyway, the GL thread does them itself
+        Core::Jobs::JobSystem& jobs = Core::Jobs::JobSystem::GetInstance();
+        bool copyHere = flush || jobs.GetWorkerCount() == 0;
+
+        for (Copy& copy : staged) {
+            if (copy.copied || !copy.request.staging.IsValid())
+                continue;
+
+            copy.copied = true;
+            void* destination = copy.request.staging.data;
+            const void* source = copy.request.data;
+            size_t size = copy.request.size;
+
+            if (copyHere) {
+                std::memcpy(destination, source, size);
+                continue;
+            }
+
+            std::shared_ptr<const void> keepAlive = copy.request.keepAlive;
+            copy.job = jobs.Schedule([destination, source, size, keepAlive]() {
+                std::memcpy(destination, source, size);
+            });
+        }
+    }
+
+    /// @brief Finds "size" contiguous free bytes in the ring, after the most recent region. The mutex must be held
+    bool UploadQueue::AllocateStaging(size_t size, StagingAllocation &allocation)
+    {
+        size_t alignedSize = (size + STAGING_ALIGNMENT - 1) / STAGING_ALIGNMENT * STAGING_ALIGNMENT;
+
+        if (regions.empty())
+            head = 0;
+
+        size_t tail = regions.empty() ? settings.stagingSize : regions.front().offset;
+        size_t offset = 0;
+
+        // The free space is [head, end) then [0, tail) when the ring wrapped, [head, tail) otherwise
+        if (regions.empty() || head > tail) {
+            if (head + alignedSize <= settings.stagingSize) {
+                offset = head;
+            }
+            else if (alignedSize < tail) {
+                offset = 0;
+            }
+            else {
+                return false;
+            }
+        }
+        else if (head + alignedSize < tail) {
+            offset = head;
+        }
+        else {
+            return false;
+        }
+
+        head = offset + alignedSize;
+        regions.push_back(Region{ nextRegion, offset, alignedSize });
+
+        allocation.data = ring ? ring + offset : nullptr;
+        allocation.offset = offset;
+        allocation.size = size;
+        allocation.id = nextRegion++;
+        return true;
+    }
+
+    /// @brief Frees the ring space of the copies the GPU finished and of the regions given back, oldest first
+    void UploadQueue::RetireStaging()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        while (!regions.empty()) {
+            Region& region = regions.front();
+
+            if (region.fence) {
+                GLenum result = glClientWaitSync(region.fence, 0, 0);
+                if (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED) {
+                    if (result == GL_WAIT_FAILED)
+                        DEBUG_ERROR("Failed to wait for an upload fence");
+                    return;
+                }
+                glDeleteSync(region.fence);
+            }
+            // Still being written, or waiting for its copy
+            else if (!region.released) {
+                return;
+            }
+
+            regions.pop_front();
+        }
+    }
+
+    /// @brief Marks a region as read by the copy guarded by "fence", or as unused when "fence" is null
+    void UploadQueue::ReleaseRegion(uint64_t id, GLsync fence)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        for (auto it = regions.rbegin(); it != regions.rend(); ++it) {
+            if (it->id != id)
+                continue;
+            it->fence = fence;
+            it->released = fence == nullptr;
+            return;
+        }
+
+        if (fence)
+            glDeleteSync(fence);
+    }
+
+    void UploadQueue::Issue(Copy &copy)
+    {
+        const UploadRequest& request = copy.request;
+
+        if (!request.staging.IsValid()) {
+            IssueDirect(request);
+            return;
+        }
+
+        const size_t stagingOffset = request.staging.offset;
+        glBindBuffer(GL_COPY_READ_BUFFER, stagingBuffer);
+
+        // Without a persistent mapping the ring is written here
+        if (!copy.copied) {
+            void* destination = glMapBufferRange(GL_COPY_READ_BUFFER, stagingOffset, request.size, GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+            if (!destination) {
+                DEBUG_WARNING("Failed to map the staging ring, uploading directly");
+                IssueDirect(request);
+                ReleaseRegion(request.staging.id, nullptr);
+                return;
+            }
+
+            std::memcpy(destination, request.data, request.size);
+            glUnmapBuffer(GL_COPY_READ_BUFFER);
+        }
+
+        if (request.target == UploadRequest::Target::Buffer) {
+            glBindBuffer(GL_COPY_WRITE_BUFFER, request.object);
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, stagingOffset, request.offset, request.size);
+        }
+        else {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, stagingBuffer);
+            glBindTexture(GL_TEXTURE_2D, request.object);
+
+            if (request.compressed)
+                glCompressedTexImage2D(GL_TEXTURE_2D, request.level, request.format, request.width, request.height, 0, static_cast<GLsizei>(request.size), (void*)stagingOffset);
+            else
+                glTexImage2D(GL_TEXTURE_2D, request.level, request.format, request.width, request.height, 0, request.format, GL_UNSIGNED_BYTE, (void*)stagingOffset);
+
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        }
+
+        ReleaseRegion(request.staging.id, glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+    }
+
+    /// @brief Synchronous copy from the client memory, for empty sources, sources larger than the ring or copies that can't wait
+    void UploadQueue::IssueDirect(const UploadRequest &request)
+    {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+        if (request.target == UploadRequest::Target::Buffer) {
+            if (request.size == 0)
+                return;
+            glBindBuffer(GL_COPY_WRITE_BUFFER, request.object);
+            glBufferSubData(GL_COPY_WRITE_BUFFER, request.offset, request.size, request.data);
+            return;
+        }
+
+        glBindTexture(GL_TEXTURE_2D, request.object);
+
+        if (request.compressed)
+            glCompressedTexImage2D(GL_TEXTURE_2D, request.level, request.format, request.width, request.height, 0, static_cast<GLsizei>(request.size), request.data);
+        else
+            glTexImage2D(GL_TEXTURE_2D, request.level, request.format, request.width, request.height, 0, request.format, GL_UNSIGNED_BYTE, request.data);
+    }
+}
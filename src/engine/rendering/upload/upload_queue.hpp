@@ -0,0 +1,159 @@
+#pragma once
+
+#include "engine/rendering/utils.hpp"
+#include "engine/core/jobs/job_system.hpp"
+
+#include <deque>
+#include <vector>
+#include <unordered_set>
+#include <memory>
+#include <mutex>
+#include <functional>
+#include <cstdint>
+
+namespace Epoch::Engine::Rendering{
+
+    struct UploadQueueSettings {
+        size_t stagingSize = 32ull * 1024 * 1024;       // Size of the staging ring
+        size_t textureBytesPerFrame = 16ull * 1024 * 1024;
+        size_t bufferBytesPerFrame = 16ull * 1024 * 1024;   // Larger buffer copies are split over several frames
+    };
+
+    // Region of the staging ring a thread writes a source into, see UploadQueue::Reserve
+    struct StagingAllocation {
+        void* data = nullptr;       // Persistently mapped, writable from any thread until the request is submitted
+        size_t offset = 0;          // In the ring
+        size_t size = 0;
+        uint64_t id = 0;
+
+        bool IsValid() const { return id != 0; }
+    };
+
+    // A copy into a GL buffer or a texture level, the source stays owned by "keepAlive" until it is copied into the ring
+    struct UploadRequest {
+        enum class Target {
+            Buffer,
+            Texture2D
+        };
+
+        Target target = Target::Buffer;
+        GLuint object = 0;              // Buffer or texture name
+        size_t offset = 0;              // Buffer : destination offset, in bytes
+        int level = 0;                  // Texture : mip level
+        int width = 0, height = 0;      // Texture : level size
+        GLenum format = 0;              // Texture : pixel format, or the internal format of a block compressed level
+        bool compressed = false;
+
+        const void* data = nullptr;
+        size_t size = 0;
+        std::shared_ptr<const void> keepAlive;
+        StagingAllocation staging;      // Set when the source was already written into the ring, "data" is ignored then
+
+        const void* owner = nullptr;            // Cancel(owner) drops the requests not issued yet
+        std::function<void()> onComplete;       // Called on the GL thread once the copy is issued
+    };
+
+    // Uploads through a staging ring, persistently mapped when the driver has GL_ARB_buffer_storage :
+    //  - Workers producing data reserve a region, write into it and submit the request, the GL thread only issues the copy.
+    //  - Owned sources are copied into the ring by the job system workers, under a per-frame byte budget for textures
+    //    and one for buffers (large buffers are split), then issued on the next update.
+    // Without persistent mapping, the ring is mapped unsynchronized on the GL thread for each copy and Reserve fails.
+    // Fences guard the regions the GPU still reads
+    class UploadQueue{
+        public:
+            static UploadQueue& GetInstance() {
+                static UploadQueue instance;
+                return instance;
+            }
+
+            void Init(UploadQueueSettings settings = {});
+            void Shutdown();
+
+            /// @brief Reserves a region of the ring to write a source into, can be called from any thread
+            /// @return An invalid allocation when the ring is full, not mapped or smaller than "size"
+            StagingAllocation Reserve(size_t size);
+
+            /// @brief Gives back a region that won't be submitted, can be called from any thread
+            void Release(const StagingAllocation& allocation);
+
+            /// @brief Queues a copy, can be called from any thread
+            /// @return A ticket for IsComplete
+            uint64_t Submit(UploadRequest request);
+
+            /// @brief Whether the copy of a ticket was issued (or cancelled), the draws issued from then on see the data
+            bool IsComplete(uint64_t ticket);
+
+            /// @brief Drops the requests of "owner" that were not issued yet, GL thread only
+            void Cancel(const void* owner);
+
+            /// @brief Issues the copies staged during the last frame and stages what fits the frame budgets, GL thread only
+            void Update();
+
+            /// @brief Issues every queued copy, waiting for the ring when needed, GL thread only
+            void Flush();
+
+            /// @brief Bytes queued or being copied into the ring, GL thread only
+            size_t GetPendingBytes();
+
+            bool IsPersistent() const { return ring != nullptr; }
+
+            const UploadQueueSettings& GetSettings() const { return settings; }
+
+        private:
+            UploadQueue() = default;
+            ~UploadQueue() = default;
+            UploadQueue(const UploadQueue&) = delete;
+            UploadQueue& operator=(const UploadQueue&) = delete;
+
+            struct Pending {
+                UploadRequest request;
+                uint64_t ticket = 0;
+                size_t staged = 0;          // Bytes of a split buffer copy already staged
+            };
+
+            // A request, or a piece of a buffer request, whose ring region is being written
+            struct Copy {
+                UploadRequest request;      // "offset", "data" and "size" describe the piece
+                uint64_t ticket = 0;
+                bool last = true;           // Last piece of its request, completes the ticket
+                bool cancelled = false;
+                bool copied = false;        // Without a mapped ring, "data" is copied into the ring when it is issued
+                Core::Jobs::JobHandle job;
+            };
+
+            struct Region {
+                uint64_t id;
+                size_t offset;
+                size_t size;
+                GLsync fence = nullptr;     // Set once the copy reading it is issued
+                bool released = false;      // Given back without a copy
+            };
+
+            void Process(bool flush);
+            void Stage(std::vector<Copy>& staged, bool flush);
+            bool AllocateStaging(size_t size, StagingAllocation& allocation);
+            void RetireStaging();
+            void ReleaseRegion(uint64_t id, GLsync fence);
+            void Issue(Copy& copy);
+            void IssueDirect(const UploadRequest& request);
+            void CompleteTicket(uint64_t ticket);
+
+            UploadQueueSettings settings;
+
+            std::mutex mutex;
+            std::deque<Pending> pending;
+            std::unordered_set<uint64_t> incomplete;
+            uint64_t nextTicket = 1;
+
+            // Ring state, shared with Reserve
+            std::deque<Region> regions;         // Oldest first
+            size_t head = 0;                    // Next free byte of the ring
+            uint64_t nextRegion = 1;
+
+            std::vector<Copy> copies;           // GL thread only, in staging order
+
+            GLuint stagingBuffer = 0;
+            uint8_t* ring = nullptr;            // Persistent mapping
+            bool initialized = false;
+    };
+}
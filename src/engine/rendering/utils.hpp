@@ -5,6 +5,20 @@
 
 #include "engine/ecs/components/core/transform.hpp"
 
+#include <cstring>
+
+// Extensions beyond the GL 4.3 core profile glad is generated for
+inline bool HasGLExtension(const char* name) {
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; i++) {
+        const char* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+        if (extension && std::strcmp(extension, name) == 0)
+            return true;
+    }
+    return false;
+}
+
 //3D
 struct Vertex {
     glm::vec3 position;
@@ -21,6 +35,20 @@ struct Vertex {
     }
 };
 
+// Quantized layout (20 bytes) : position relative to the mesh bounds (unorm16),
+// octahedral normal and tangent (snorm16), half float texCoord. Color is a per-mesh uniform.
+struct CompactVertex {
+    uint16_t position[4];
+    int16_t normal[2];
+    int16_t tangent[2];
+    uint16_t texCoord[2];
+};
+
+enum class VertexFormat {
+    Full,
+    Compact
+};
+
 namespace std {
     template <>
     struct hash<Vertex> {
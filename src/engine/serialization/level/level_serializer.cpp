@@ -12,14 +12,70 @@ using namespace nlohmann;
 
 namespace Epoch::Engine::Serialization{
     
+    /// @brief Instantiates one child actor per node of a multi-mesh model, keeping the scene hierarchy
+    /// @param materials The level material slots, indexed by the scene material of each submesh
+    void InstantiateModelAsset(std::shared_ptr<Rendering::ModelAsset> asset, std::shared_ptr<ECS::Objects::Actor> a, const std::vector<std::shared_ptr<Rendering::Material>>& materials, bool active){
+        std::vector<std::shared_ptr<ECS::Objects::Actor>> nodeActors;
+        nodeActors.reserve(asset->nodes.size());
+
+        for (const Rendering::ModelNode& node : asset->nodes)
+            nodeActors.push_back(std::make_shared<ECS::Objects::Actor>(node.name));
+
+        glm::mat4 root = a->transform->GetTransformMatrix();
+        Core::Resources::ResourcesManager& resources = Core::Resources::ResourcesManager::GetInstance();
+        Core::Resources::Handle<Rendering::Material> defaultMaterial = resources.GetHandle<Rendering::Material>("materials\\default");
+
+        for (size_t i = 0; i < asset->nodes.size(); i++) {
+            const Rendering::ModelNode& node = asset->nodes[i];
+            std::shared_ptr<ECS::Objects::Actor> nodeActor = nodeActors[i];
+
+            if (node.parent >= 0)
+                nodeActors[node.parent]->AddChild(nodeActor);
+            else
+                a->AddChild(nodeActor);
+
+            // Transforms are stored in world space
+            nodeActor->transform->SetFromTransformMatrix(root * asset->GetNodeTransform(static_cast<int>(i)));
+
+            if (node.mesh < 0)
+                continue;
+
+            std::shared_ptr<Rendering::Mesh> mesh = asset->meshes[node.mesh];
+
+            std::vector<std::shared_ptr<Rendering::Material>> meshMaterials;
+            for (int s = 0; s < mesh->SubMeshesCount(); s++) {
+                int slot = mesh->GetSubMeshMaterialSlot(s);
+                if (slot < static_cast<int>(materials.size()) && materials[slot])
+                    meshMaterials.push_back(materials[slot]);
+                else
+                    meshMaterials.push_back(resources.Get(defaultMaterial));
+            }
+
+            auto model = nodeActor->AddComponent<ECS::Components::Model>();
+            model->SetMesh(mesh);
+            model->SetMaterials(std::move(meshMaterials));
+
+            if(active)
+                model->Activate();
+            else
+                model->DeActivate();
+        }
+    }
+
     void LoadModelComponent(json &component, std::shared_ptr<ECS::Objects::Actor> a, json data){
+        using namespace Core::Literals;
+
+        Core::Resources::ResourcesManager& resources = Core::Resources::ResourcesManager::GetInstance();
         std::string mesh_name = component["mesh"];
+        std::shared_ptr<Rendering::ModelAsset> modelAsset = nullptr;
+
         if (data["meshes"].contains(mesh_name)) {
             const std::string& mesh_path = data["meshes"][mesh_name];
-            std::shared_ptr<Rendering::Mesh> mesh = Core::Resources::ResourcesManager::GetInstance().GetMesh(mesh_path);
+            Core::StringId meshId = Core::StringId::Intern(mesh_path);
+            std::shared_ptr<Rendering::Mesh> mesh = resources.Get<Rendering::Mesh>(meshId);
             if(mesh)
                 a->AddComponent<ECS::Components::Model>()->SetMesh(mesh);
-            else
+            else if(!(modelAsset = resources.Get<Rendering::ModelAsset>(meshId)))
                 DEBUG_ERROR("Failed to retrieve mesh : "+mesh_path);
         }
 
@@ -49,11 +105,11 @@ namespace Epoch::Engine::Serialization{
                 materialPath = "materials\\default";
             }
 
-            auto material = Core::Resources::ResourcesManager::GetInstance().GetMaterial(materialPath);
+            auto material = resources.Get<Rendering::Material>(Core::StringId::Intern(materialPath));
             if (!material) {
                 DEBUG_ERROR("Failed to load material at path: " + materialPath
                         + ". Using fallback.");
-                material = Core::Resources::ResourcesManager::GetInstance().GetMaterial("materials\\default");
+                material = resources.Get<Rendering::Material>("materials\\default"_sid);
 
                 if (!material) {
                     DEBUG_ERROR("Failed to load fallback material: materials\\default");
@@ -62,6 +118,11 @@ namespace Epoch::Engine::Serialization{
 
             materials[slot] = material;
         }
+
+        if (modelAsset) {
+            InstantiateModelAsset(modelAsset, a, materials, component["active"]);
+            return;
+        }
         
         auto model = a->GetComponent<ECS::Components::Model>();
 
@@ -1,6 +1,9 @@
 #include "engine/core/engine.hpp"
 #include "engine/serialization/level/level_serializer.hpp"
 #include "engine/core/resources/resources_manager.hpp"
+#include "engine/core/jobs/job_system.hpp"
+#include "engine/rendering/texture/texture_cooker.hpp"
+#include "engine/filesystem/archive_writer.hpp"
 #include "module_loader.hpp"
 
 using namespace Epoch::Engine;
@@ -12,6 +15,13 @@ using namespace Epoch::Launcher;
 
 
 Debugging::Level minDebugLevel = Debugging::Level::Log;
+bool cookTextures = false;
+TextureCookSettings cookSettings;
+std::string packDirectory;
+std::string packArchive;
+unsigned int packJobs = 0;
+uint32_t packAlignment = Filesystem::ARCHIVE_ALIGN_CACHE_LINE;
+bool benchmarkPaths = false;
 
 Core::EngineCreationSettings ComputeEngineSettings(int argc, char* argv[]) {
     Core::EngineCreationSettings settings;
@@ -35,6 +45,68 @@ Core::EngineCreationSettings ComputeEngineSettings(int argc, char* argv[]) {
         else if (strcmp(argv[i], "--root") == 0 && i + 1 < argc) {
             settings.rootPath = argv[++i];
         }
+        else if (strcmp(argv[i], "--multi-draw-indirect") == 0) {
+            settings.multiDrawIndirect = true;
+        }
+        else if (strcmp(argv[i], "--no-texture-streaming") == 0) {
+            settings.streamTextures = false;
+        }
+        else if (strcmp(argv[i], "--texture-budget") == 0 && i + 1 < argc) {
+            settings.textureBudgetMB = static_cast<size_t>(std::stoul(argv[++i]));
+        }
+        else if (strcmp(argv[i], "--upload-budget") == 0 && i + 1 < argc) {
+            settings.uploadBudgetMB = static_cast<size_t>(std::stoul(argv[++i]));
+        }
+        else if (strcmp(argv[i], "--cook-textures") == 0) {
+            cookTextures = true;
+        }
+        else if (strcmp(argv[i], "--cook-quality") == 0 && i + 1 < argc) {
+            cookSettings.highQuality = strcmp(argv[++i], "high") == 0;
+        }
+        else if (strcmp(argv[i], "--cook-force") == 0) {
+            cookSettings.force = true;
+        }
+        else if (strcmp(argv[i], "--pack") == 0 && i + 2 < argc) {
+            packDirectory = argv[++i];
+            packArchive = argv[++i];
+        }
+        else if (strcmp(argv[i], "--jobs") == 0 && i + 1 < argc) {
+            packJobs = static_cast<unsigned int>(std::stoi(argv[++i]));
+        }
+        else if (strcmp(argv[i], "--pack-alignment") == 0 && i + 1 < argc) {
+            std::string alignment = argv[++i];
+            packAlignment = alignment == "page" ? Filesystem::ARCHIVE_ALIGN_PAGE : static_cast<uint32_t>(std::stoul(alignment));
+        }
+        else if (strcmp(argv[i], "--bench-paths") == 0) {
+            benchmarkPaths = true;
+        }
+        else if (strcmp(argv[i], "--no-shader-cache") == 0) {
+            settings.shaderCacheDirectory = "";
+        }
+        else if (strcmp(argv[i], "--compact-meshes") == 0) {
+            settings.compactMeshes = true;
+        }
+        else if (strcmp(argv[i], "--mesh-memory") == 0 && i + 1 < argc) {
+            settings.meshMemoryMB = static_cast<size_t>(std::stoul(argv[++i]));
+        }
+        else if (strcmp(argv[i], "--texture-memory") == 0 && i + 1 < argc) {
+            settings.textureMemoryMB = static_cast<size_t>(std::stoul(argv[++i]));
+        }
+        else if (strcmp(argv[i], "--hot-reload") == 0) {
+            settings.hotReload = true;
+        }
+        else if (strcmp(argv[i], "--lazy-loading") == 0) {
+            settings.lazyLoading = true;
+        }
+        else if (strcmp(argv[i], "--preload") == 0 && i + 1 < argc) {
+            settings.preloadLevels.push_back(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--serial-import") == 0) {
+            settings.parallelImport = false;
+        }
+        else if (strcmp(argv[i], "--workers") == 0 && i + 1 < argc) {
+            settings.workerThreads = static_cast<unsigned int>(std::stoi(argv[++i]));
+        }
         else if (strcmp(argv[i], "--gravity") == 0 && i + 3 < argc) {
             float x = std::stof(argv[++i]);
             float y = std::stof(argv[++i]);
@@ -62,10 +134,75 @@ Core::EngineCreationSettings ComputeEngineSettings(int argc, char* argv[]) {
     return settings;
 }
 
+// Cost of building a Path and reading its type for every resource file, against the canonicalizing construction it replaced
+void BenchmarkPaths() {
+    std::vector<std::string> raw;
+    for (const char* directory : { "engine_resources", "project_resources" }) {
+        std::error_code error;
+        for (auto it = std::filesystem::recursive_directory_iterator(directory, error); !error && it != std::filesystem::recursive_directory_iterator(); it.increment(error))
+            raw.push_back("./" + it->path().string());
+    }
+    if (raw.empty()) {
+        std::cerr << "No resources to benchmark paths on\n";
+        return;
+    }
+
+    auto measure = [&raw](const char* label, auto&& construct) {
+        const int rounds = 5;
+        size_t checksum = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int round = 0; round < rounds; round++)
+            for (const std::string& path : raw)
+                checksum += construct(path);
+        double nanoseconds = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        std::cout << label << " : " << static_cast<int>(nanoseconds / (rounds * raw.size())) << " ns per path (" << checksum << ")\n";
+    };
+
+    std::cout << raw.size() << " resource paths\n";
+    measure("weakly_canonical + extension", [](const std::string& path) {
+        std::filesystem::path canonical = std::filesystem::weakly_canonical(path);
+        return static_cast<size_t>(std::filesystem::weakly_canonical(std::filesystem::absolute(canonical)).extension().string().size());
+    });
+    measure("Path + GetExtensionType", [](const std::string& path) {
+        return static_cast<size_t>(Filesystem::Path(path).GetExtensionType());
+    });
+}
+
 int main(int argc, char *argv[]) {
 
     Core::EngineCreationSettings engineSettings = ComputeEngineSettings(argc, argv);
 
+    // Offline texture cooking, no window nor engine needed
+    if (cookTextures) {
+        Filesystem::FileManager::Init(engineSettings.rootPath);
+        Core::Jobs::JobSystem::GetInstance().Init(engineSettings.workerThreads);
+        TextureCooker::CookDirectory(Filesystem::Path("engine_resources"), cookSettings);
+        TextureCooker::CookDirectory(Filesystem::Path("project_resources"), cookSettings);
+        Core::Jobs::JobSystem::GetInstance().Shutdown();
+        return 0;
+    }
+
+    if (benchmarkPaths) {
+        BenchmarkPaths();
+        return 0;
+    }
+
+    // Offline packing of a directory into a .caf archive, "--jobs" files compressed at once
+    if (!packArchive.empty()) {
+        Filesystem::FileManager::Init(engineSettings.rootPath);
+        Core::Jobs::JobSystem::GetInstance().Init(packJobs > 0 ? packJobs : engineSettings.workerThreads);
+
+        Filesystem::ArchiveWriter writer;
+        writer.SetJobs(packJobs);
+        writer.SetAlignment(packAlignment);
+        writer.SetVerbose(minDebugLevel == Debugging::Level::Log);
+        writer.AddDirectory(Filesystem::Path(packDirectory));
+        bool packed = writer.Write(Filesystem::Path(packArchive).full);
+
+        Core::Jobs::JobSystem::GetInstance().Shutdown();
+        return packed ? 0 : 1;
+    }
+
     ModuleLoader::GetInstance().LoadGameModule(
         #if defined(_WIN32)
                 "libGameModule.dll"